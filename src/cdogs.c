@@ -58,12 +58,15 @@
 #endif
 
 #include <cdogs/ammo.h>
+#include <cdogs/automap.h>
 #include <cdogs/campaigns.h>
 #include <cdogs/character_class.h>
 #include <cdogs/collision.h>
 #include <cdogs/config_io.h>
+#include <cdogs/draw/actor_pic_cache.h>
 #include <cdogs/draw/char_sprites.h>
 #include <cdogs/draw/draw.h>
+#include <cdogs/draw/render_jobs.h>
 #include <cdogs/files.h>
 #include <cdogs/font_utils.h>
 #include <cdogs/grafx.h>
@@ -72,6 +75,7 @@
 #include <cdogs/joystick.h>
 #include <cdogs/keyboard.h>
 #include <cdogs/log.h>
+#include <cdogs/mem_track.h>
 #include <cdogs/mission.h>
 #include <cdogs/music.h>
 #include <cdogs/net_client.h>
@@ -85,6 +89,7 @@
 #include <cdogs/player_template.h>
 #include <cdogs/sounds.h>
 #include <cdogs/SDL_JoystickButtonNames/SDL_joystickbuttonnames.h>
+#include <cdogs/startup.h>
 #include <cdogs/triggers.h>
 #include <cdogs/utils.h>
 
@@ -126,6 +131,58 @@ void MainLoop(credits_displayer_t *creditsDisplayer, custom_campaigns_t *campaig
 	NetServerTerminate(&gNetServer);
 }
 
+// Startup tasks that can run alongside the graphics and data loading
+static void LoadSound(void *data)
+{
+	UNUSED(data);
+	int phase = StartupPhaseBegin(&gStartup, "sound");
+	SoundInitialize(&gSoundDevice, "sounds");
+	if (!gSoundDevice.isInitialised)
+	{
+		LOG(LM_MAIN, LL_ERROR, "Sound initialization failed!");
+	}
+	StartupPhaseEnd(&gStartup, phase);
+
+	phase = StartupPhaseBegin(&gStartup, "songs");
+	debug(D_NORMAL, "Loading song lists...\n");
+	LoadSongs();
+	StartupPhaseEnd(&gStartup, phase);
+}
+static void LoadCampaigns(void *data)
+{
+	const int phase = StartupPhaseBegin(&gStartup, "campaigns");
+	LoadAllCampaigns(data);
+	StartupPhaseEnd(&gStartup, phase);
+}
+// Game data; needs pics and sounds
+static void LoadData(void)
+{
+	int phase = StartupPhaseBegin(&gStartup, "particles");
+	ParticleClassesInit(&gParticleClasses, "data/particles.json");
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "ammo");
+	AmmoInitialize(&gAmmo, "data/ammo.json");
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "bullets and guns");
+	BulletAndWeaponInitialize(
+		&gBulletClasses, &gGunDescriptions,
+		"data/bullets.json", "data/guns.json");
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "character classes");
+	CharacterClassesInitialize(&gCharacterClasses, "data/character_classes.json");
+	LoadPlayerTemplates(
+		&gPlayerTemplates, &gCharacterClasses, PLAYER_TEMPLATE_FILE);
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "pickups");
+	PickupClassesInit(
+		&gPickupClasses, "data/pickups.json", &gAmmo, &gGunDescriptions);
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "map objects");
+	MapObjectsInit(
+		&gMapObjects, "data/map_objects.json", &gAmmo, &gGunDescriptions);
+	StartupPhaseEnd(&gStartup, phase);
+}
+
 int main(int argc, char *argv[])
 {
 	credits_displayer_t creditsDisplayer;
@@ -136,7 +193,12 @@ int main(int argc, char *argv[])
 	const char *loadCampaign = NULL;
 	ENetAddress connectAddr;
 	memset(&connectAddr, 0, sizeof connectAddr);
+	StartupTask soundTask;
+	memset(&soundTask, 0, sizeof soundTask);
+	StartupTask campaignsTask;
+	memset(&campaignsTask, 0, sizeof campaignsTask);
 
+	StartupInit(&gStartup);
 	srand((unsigned int)time(NULL));
 	LogInit();
 
@@ -152,6 +214,7 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	int phase = StartupPhaseBegin(&gStartup, "config");
 	SetupConfigDir();
 	gConfig = ConfigLoad(GetConfigFilePath(CONFIG_FILE));
 	// Set config options that are only set via command line
@@ -161,6 +224,7 @@ int main(int argc, char *argv[])
 	LoadCredits(&creditsDisplayer, colorPurple, colorDarker);
 	AutosaveInit(&gAutosave);
 	AutosaveLoad(&gAutosave, GetConfigFilePath(AUTOSAVE_FILE));
+	StartupPhaseEnd(&gStartup, phase);
 
 	if (enet_initialize() != 0)
 	{
@@ -180,6 +244,7 @@ int main(int argc, char *argv[])
 	}
 
 	debug(D_NORMAL, "Initialising SDL...\n");
+	phase = StartupPhaseBegin(&gStartup, "sdl");
 	const int sdlFlags =
 		SDL_INIT_TIMER | SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_HAPTIC |
 		SDL_INIT_GAMECONTROLLER;
@@ -197,27 +262,25 @@ int main(int argc, char *argv[])
 		goto bail;
 	}
 	SDL_EventState(SDL_DROPFILE, SDL_DISABLE);
+	StartupPhaseEnd(&gStartup, phase);
 
 	GetDataFilePath(buf, "");
 	LOG(LM_MAIN, LL_INFO, "data dir(%s)", buf);
 	LOG(LM_MAIN, LL_INFO, "config dir(%s)", GetConfigFilePath(""));
 
-	SoundInitialize(&gSoundDevice, "sounds");
-	if (!gSoundDevice.isInitialised)
-	{
-		LOG(LM_MAIN, LL_ERROR, "Sound initialization failed!");
-	}
+	// Sounds and the campaign list aren't needed until the game data is
+	// loaded and the menu shown respectively
+	StartupTaskStart(&gStartup, &soundTask, "sound", LoadSound, NULL);
+	StartupTaskStart(
+		&gStartup, &campaignsTask, "campaigns", LoadCampaigns, &campaigns);
 
 	LoadHighScores();
 
-	debug(D_NORMAL, "Loading song lists...\n");
-	LoadSongs();
-
-	MusicPlayMenu(&gSoundDevice);
-
+	phase = StartupPhaseBegin(&gStartup, "graphics");
 	EventInit(&gEventHandlers, NULL, NULL, true);
 	NetServerInit(&gNetServer);
 	PicManagerInit(&gPicManager);
+	ActorPicCacheInit(&gActorPicCache, ACTOR_PIC_CACHE_MAX_BYTES);
 	GraphicsInit(&gGraphicsDevice, &gConfig);
 	GraphicsInitialize(&gGraphicsDevice);
 	if (!gGraphicsDevice.IsInitialized)
@@ -233,26 +296,26 @@ int main(int argc, char *argv[])
 		err = EXIT_FAILURE;
 		goto bail;
 	}
+	RenderJobsInit(ConfigGetInt(&gConfig, "Graphics.RenderThreads"));
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "font");
 	FontLoadFromJSON(&gFont, "graphics/font.png", "graphics/font.json");
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "pics");
 	PicManagerLoad(&gPicManager, "graphics");
+	StartupPhaseEnd(&gStartup, phase);
+	phase = StartupPhaseBegin(&gStartup, "char sprites");
 	CharSpriteClassesInit(&gCharSpriteClasses);
+	StartupPhaseEnd(&gStartup, phase);
 
-	ParticleClassesInit(&gParticleClasses, "data/particles.json");
-	AmmoInitialize(&gAmmo, "data/ammo.json");
-	BulletAndWeaponInitialize(
-		&gBulletClasses, &gGunDescriptions,
-		"data/bullets.json", "data/guns.json");
-	CharacterClassesInitialize(&gCharacterClasses, "data/character_classes.json");
-	LoadPlayerTemplates(
-		&gPlayerTemplates, &gCharacterClasses, PLAYER_TEMPLATE_FILE);
-	PickupClassesInit(
-		&gPickupClasses, "data/pickups.json", &gAmmo, &gGunDescriptions);
-	MapObjectsInit(
-		&gMapObjects, "data/map_objects.json", &gAmmo, &gGunDescriptions);
+	StartupTaskWait(&soundTask);
+	MusicPlayMenu(&gSoundDevice);
+	LoadData();
 	CollisionSystemInit(&gCollisionSystem);
 	CampaignInit(&gCampaign);
-	LoadAllCampaigns(&campaigns);
 	PlayerDataInit(&gPlayerDatas);
+	StartupTaskWait(&campaignsTask);
+	StartupReport(&gStartup);
 
 	debug(D_NORMAL, ">> Entering main loop\n");
 	// Attempt to pre-load campaign if requested
@@ -285,6 +348,8 @@ int main(int argc, char *argv[])
 
 bail:
 	debug(D_NORMAL, ">> Shutting down...\n");
+	StartupTaskWait(&soundTask);
+	StartupTaskWait(&campaignsTask);
 	MapTerminate(&gMap);
 	PlayerDataTerminate(&gPlayerDatas);
 	MapObjectsTerminate(&gMapObjects);
@@ -298,10 +363,13 @@ bail:
 	NetClientTerminate(&gNetClient);
 	atexit(enet_deinitialize);
 	EventTerminate(&gEventHandlers);
+	RenderJobsTerminate();
 	GraphicsTerminate(&gGraphicsDevice);
 	CampaignTerminate(&gCampaign);
 
 	CharSpriteClassesTerminate(&gCharSpriteClasses);
+	ActorPicCacheTerminate(&gActorPicCache);
+	AutomapTerminate();
 	PicManagerTerminate(&gPicManager);
 	FontTerminate(&gFont);
 	AutosaveSave(&gAutosave, GetConfigFilePath(AUTOSAVE_FILE));
@@ -314,6 +382,10 @@ bail:
 	UnloadAllCampaigns(&campaigns);
 	SoundTerminate(&gSoundDevice, true);
 	ConfigDestroy(&gConfig);
+	// Anything still live here has leaked
+	MemTrackDump("shutdown");
+	MemTrackTerminate();
+	StartupTerminate(&gStartup);
 	LogTerminate();
 
 	SDLJBN_Quit();
@@ -587,7 +587,8 @@ void ActorReplaceGun(const NActorReplaceGun rg)
 		memcpy(CArrayGet(&a->guns, rg.GunIdx), &w, a->guns.elemSize);
 	}
 
-	SoundPlayAt(&gSoundDevice, gun->SwitchSound, Vec2iFull2Real(a->Pos));
+	SoundPlayAt(
+		&gSoundDevice, StrSound(gun->SwitchSound), Vec2iFull2Real(a->Pos));
 }
 static bool ActorHasGun(const TActor *a, const GunDescription *gun)
 {
@@ -1315,7 +1316,7 @@ void ActorSwitchGun(const NActorSwitchGun sg)
 	a->gunIndex = sg.GunIdx;
 	SoundPlayAt(
 		&gSoundDevice,
-		ActorGetGun(a)->Gun->SwitchSound,
+		StrSound(ActorGetGun(a)->Gun->SwitchSound),
 		Vec2iNew(a->tileItem.x, a->tileItem.y));
 }
 
@@ -622,7 +622,7 @@ static void FindObjectivesSortedByDistance(
 		// Check if the pickup is actually accessible
 		// This is because random spawning may cause some pickups to be spawned
 		// in inaccessible areas
-		if (MapGetTile(&gMap, Vec2iToTile(co.Pos))->flags & MAPTILE_NO_WALK)
+		if (MapPlaneGet(&gMap, MAP_PLANE_NO_WALK, Vec2iToTile(co.Pos)))
 		{
 			continue;
 		}
@@ -294,17 +294,15 @@ static bool IsPosNoWalkAroundObjects(void *data, Vec2i pos)
 }
 static bool IsTileWalkableOrOpenable(Map *map, Vec2i pos)
 {
-	const Tile *tile = MapGetTile(map, pos);
-	if (tile == NULL)
+	if (!MapIsTileIn(map, pos))
 	{
 		return false;
 	}
-	const int tileFlags = tile->flags;
-	if (!(tileFlags & MAPTILE_NO_WALK))
+	if (!MapPlaneGet(map, MAP_PLANE_NO_WALK, pos))
 	{
 		return true;
 	}
-	if (tileFlags & MAPTILE_OFFSET_PIC)
+	if (MapGetTile(map, pos)->flags & MAPTILE_OFFSET_PIC)
 	{
 		// A door; check if we can open it
 		int keycard = MapGetDoorKeycardFlag(map, pos);
@@ -355,7 +353,7 @@ bool AIHasClearShot(const Vec2i from, const Vec2i to)
 }
 static bool IsPosNoSee(void *data, Vec2i pos)
 {
-	return MapGetTile(data, Vec2iToTile(pos))->flags & MAPTILE_NO_SEE;
+	return MapPlaneGet(data, MAP_PLANE_NO_SEE, Vec2iToTile(pos));
 }
 
 TObject *AIGetObjectRunningInto(TActor *a, int cmd)
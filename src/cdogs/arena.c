@@ -0,0 +1,134 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "arena.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+// Alignment suitable for any of the game's structs
+#define ARENA_ALIGN (2 * sizeof(void *))
+#define ARENA_ALIGN_UP(_x) (((_x) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define CHUNK_HEADER_SIZE ARENA_ALIGN_UP(sizeof(ArenaChunk))
+#define CHUNK_DATA(_c) ((char *)(_c) + CHUNK_HEADER_SIZE)
+
+
+void ArenaInit(Arena *a, const size_t chunkSize)
+{
+	memset(a, 0, sizeof *a);
+	a->chunkSize = chunkSize;
+}
+void ArenaTerminate(Arena *a)
+{
+	ArenaChunk *c = a->chunks;
+	while (c != NULL)
+	{
+		ArenaChunk *next = c->next;
+		CFREE(c);
+		c = next;
+	}
+	ArenaInit(a, a->chunkSize);
+}
+
+static ArenaChunk *NewChunk(Arena *a, const size_t size)
+{
+	ArenaChunk *c;
+	CMALLOC(c, CHUNK_HEADER_SIZE + size);
+	c->next = NULL;
+	c->size = size;
+	c->used = 0;
+	a->capacity += size;
+	a->numChunks++;
+	return c;
+}
+void *ArenaAlloc(Arena *a, const size_t size)
+{
+	const size_t alignedSize = ARENA_ALIGN_UP(size);
+	ArenaChunk *c = a->chunks;
+	if (alignedSize > a->chunkSize / 4)
+	{
+		// Large blocks get their own chunk, placed behind the head so the
+		// head's free space is still used
+		c = NewChunk(a, alignedSize);
+		if (a->chunks == NULL)
+		{
+			a->chunks = c;
+		}
+		else
+		{
+			c->next = a->chunks->next;
+			a->chunks->next = c;
+		}
+	}
+	else if (c == NULL || c->size - c->used < alignedSize)
+	{
+		// Remainder of the old head is lost to fragmentation
+		if (c != NULL)
+		{
+			a->wasted += c->size - c->used;
+		}
+		c = NewChunk(a, a->chunkSize);
+		c->next = a->chunks;
+		a->chunks = c;
+	}
+	void *p = CHUNK_DATA(c) + c->used;
+	c->used += alignedSize;
+	a->used += alignedSize;
+	a->numAllocs++;
+	memset(p, 0, size);
+	return p;
+}
+void *ArenaRealloc(
+	Arena *a, void *p, const size_t oldSize, const size_t newSize)
+{
+	if (p == NULL)
+	{
+		return ArenaAlloc(a, newSize);
+	}
+	const size_t oldAligned = ARENA_ALIGN_UP(oldSize);
+	const size_t newAligned = ARENA_ALIGN_UP(newSize);
+	if (newAligned <= oldAligned)
+	{
+		return p;
+	}
+	// Grow in place if this is the most recent block in the head chunk
+	ArenaChunk *c = a->chunks;
+	if (c != NULL && (char *)p + oldAligned == CHUNK_DATA(c) + c->used &&
+		c->used - oldAligned + newAligned <= c->size)
+	{
+		memset((char *)p + oldSize, 0, newSize - oldSize);
+		c->used += newAligned - oldAligned;
+		a->used += newAligned - oldAligned;
+		return p;
+	}
+	void *newP = ArenaAlloc(a, newSize);
+	memcpy(newP, p, oldSize);
+	a->wasted += oldAligned;
+	return newP;
+}
@@ -0,0 +1,64 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator for data that shares a lifetime, e.g. everything belonging
+// to the current mission's map. Individual allocations are never freed;
+// the whole arena is released at once.
+typedef struct ArenaChunk
+{
+	struct ArenaChunk *next;
+	size_t size;
+	size_t used;
+} ArenaChunk;
+typedef struct Arena
+{
+	ArenaChunk *chunks;	// head is the chunk currently being filled
+	size_t chunkSize;
+	// Stats
+	size_t used;		// bytes handed out, including alignment padding
+	size_t capacity;	// bytes reserved in chunks
+	size_t wasted;		// bytes abandoned by blocks that were regrown
+	int numAllocs;
+	int numChunks;
+} Arena;
+
+#define ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+void ArenaInit(Arena *a, const size_t chunkSize);
+void ArenaTerminate(Arena *a);
+// Returns zeroed memory
+void *ArenaAlloc(Arena *a, const size_t size);
+// Grows a block; in place if it was the last allocation made, otherwise
+// the old block is abandoned until the arena is released
+void *ArenaRealloc(
+	Arena *a, void *p, const size_t oldSize, const size_t newSize);
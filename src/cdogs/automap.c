@@ -52,6 +52,7 @@
 #include <string.h>
 
 #include "actors.h"
+#include "blit.h"
 #include "config.h"
 #include "draw/draw.h"
 #include "draw/draw_actor.h"
@@ -198,53 +199,176 @@ void DrawDot(TTileItem *t, color_t color, Vec2i pos, int scale)
 	Draw_Rect(pos.x, pos.y, scale, scale, color);
 }
 
+// Colours of the map, one pixel per tile and 0 for none, so that the map
+// is drawn without going through every tile. The colours of a chunk are
+// refreshed when the map marks its tiles as changed, e.g. by doors opening
+// or tiles being set, and its explored colours when tiles are visited.
+typedef struct
+{
+	int MapLoadId;
+	Vec2i Size;
+	Vec2i ChunksSize;
+	int *Versions;
+	int *VisitVersions;
+	Uint32 *All;
+	Uint32 *Explored;
+} AutomapCache;
+static AutomapCache sCache;
+
+void AutomapTerminate(void)
+{
+	CFREE(sCache.Versions);
+	CFREE(sCache.VisitVersions);
+	CFREE(sCache.All);
+	CFREE(sCache.Explored);
+	memset(&sCache, 0, sizeof sCache);
+}
+
+static Uint32 TileColorPixel(Map *map, const Vec2i pos)
+{
+	const Tile *tile = MapGetTile(map, pos);
+	if (tile->flags & MAPTILE_IS_NOTHING)
+	{
+		return 0;
+	}
+	color_t color = colorRoom;
+	if (tile->flags & MAPTILE_IS_WALL)
+	{
+		color = colorWall;
+	}
+	else if (tile->flags & MAPTILE_NO_WALK)
+	{
+		color = DoorColor(pos.x, pos.y);
+	}
+	else if (tile->flags & MAPTILE_IS_NORMAL_FLOOR)
+	{
+		color = colorFloor;
+	}
+	return ColorEquals(color, colorBlack) ? 0 : COLOR2PIXEL(color);
+}
+static void UpdateChunk(
+	Map *map, const Vec2i chunk, const bool changed, const bool explored)
+{
+	Vec2i v;
+	for (v.y = chunk.y * MAP_CHUNK_SIZE;
+		v.y < MIN((chunk.y + 1) * MAP_CHUNK_SIZE, sCache.Size.y);
+		v.y++)
+	{
+		for (v.x = chunk.x * MAP_CHUNK_SIZE;
+			v.x < MIN((chunk.x + 1) * MAP_CHUNK_SIZE, sCache.Size.x);
+			v.x++)
+		{
+			const int idx = v.y * sCache.Size.x + v.x;
+			if (changed)
+			{
+				sCache.All[idx] = TileColorPixel(map, v);
+			}
+			if (changed || explored)
+			{
+				sCache.Explored[idx] =
+					MapGetTile(map, v)->isVisited ? sCache.All[idx] : 0;
+			}
+		}
+	}
+}
+static void UpdateCache(Map *map)
+{
+	if (sCache.MapLoadId != map->LoadId)
+	{
+		// New map; start over with every chunk stale
+		AutomapTerminate();
+		sCache.MapLoadId = map->LoadId;
+		sCache.Size = map->Size;
+		sCache.ChunksSize = map->ChunksSize;
+		const int numChunks = map->ChunksSize.x * map->ChunksSize.y;
+		CMALLOC(sCache.Versions, numChunks * sizeof *sCache.Versions);
+		CMALLOC(
+			sCache.VisitVersions, numChunks * sizeof *sCache.VisitVersions);
+		for (int i = 0; i < numChunks; i++)
+		{
+			sCache.Versions[i] = sCache.VisitVersions[i] = -1;
+		}
+		const int numTiles = map->Size.x * map->Size.y;
+		CMALLOC(sCache.All, numTiles * sizeof *sCache.All);
+		CMALLOC(sCache.Explored, numTiles * sizeof *sCache.Explored);
+	}
+	Vec2i chunk;
+	for (chunk.y = 0; chunk.y < sCache.ChunksSize.y; chunk.y++)
+	{
+		for (chunk.x = 0; chunk.x < sCache.ChunksSize.x; chunk.x++)
+		{
+			const int idx = chunk.y * sCache.ChunksSize.x + chunk.x;
+			const bool changed =
+				sCache.Versions[idx] != map->ChunkVersions[idx];
+			const bool explored =
+				sCache.VisitVersions[idx] != map->ChunkVisitVersions[idx];
+			if (changed || explored)
+			{
+				UpdateChunk(map, chunk, changed, explored);
+				sCache.Versions[idx] = map->ChunkVersions[idx];
+				sCache.VisitVersions[idx] = map->ChunkVisitVersions[idx];
+			}
+		}
+	}
+}
+
+static int FloorDiv(const int a, const int b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+// Range of tiles, drawn at mapPos, that overlap the clipping region
+static void GetVisibleTiles(
+	const Map *map, const Vec2i mapPos, const int scale, const int margin,
+	Vec2i *start, Vec2i *end)
+{
+	const BlitClipping *clip = &gGraphicsDevice.clipping;
+	start->x = MAX(FloorDiv(clip->left - mapPos.x, scale) - margin, 0);
+	start->y = MAX(FloorDiv(clip->top - mapPos.y, scale) - margin, 0);
+	end->x = MIN(
+		FloorDiv(clip->right - mapPos.x, scale) + margin + 1, map->Size.x);
+	end->y = MIN(
+		FloorDiv(clip->bottom - mapPos.y, scale) + margin + 1, map->Size.y);
+}
+
 static void DrawMap(
 	Map *map,
 	Vec2i center, Vec2i centerOn, Vec2i size,
 	int scale, int flags)
 {
-	int x, y;
-	Vec2i mapPos = Vec2iAdd(center, Vec2iScale(centerOn, -scale));
-	for (y = 0; y < gMap.Size.y; y++)
+	UpdateCache(map);
+	const Uint32 *pixels =
+		(flags & AUTOMAP_FLAGS_SHOWALL) ? sCache.All : sCache.Explored;
+	const Vec2i mapPos = Vec2iAdd(center, Vec2iScale(centerOn, -scale));
+	Vec2i start, end;
+	GetVisibleTiles(map, mapPos, scale, 0, &start, &end);
+	const BlitClipping *clip = &gGraphicsDevice.clipping;
+	const int xMin = MAX(mapPos.x + start.x * scale, clip->left);
+	const int xMax = MIN(mapPos.x + end.x * scale - 1, clip->right);
+	const int yMin = MAX(mapPos.y + start.y * scale, clip->top);
+	const int yMax = MIN(mapPos.y + end.y * scale - 1, clip->bottom);
+	// Scale up the clipped region of the cached colours
+	for (int y = yMin; y <= yMax; y++)
 	{
-		int i;
-		for (i = 0; i < scale; i++)
+		const Uint32 *src = pixels + (y - mapPos.y) / scale * sCache.Size.x;
+		Uint32 *dst = gGraphicsDevice.buf +
+			y * gGraphicsDevice.cachedConfig.Res.x;
+		for (int x = xMin; x <= xMax; x++)
 		{
-			for (x = 0; x < gMap.Size.x; x++)
+			const Uint32 p = src[(x - mapPos.x) / scale];
+			if (p == 0)
+			{
+				continue;
+			}
+			if (flags & AUTOMAP_FLAGS_MASK)
 			{
-				Tile *tile = MapGetTile(map, Vec2iNew(x, y));
-				if (!(tile->flags & MAPTILE_IS_NOTHING) &&
-					(tile->isVisited || (flags & AUTOMAP_FLAGS_SHOWALL)))
-				{
-					int j;
-					for (j = 0; j < scale; j++)
-					{
-						Vec2i drawPos = Vec2iNew(
-							mapPos.x + x*scale + j,
-							mapPos.y + y*scale + i);
-						color_t color = colorRoom;
-						if (tile->flags & MAPTILE_IS_WALL)
-						{
-							color = colorWall;
-						}
-						else if (tile->flags & MAPTILE_NO_WALK)
-						{
-							color = DoorColor(x, y);
-						}
-						else if (tile->flags & MAPTILE_IS_NORMAL_FLOOR)
-						{
-							color = colorFloor;
-						}
-						if (!ColorEquals(color, colorBlack))
-						{
-							if (flags & AUTOMAP_FLAGS_MASK)
-							{
-								color.a = MASK_ALPHA;
-							}
-							Draw_Point(drawPos.x, drawPos.y, color);
-						}
-					}
-				}
+				color_t color = PIXEL2COLOR(p);
+				color.a = MASK_ALPHA;
+				dst[x] = COLOR2PIXEL(
+					ColorAlphaBlend(PIXEL2COLOR(dst[x]), color));
+			}
+			else
+			{
+				dst[x] = p;
 			}
 		}
 	}
@@ -263,9 +387,12 @@ static void DrawTileItem(
 	TTileItem *t, Tile *tile, Vec2i pos, int scale, int flags);
 static void DrawObjectivesAndKeys(Map *map, Vec2i pos, int scale, int flags)
 {
-	for (int y = 0; y < map->Size.y; y++)
+	// Markers can stick out of their tile by a pixel
+	Vec2i start, end;
+	GetVisibleTiles(map, pos, scale, 1, &start, &end);
+	for (int y = start.y; y < end.y; y++)
 	{
-		for (int x = 0; x < map->Size.x; x++)
+		for (int x = start.x; x < end.x; x++)
 		{
 			Tile *tile = MapGetTile(map, Vec2iNew(x, y));
 			CA_FOREACH(ThingId, tid, tile->things)
@@ -332,13 +459,8 @@ void AutomapDraw(int flags, bool showExit)
 	Vec2i pos = Vec2iAdd(mapCenter, Vec2iScale(centerOn, -MAP_FACTOR));
 
 	// Draw faded green overlay
-	for (int y = 0; y < gGraphicsDevice.cachedConfig.Res.y; y++)
-	{
-		for (int x = 0; x < gGraphicsDevice.cachedConfig.Res.x; x++)
-		{
-			DrawPointMask(&gGraphicsDevice, Vec2iNew(x, y), mask);
-		}
-	}
+	BlitMaskRect(
+		&gGraphicsDevice, Vec2iZero(), gGraphicsDevice.cachedConfig.Res, mask);
 
 	DrawMap(&gMap, mapCenter, centerOn, gMap.Size, MAP_FACTOR, flags);
 	DrawObjectivesAndKeys(&gMap, pos, MAP_FACTOR, flags);
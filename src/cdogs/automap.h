@@ -36,6 +36,8 @@
 #define AUTOMAP_FLAGS_MASK 0x02
 
 void AutomapDraw(int flags, bool showExit);
+// Free the cached map colours
+void AutomapTerminate(void);
 void AutomapDrawRegion(
 	Map *map,
 	Vec2i pos, Vec2i size, Vec2i mapCenter,
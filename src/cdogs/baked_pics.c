@@ -0,0 +1,414 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "baked_pics.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "cpic.h"
+#include "grafx.h"
+#include "log.h"
+#include "pic.h"
+#include "sys_config.h"
+#include "utils.h"
+
+// File layout, in native byte order:
+// - magic, version, screen format
+// - number of source files, then for each: path, mtime, size
+// - number of pics, then for each: name, pic
+// - number of sprites, then for each: name, number of pics, pics
+// Strings are a length and the bytes including the terminator.
+// Pics are their size, offset and number of spans (-1 if not built),
+// then their pixels, span rows and spans, each aligned so that they can be
+// used in place.
+#define BAKED_PICS_MAGIC "CDOGSPIC"
+// Increase whenever the layout, or how the images are converted, changes
+#define BAKED_PICS_VERSION 1
+#define BAKED_PICS_ALIGN 8
+
+
+static void *ReadAligned(DataReader *r, const Uint64 size)
+{
+	const size_t pos =
+		(r->Pos + BAKED_PICS_ALIGN - 1) / BAKED_PICS_ALIGN * BAKED_PICS_ALIGN;
+	if (pos > r->Size || size > r->Size - pos)
+	{
+		return NULL;
+	}
+	r->Pos = pos + (size_t)size;
+	return r->Data + pos;
+}
+static const char *ReadString(DataReader *r)
+{
+	Uint32 len;
+	if (!DataReaderRead(r, &len, sizeof len) || len == 0 ||
+		len > r->Size - r->Pos || r->Data[r->Pos + len - 1] != '\0')
+	{
+		return NULL;
+	}
+	const char *s = (const char *)r->Data + r->Pos;
+	r->Pos += len;
+	return s;
+}
+static bool SpansAreValid(const Pic *p, const int spansCount);
+static bool ReadPic(DataReader *r, Pic *p)
+{
+	Sint32 header[5];
+	if (!DataReaderRead(r, header, sizeof header))
+	{
+		return false;
+	}
+	const Sint32 spansCount = header[4];
+	if (header[0] < 0 || header[1] < 0 || spansCount < -1)
+	{
+		return false;
+	}
+	p->size = Vec2iNew(header[0], header[1]);
+	p->offset = Vec2iNew(header[2], header[3]);
+	p->Data = ReadAligned(
+		r, (Uint64)p->size.x * p->size.y * sizeof *p->Data);
+	p->SpanRows = NULL;
+	p->Spans = NULL;
+	if (p->Data == NULL)
+	{
+		return false;
+	}
+	if (spansCount >= 0)
+	{
+		p->SpanRows = ReadAligned(
+			r, (Uint64)(p->size.y + 1) * sizeof *p->SpanRows);
+		p->Spans = ReadAligned(
+			r, (Uint64)MAX(spansCount, 1) * sizeof *p->Spans);
+		if (p->SpanRows == NULL || p->Spans == NULL ||
+			!SpansAreValid(p, spansCount))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+// The blitters trust the spans, so check that every row's runs are in the
+// table and every run is inside its row
+static bool SpansAreValid(const Pic *p, const int spansCount)
+{
+	if (p->SpanRows[0] != 0 || p->SpanRows[p->size.y] != spansCount)
+	{
+		return false;
+	}
+	for (int y = 0; y < p->size.y; y++)
+	{
+		if (p->SpanRows[y + 1] < p->SpanRows[y])
+		{
+			return false;
+		}
+	}
+	for (int i = 0; i < spansCount; i++)
+	{
+		const PicSpan *s = &p->Spans[i];
+		if (s->Start + s->Len > p->size.x)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void GetFormat(Uint32 *format);
+static Sint64 GetSourceStat(const char *path, Sint64 *size);
+// Read the whole file, checking that it is valid and up to date.
+// Only add the pics to the maps if they are given, so that a file that is
+// corrupt part way through can be rejected before anything is added.
+static bool ReadPics(
+	const BakedPics *b, const CArray *sources, map_t pics, map_t sprites)
+{
+	DataReader r = { b->File.Data, b->File.Size, 0 };
+	char magic[sizeof BAKED_PICS_MAGIC - 1];
+	Uint32 version;
+	Uint32 format[4];
+	Uint32 expectedFormat[4];
+	GetFormat(expectedFormat);
+	if (!DataReaderRead(&r, magic, sizeof magic) ||
+		memcmp(magic, BAKED_PICS_MAGIC, sizeof magic) != 0 ||
+		!DataReaderRead(&r, &version, sizeof version) ||
+		version != BAKED_PICS_VERSION ||
+		!DataReaderRead(&r, format, sizeof format) ||
+		memcmp(format, expectedFormat, sizeof format) != 0)
+	{
+		return false;
+	}
+
+	Uint32 count;
+	if (!DataReaderRead(&r, &count, sizeof count) || count != sources->size)
+	{
+		return false;
+	}
+	// Only check the sources on the first pass
+	for (int i = 0; i < (int)sources->size; i++)
+	{
+		const char *path = ReadString(&r);
+		Sint64 srcStat[2];
+		if (path == NULL || !DataReaderRead(&r, srcStat, sizeof srcStat))
+		{
+			return false;
+		}
+		if (pics != NULL)
+		{
+			continue;
+		}
+		const char *source = *(char **)CArrayGet(sources, i);
+		Sint64 size;
+		const Sint64 mtime = GetSourceStat(source, &size);
+		if (strcmp(path, source) != 0 ||
+			srcStat[0] != mtime || srcStat[1] != size)
+		{
+			return false;
+		}
+	}
+
+	if (!DataReaderRead(&r, &count, sizeof count))
+	{
+		return false;
+	}
+	for (int i = 0; i < (int)count; i++)
+	{
+		const char *name = ReadString(&r);
+		Pic p;
+		if (name == NULL || !ReadPic(&r, &p))
+		{
+			return false;
+		}
+		if (pics != NULL)
+		{
+			NamedPic *np;
+			CMALLOC(np, sizeof *np);
+			CSTRDUP(np->name, name);
+			np->pic = p;
+			if (hashmap_put(pics, name, np) != MAP_OK)
+			{
+				LOG(LM_MAIN, LL_ERROR, "failed to add named pic %s", name);
+				NamedPicFree(np);
+				CFREE(np);
+			}
+		}
+	}
+
+	if (!DataReaderRead(&r, &count, sizeof count))
+	{
+		return false;
+	}
+	for (int i = 0; i < (int)count; i++)
+	{
+		const char *name = ReadString(&r);
+		Uint32 picsCount;
+		if (name == NULL || !DataReaderRead(&r, &picsCount, sizeof picsCount))
+		{
+			return false;
+		}
+		NamedSprites *ns = NULL;
+		if (sprites != NULL)
+		{
+			CMALLOC(ns, sizeof *ns);
+			NamedSpritesInit(ns, name);
+		}
+		for (int j = 0; j < (int)picsCount; j++)
+		{
+			Pic p;
+			if (!ReadPic(&r, &p))
+			{
+				return false;
+			}
+			if (ns != NULL)
+			{
+				CArrayPushBack(&ns->pics, &p);
+			}
+		}
+		if (ns != NULL && hashmap_put(sprites, name, ns) != MAP_OK)
+		{
+			LOG(LM_MAIN, LL_ERROR, "failed to add named sprites %s", name);
+			NamedSpritesFree(ns);
+			CFREE(ns);
+		}
+	}
+	return r.Pos == r.Size;
+}
+bool BakedPicsLoad(
+	BakedPics *b, const char *filename, const CArray *sources,
+	map_t pics, map_t sprites)
+{
+	memset(b, 0, sizeof *b);
+	// Private and writable, so that the pics can be changed in place like
+	// any other
+	if (!FileDataLoad(&b->File, filename, true))
+	{
+		return false;
+	}
+	if (!ReadPics(b, sources, NULL, NULL))
+	{
+		LOG(LM_MAIN, LL_INFO, "baked pics %s are out of date", filename);
+		BakedPicsTerminate(b);
+		return false;
+	}
+	PicSetSharedMemory(b->File.Data, b->File.Size);
+	ReadPics(b, sources, pics, sprites);
+	return true;
+}
+static void GetFormat(Uint32 *format)
+{
+	const SDL_PixelFormat *f = gGraphicsDevice.Format;
+	format[0] = f->Rmask;
+	format[1] = f->Gmask;
+	format[2] = f->Bmask;
+	// The alpha mask may be unset; pics use the alpha shift
+	format[3] = f->Ashift;
+}
+// Returns the modification time, or -1 if the file can't be found
+static Sint64 GetSourceStat(const char *path, Sint64 *size)
+{
+	struct stat st;
+	if (stat(path, &st) != 0)
+	{
+		*size = -1;
+		return -1;
+	}
+	*size = (Sint64)st.st_size;
+	return (Sint64)st.st_mtime;
+}
+
+
+typedef struct
+{
+	FILE *F;
+	size_t Pos;
+	bool Ok;
+} Writer;
+static void WriteBytes(Writer *w, const void *data, const size_t size)
+{
+	if (size > 0 && fwrite(data, size, 1, w->F) != 1)
+	{
+		w->Ok = false;
+	}
+	w->Pos += size;
+}
+static void WriteAligned(Writer *w, const void *data, const size_t size)
+{
+	static const Uint8 padding[BAKED_PICS_ALIGN];
+	WriteBytes(
+		w, padding,
+		(BAKED_PICS_ALIGN - w->Pos % BAKED_PICS_ALIGN) % BAKED_PICS_ALIGN);
+	WriteBytes(w, data, size);
+}
+static void WriteString(Writer *w, const char *s)
+{
+	const Uint32 len = (Uint32)strlen(s) + 1;
+	WriteBytes(w, &len, sizeof len);
+	WriteBytes(w, s, len);
+}
+static void WritePic(Writer *w, const Pic *p)
+{
+	const Sint32 spansCount =
+		p->Spans != NULL ? p->SpanRows[p->size.y] : -1;
+	const Sint32 header[5] =
+	{
+		p->size.x, p->size.y, p->offset.x, p->offset.y, spansCount
+	};
+	WriteBytes(w, header, sizeof header);
+	WriteAligned(w, p->Data, p->size.x * p->size.y * sizeof *p->Data);
+	if (spansCount >= 0)
+	{
+		WriteAligned(w, p->SpanRows, (p->size.y + 1) * sizeof *p->SpanRows);
+		WriteAligned(w, p->Spans, MAX(spansCount, 1) * sizeof *p->Spans);
+	}
+}
+static int WriteNamedPic(any_t data, any_t item)
+{
+	const NamedPic *np = item;
+	WriteString(data, np->name);
+	WritePic(data, &np->pic);
+	return MAP_OK;
+}
+static int WriteNamedSprites(any_t data, any_t item)
+{
+	const NamedSprites *ns = item;
+	WriteString(data, ns->name);
+	const Uint32 count = (Uint32)ns->pics.size;
+	WriteBytes(data, &count, sizeof count);
+	CA_FOREACH(const Pic, p, ns->pics)
+		WritePic(data, p);
+	CA_FOREACH_END()
+	return MAP_OK;
+}
+void BakedPicsSave(
+	const char *filename, const CArray *sources, map_t pics, map_t sprites)
+{
+	Writer w = { FileReplaceOpen(filename, "wb"), 0, true };
+	if (w.F == NULL)
+	{
+		LOG(LM_MAIN, LL_WARN, "cannot save baked pics %s", filename);
+		return;
+	}
+
+	WriteBytes(&w, BAKED_PICS_MAGIC, sizeof BAKED_PICS_MAGIC - 1);
+	const Uint32 version = BAKED_PICS_VERSION;
+	WriteBytes(&w, &version, sizeof version);
+	Uint32 format[4];
+	GetFormat(format);
+	WriteBytes(&w, format, sizeof format);
+
+	Uint32 count = (Uint32)sources->size;
+	WriteBytes(&w, &count, sizeof count);
+	CA_FOREACH(const char *, source, *sources)
+		WriteString(&w, *source);
+		Sint64 srcStat[2];
+		srcStat[0] = GetSourceStat(*source, &srcStat[1]);
+		WriteBytes(&w, srcStat, sizeof srcStat);
+	CA_FOREACH_END()
+
+	count = (Uint32)hashmap_length(pics);
+	WriteBytes(&w, &count, sizeof count);
+	hashmap_iterate(pics, WriteNamedPic, &w);
+	count = (Uint32)hashmap_length(sprites);
+	WriteBytes(&w, &count, sizeof count);
+	hashmap_iterate(sprites, WriteNamedSprites, &w);
+
+	if (!FileReplaceClose(w.F, filename, w.Ok))
+	{
+		LOG(LM_MAIN, LL_WARN, "cannot save baked pics %s", filename);
+	}
+}
+
+void BakedPicsTerminate(BakedPics *b)
+{
+	if (b->File.Data == NULL)
+	{
+		return;
+	}
+	PicSetSharedMemory(NULL, 0);
+	FileDataTerminate(&b->File);
+}
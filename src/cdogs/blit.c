@@ -56,6 +56,7 @@
 
 #include <SDL.h>
 
+#include "blit_kernels.h"
 #include "config.h"
 #include "log.h"
 
@@ -76,35 +77,103 @@ color_t *CharColorGetByType(CharColors *c, const CharColorType t)
 }
 
 
-void BlitPicHighlight(
-	GraphicsDevice *g, const Pic *pic, const Vec2i pos, const color_t color)
+// Visible part of a pic drawn at pos (offset already applied), clipped once
+// up front so the row loops don't need to
+typedef struct
+{
+	Vec2i Src;	// first visible pixel of the pic
+	Vec2i Dst;	// screen position of that pixel
+	Vec2i Size;	// visible size
+} BlitClip;
+static bool BlitClipPic(
+	const GraphicsDevice *g, const Vec2i picSize, const Vec2i pos,
+	BlitClip *c)
 {
-	// Draw highlight around the picture
-	int i;
-	for (i = -1; i < pic->size.y + 1; i++)
+	const int x0 = MAX(pos.x, g->clipping.left);
+	const int y0 = MAX(pos.y, g->clipping.top);
+	const int x1 = MIN(pos.x + picSize.x - 1, g->clipping.right);
+	const int y1 = MIN(pos.y + picSize.y - 1, g->clipping.bottom);
+	if (x0 > x1 || y0 > y1)
 	{
-		int j;
-		int yoff = i + pos.y + pic->offset.y;
-		if (yoff > g->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < g->clipping.top)
+		return false;
+	}
+	c->Src = Vec2iNew(x0 - pos.x, y0 - pos.y);
+	c->Dst = Vec2iNew(x0, y0);
+	c->Size = Vec2iNew(x1 - x0 + 1, y1 - y0 + 1);
+	return true;
+}
+
+// Call f on the visible part of each row; if skipEmpty, only on the runs
+// of non-empty pixels, using the pic's precomputed runs if it has them
+typedef void (*BlitRunFunc)(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data);
+static void BlitRuns(
+	const GraphicsDevice *g, const Pic *pic, const BlitClip *c,
+	const bool skipEmpty, BlitRunFunc f, const void *data)
+{
+	const int x1 = c->Src.x + c->Size.x;
+	const Uint32 *src = pic->Data + c->Src.y * pic->size.x;
+	Uint32 *dst = g->buf + c->Dst.y * g->cachedConfig.Res.x + c->Dst.x;
+	for (int y = c->Src.y; y < c->Src.y + c->Size.y; y++)
+	{
+		if (!skipEmpty)
 		{
-			continue;
+			f(dst, src + c->Src.x, c->Size.x, data);
 		}
-		yoff *= g->cachedConfig.Res.x;
-		for (j = -1; j < pic->size.x + 1; j++)
+		else if (pic->Spans != NULL)
 		{
-			int xoff = j + pos.x + pic->offset.x;
-			if (xoff < g->clipping.left)
+			const PicSpan *span = pic->Spans + pic->SpanRows[y];
+			const PicSpan *end = pic->Spans + pic->SpanRows[y + 1];
+			for (; span < end && span->Start < x1; span++)
 			{
-				continue;
+				const int start = MAX((int)span->Start, c->Src.x);
+				const int stop = MIN(span->Start + span->Len, x1);
+				if (start < stop)
+				{
+					f(dst + start - c->Src.x, src + start, stop - start, data);
+				}
 			}
-			if (xoff > g->clipping.right)
+		}
+		else
+		{
+			for (int x = c->Src.x; x < x1; x++)
 			{
-				break;
+				if (src[x] == 0)
+				{
+					continue;
+				}
+				const int start = x;
+				while (x < x1 && src[x] != 0)
+				{
+					x++;
+				}
+				f(dst + start - c->Src.x, src + start, x - start, data);
 			}
+		}
+		src += pic->size.x;
+		dst += g->cachedConfig.Res.x;
+	}
+}
+
+void BlitPicHighlight(
+	GraphicsDevice *g, const Pic *pic, const Vec2i pos, const color_t color)
+{
+	// Draw highlight around the picture, including a 1px border
+	BlitClip c;
+	if (!BlitClipPic(
+		g, Vec2iAdd(pic->size, Vec2iNew(2, 2)),
+		Vec2iAdd(Vec2iAdd(pos, pic->offset), Vec2iNew(-1, -1)), &c))
+	{
+		return;
+	}
+	for (int y = 0; y < c.Size.y; y++)
+	{
+		const int i = c.Src.y + y - 1;
+		Uint32 *target =
+			g->buf + (c.Dst.y + y) * g->cachedConfig.Res.x + c.Dst.x;
+		for (int x = 0; x < c.Size.x; x++, target++)
+		{
+			const int j = c.Src.x + x - 1;
 			// Draw highlight if current pixel is empty,
 			// and is next to a picture edge
 			bool isTopOrBottomEdge = i == -1 || i == pic->size.y;
@@ -115,7 +184,6 @@ void BlitPicHighlight(
 			if (isPixelEmpty &&
 				PicPxIsEdge(pic, Vec2iNew(j, i), !isPixelEmpty))
 			{
-				Uint32 *target = g->buf + yoff + xoff;
 				const color_t targetColor = PIXEL2COLOR(*target);
 				const color_t blendedColor = ColorAlphaBlend(
 					targetColor, color);
@@ -125,101 +193,50 @@ void BlitPicHighlight(
 	}
 }
 
+static void RunBackground(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data)
+{
+	const HSV *tint = data;
+	if (tint == NULL)
+	{
+		memcpy(dst, src, n * sizeof *dst);
+		return;
+	}
+	for (int i = 0; i < n; i++)
+	{
+		const color_t targetColor = PIXEL2COLOR(dst[i]);
+		const color_t blendedColor = ColorTint(targetColor, *tint);
+		dst[i] = COLOR2PIXEL(blendedColor);
+	}
+}
 void BlitBackground(
 	GraphicsDevice *device,
 	const Pic *pic, Vec2i pos, const HSV *tint, const bool isTransparent)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitClip c;
+	if (!BlitClipPic(device, pic->size, Vec2iAdd(pos, pic->offset), &c))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if ((isTransparent && *current) ||  !isTransparent)
-			{
-				Uint32 *target = gGraphicsDevice.buf + yoff + xoff;
-				if (tint != NULL)
-				{
-					const color_t targetColor = PIXEL2COLOR(*target);
-					const color_t blendedColor = ColorTint(targetColor, *tint);
-					*target = COLOR2PIXEL(blendedColor);
-				}
-				else
-				{
-					*target = *current;
-				}
-			}
-			current++;
-		}
+		return;
 	}
+	BlitRuns(device, pic, &c, isTransparent, RunBackground, tint);
 }
 
+static void RunCopyKeyed(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data)
+{
+	gBlitKernels.CopyKeyed(dst, src, n, *(const Uint32 *)data);
+}
 void Blit(GraphicsDevice *device, const Pic *pic, Vec2i pos)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitClip c;
+	if (!BlitClipPic(device, pic->size, Vec2iAdd(pos, pic->offset), &c))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if ((*current & device->Format->Amask) == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = *current;
-			current++;
-		}
+		return;
 	}
+	BlitRuns(device, pic, &c, true, RunCopyKeyed, &device->Format->Amask);
 }
 
-static Uint32 PixelMult(Uint32 p, Uint32 m)
+Uint32 PixelMult(const Uint32 p, const Uint32 m)
 {
 	return
 		((p & 0xFF) * (m & 0xFF) / 0xFF) |
@@ -227,6 +244,19 @@ static Uint32 PixelMult(Uint32 p, Uint32 m)
 		((((p & 0xFF0000) >> 16) * ((m & 0xFF0000) >> 16) / 0xFF) << 16) |
 		((((p & 0xFF000000) >> 24) * ((m & 0xFF000000) >> 24) / 0xFF) << 24);
 }
+typedef struct
+{
+	Uint32 Mask;
+	Uint32 Amask;
+	int Ashift;
+	int MinAlpha;
+} RunMultData;
+static void RunMult(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data)
+{
+	const RunMultData *d = data;
+	gBlitKernels.Mult(dst, src, n, d->Mask, d->Amask, d->Ashift, d->MinAlpha);
+}
 void BlitMasked(
 	GraphicsDevice *device,
 	const Pic *pic,
@@ -234,105 +264,65 @@ void BlitMasked(
 	color_t mask,
 	int isTransparent)
 {
-	Uint32 *current = pic->Data;
-	if (current == NULL)
+	if (pic->Data == NULL)
 	{
 		CASSERT(false, "unexpected NULL pic data");
 		return;
 	}
-	const Uint32 maskPixel = COLOR2PIXEL(mask);
-	int i;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (i = 0; i < pic->size.y; i++)
+	BlitClip c;
+	if (!BlitClipPic(device, pic->size, Vec2iAdd(pos, pic->offset), &c))
 	{
-		int yoff = i + pos.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			Uint32 *target;
-			int xoff = j + pos.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (isTransparent &&
-				((*current & device->Format->Amask) >> device->Format->Ashift) < 3)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			*target = PixelMult(*current, maskPixel);
-			*target |= device->Format->Amask;
-			current++;
-		}
+		return;
 	}
+	RunMultData d;
+	d.Mask = COLOR2PIXEL(mask);
+	d.Amask = device->Format->Amask;
+	d.Ashift = device->Format->Ashift;
+	d.MinAlpha = isTransparent ? 3 : 0;
+	// Opaque blits also overwrite empty pixels, so they need whole rows
+	BlitRuns(device, pic, &c, isTransparent, RunMult, &d);
 }
 static color_t CharColorsGetChannelMask(
 	const CharColors *c, const uint8_t alpha);
+typedef struct
+{
+	const CharColors *Masks;
+	// Channel masks for alphas 250-255
+	Uint32 ChannelMasks[6];
+} RunMultichannelData;
+static void RunMultichannel(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data)
+{
+	const RunMultichannelData *d = data;
+	for (int i = 0; i < n; i++)
+	{
+		const uint8_t alpha = PIXEL2COLOR(src[i]).a;
+		const Uint32 channelMask = alpha >= 250 ?
+			d->ChannelMasks[alpha - 250] :
+			COLOR2PIXEL(CharColorsGetChannelMask(d->Masks, alpha));
+		dst[i] = PixelMult(src[i], channelMask);
+	}
+}
 void BlitCharMultichannel(
 	GraphicsDevice *device,
 	const Pic *pic,
 	const Vec2i pos,
 	const CharColors *masks)
 {
-	Uint32 *current = pic->Data;
-	Vec2i v = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitClip c;
+	if (!BlitClipPic(device, pic->size, Vec2iAdd(pos, pic->offset), &c))
 	{
-		int yoff = i + v.y;
-		if (yoff > device->clipping.bottom)
-		{
-			break;
-		}
-		if (yoff < device->clipping.top)
-		{
-			current += pic->size.x;
-			continue;
-		}
-		yoff *= device->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
-		{
-			Uint32 *target;
-			const int xoff = j + v.x;
-			if (xoff < device->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > device->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (*current == 0)
-			{
-				current++;
-				continue;
-			}
-			target = device->buf + yoff + xoff;
-			const color_t color = PIXEL2COLOR(*current);
-			*target = PixelMult(
-				*current,
-				COLOR2PIXEL(CharColorsGetChannelMask(masks, color.a)));
-			current++;
-		}
+		return;
 	}
+	// Convert the channel masks once
+	RunMultichannelData d;
+	d.Masks = masks;
+	for (int i = 0; i < 6; i++)
+	{
+		d.ChannelMasks[i] = COLOR2PIXEL(
+			CharColorsGetChannelMask(masks, (uint8_t)(250 + i)));
+	}
+	BlitRuns(device, pic, &c, true, RunMultichannel, &d);
 }
 static color_t CharColorsGetChannelMask(
 	const CharColors *c, const uint8_t alpha)
@@ -350,60 +340,228 @@ static color_t CharColorsGetChannelMask(
 		return colorWhite;
 	}
 }
+// Channel positions of the device format, which has 8 bits per channel,
+// so that pixels can be worked on without converting them to colours
+typedef struct
+{
+	int R, G, B, A;
+} PixelShifts;
+static PixelShifts GetPixelShifts(const GraphicsDevice *g)
+{
+	PixelShifts s;
+	s.R = g->Format->Rshift;
+	s.G = g->Format->Gshift;
+	s.B = g->Format->Bshift;
+	s.A = g->Format->Ashift;
+	return s;
+}
+#define PIXEL_CHANNEL(_p, _shift) ((int)(((_p) >> (_shift)) & 0xFF))
+
+typedef struct
+{
+	color_t Blend;
+	PixelShifts S;
+} RunBlendData;
+// ColorMult by the blend colour, then ColorAlphaBlend onto the target
+#define BLEND_CHANNEL(_src, _dst, _m, _a) \
+	(((_dst) * (255 - (_a)) + ((_src) * (_m) / 255) * (_a)) / 255)
+static void RunBlend(
+	Uint32 *dst, const Uint32 *src, const int n, const void *data)
+{
+	const RunBlendData *d = data;
+	const color_t m = d->Blend;
+	const PixelShifts s = d->S;
+	for (int i = 0; i < n; i++)
+	{
+		const Uint32 ps = src[i];
+		const Uint32 pd = dst[i];
+		const Uint32 r = BLEND_CHANNEL(
+			PIXEL_CHANNEL(ps, s.R), PIXEL_CHANNEL(pd, s.R), m.r, m.a);
+		const Uint32 g = BLEND_CHANNEL(
+			PIXEL_CHANNEL(ps, s.G), PIXEL_CHANNEL(pd, s.G), m.g, m.a);
+		const Uint32 b = BLEND_CHANNEL(
+			PIXEL_CHANNEL(ps, s.B), PIXEL_CHANNEL(pd, s.B), m.b, m.a);
+		dst[i] = (r << s.R) | (g << s.G) | (b << s.B) | (0xFFu << s.A);
+	}
+}
 void BlitBlend(
 	GraphicsDevice *g, const Pic *pic, Vec2i pos, const color_t blend)
 {
-	Uint32 *current = pic->Data;
-	pos = Vec2iAdd(pos, pic->offset);
-	for (int i = 0; i < pic->size.y; i++)
+	BlitClip c;
+	if (!BlitClipPic(g, pic->size, Vec2iAdd(pos, pic->offset), &c))
+	{
+		return;
+	}
+	RunBlendData d;
+	d.Blend = blend;
+	d.S = GetPixelShifts(g);
+	BlitRuns(g, pic, &c, true, RunBlend, &d);
+}
+
+void BlitTintRect(
+	GraphicsDevice *g, const Vec2i pos, const Vec2i size, const HSV tint)
+{
+	BlitClip c;
+	if (!BlitClipPic(g, size, pos, &c))
+	{
+		return;
+	}
+	ColorTintLUT lut;
+	ColorTintLUTInit(&lut, tint);
+	const PixelShifts s = GetPixelShifts(g);
+	for (int y = 0; y < c.Size.y; y++)
 	{
-		int yoff = i + pos.y;
-		if (yoff > g->clipping.bottom)
+		Uint32 *dst =
+			g->buf + (c.Dst.y + y) * g->cachedConfig.Res.x + c.Dst.x;
+		for (int x = 0; x < c.Size.x; x++)
 		{
-			break;
+			const Uint32 p = dst[x];
+			const int r = PIXEL_CHANNEL(p, s.R);
+			const int gr = PIXEL_CHANNEL(p, s.G);
+			const int b = PIXEL_CHANNEL(p, s.B);
+			const int vAvg = (r + gr + b) / 3;
+			Uint32 out = p & (0xFFu << s.A);
+			if (lut.Channel == NULL)
+			{
+				out |= ((Uint32)lut.Average[0][vAvg] << s.R) |
+					((Uint32)lut.Average[1][vAvg] << s.G) |
+					((Uint32)lut.Average[2][vAvg] << s.B);
+			}
+			else
+			{
+				const uint8_t *row = lut.Channel + vAvg * 256;
+				out |= ((Uint32)row[r] << s.R) |
+					((Uint32)row[gr] << s.G) |
+					((Uint32)row[b] << s.B);
+			}
+			dst[x] = out;
 		}
-		if (yoff < g->clipping.top)
+	}
+	ColorTintLUTTerminate(&lut);
+}
+
+void BlitMaskRect(
+	GraphicsDevice *g, const Vec2i pos, const Vec2i size, const color_t mask)
+{
+	BlitClip c;
+	if (!BlitClipPic(g, size, pos, &c))
+	{
+		return;
+	}
+	// ColorMult per channel, as lookups
+	Uint32 lut[3][256];
+	const PixelShifts s = GetPixelShifts(g);
+	for (int i = 0; i < 256; i++)
+	{
+		lut[0][i] = (Uint32)(i * mask.r / 255) << s.R;
+		lut[1][i] = (Uint32)(i * mask.g / 255) << s.G;
+		lut[2][i] = (Uint32)(i * mask.b / 255) << s.B;
+	}
+	for (int y = 0; y < c.Size.y; y++)
+	{
+		Uint32 *dst =
+			g->buf + (c.Dst.y + y) * g->cachedConfig.Res.x + c.Dst.x;
+		for (int x = 0; x < c.Size.x; x++)
+		{
+			const Uint32 p = dst[x];
+			dst[x] = (p & (0xFFu << s.A)) |
+				lut[0][PIXEL_CHANNEL(p, s.R)] |
+				lut[1][PIXEL_CHANNEL(p, s.G)] |
+				lut[2][PIXEL_CHANNEL(p, s.B)];
+		}
+	}
+}
+
+static bool FindDirtyBand(
+	Rect2i *r, const Uint32 *prev, const Uint32 *buf, const int w,
+	const int y, const int h);
+static bool ShouldMergeRects(const Rect2i *a, const Rect2i *b);
+void BlitDirtyRects(
+	CArray *rects, Uint32 *prev, const Uint32 *buf, const Vec2i size)
+{
+	CArrayClear(rects);
+	for (int y = 0; y < size.y; y += BLIT_DIRTY_BAND_H)
+	{
+		const int h = MIN(BLIT_DIRTY_BAND_H, size.y - y);
+		Rect2i r;
+		if (!FindDirtyBand(&r, prev, buf, size.x, y, h))
 		{
-			current += pic->size.x;
 			continue;
 		}
-		yoff *= g->cachedConfig.Res.x;
-		for (int j = 0; j < pic->size.x; j++)
+		for (int row = r.Pos.y; row < r.Pos.y + r.Size.y; row++)
 		{
-			int xoff = j + pos.x;
-			if (xoff < g->clipping.left)
-			{
-				current++;
-				continue;
-			}
-			if (xoff > g->clipping.right)
-			{
-				current += pic->size.x - j;
-				break;
-			}
-			if (*current == 0)
-			{
-				current++;
-				continue;
-			}
-			Uint32 *target = g->buf + yoff + xoff;
-			const color_t currentColor = PIXEL2COLOR(*current);
-			color_t blendedColor = ColorMult(
-				currentColor, blend);
-			blendedColor.a = blend.a;
-			const color_t targetColor = PIXEL2COLOR(*target);
-			blendedColor = ColorAlphaBlend(targetColor, blendedColor);
-			*target = COLOR2PIXEL(blendedColor);
-			current++;
+			const int i = row * size.x + r.Pos.x;
+			memcpy(prev + i, buf + i, r.Size.x * sizeof *buf);
+		}
+		// Join with the band above if that doesn't upload much more
+		Rect2i *last =
+			rects->size > 0 ? CArrayGet(rects, rects->size - 1) : NULL;
+		if (last != NULL && ShouldMergeRects(last, &r))
+		{
+			const int left = MIN(last->Pos.x, r.Pos.x);
+			const int right =
+				MAX(last->Pos.x + last->Size.x, r.Pos.x + r.Size.x);
+			last->Pos.x = left;
+			last->Size = Vec2iNew(right - left, last->Size.y + r.Size.y);
+			continue;
 		}
+		CArrayPushBack(rects, &r);
 	}
 }
+static bool FindDirtyBand(
+	Rect2i *r, const Uint32 *prev, const Uint32 *buf, const int w,
+	const int y, const int h)
+{
+	int left = w;
+	int right = -1;
+	for (int row = y; row < y + h; row++)
+	{
+		const Uint32 *p = prev + row * w;
+		const Uint32 *b = buf + row * w;
+		if (memcmp(p, b, w * sizeof *b) == 0)
+		{
+			continue;
+		}
+		int x0 = 0;
+		while (p[x0] == b[x0])
+		{
+			x0++;
+		}
+		int x1 = w - 1;
+		while (p[x1] == b[x1])
+		{
+			x1--;
+		}
+		left = MIN(left, x0);
+		right = MAX(right, x1);
+	}
+	if (right < 0)
+	{
+		return false;
+	}
+	r->Pos = Vec2iNew(left, y);
+	r->Size = Vec2iNew(right - left + 1, h);
+	return true;
+}
+static bool ShouldMergeRects(const Rect2i *a, const Rect2i *b)
+{
+	if (a->Pos.y + a->Size.y != b->Pos.y)
+	{
+		return false;
+	}
+	const int left = MIN(a->Pos.x, b->Pos.x);
+	const int right = MAX(a->Pos.x + a->Size.x, b->Pos.x + b->Size.x);
+	const int merged = (right - left) * (a->Size.y + b->Size.y);
+	const int separate = a->Size.x * a->Size.y + b->Size.x * b->Size.y;
+	// Each upload has a fixed cost, so accept a little extra area
+	return merged * 4 <= separate * 5;
+}
 
+static void UploadScreen(GraphicsDevice *g);
 static void RenderTexture(SDL_Renderer *r, SDL_Texture *t);
 void BlitFlip(GraphicsDevice *g)
 {
-	SDL_UpdateTexture(
-		g->screen, NULL, g->buf, g->cachedConfig.Res.x * sizeof(Uint32));
+	UploadScreen(g);
 	if (SDL_RenderClear(g->renderer) != 0)
 	{
 		LOG(LM_MAIN, LL_ERROR, "Failed to clear renderer: %s\n",
@@ -412,11 +570,62 @@ void BlitFlip(GraphicsDevice *g)
 	}
 	RenderTexture(g->renderer, g->bkg);
 	RenderTexture(g->renderer, g->screen);
-	// Apply brightness as an overlay texture
-	RenderTexture(g->renderer, g->brightnessOverlay);
+	// Apply brightness as an overlay texture; at neutral brightness it is
+	// fully transparent so skip it
+	if (g->cachedConfig.Brightness != 0)
+	{
+		RenderTexture(g->renderer, g->brightnessOverlay);
+	}
 
 	SDL_RenderPresent(g->renderer);
 }
+// Frames to upload in full once most of the screen changes, as it does
+// every frame in gameplay, before trying to find dirty rects again
+#define FULL_UPLOAD_FRAMES 30
+static void UploadScreen(GraphicsDevice *g)
+{
+	const Vec2i size = g->cachedConfig.Res;
+	const int pitch = size.x * sizeof(Uint32);
+	if (g->lastBuf == NULL)
+	{
+		// Screen texture is new; upload everything
+		CMALLOC(g->lastBuf, pitch * size.y);
+		memcpy(g->lastBuf, g->buf, pitch * size.y);
+		SDL_UpdateTexture(g->screen, NULL, g->buf, pitch);
+		return;
+	}
+	if (g->fullUploadFrames > 0)
+	{
+		// Comparing would find nearly everything dirty, so skip it and
+		// leave lastBuf stale; refresh it only for the frame after the last
+		// of these, which is compared again
+		g->fullUploadFrames--;
+		if (g->fullUploadFrames == 0)
+		{
+			memcpy(g->lastBuf, g->buf, pitch * size.y);
+		}
+		SDL_UpdateTexture(g->screen, NULL, g->buf, pitch);
+		return;
+	}
+	BlitDirtyRects(&g->dirtyRects, g->lastBuf, g->buf, size);
+	int dirtyArea = 0;
+	CA_FOREACH(const Rect2i, r, g->dirtyRects)
+		dirtyArea += r->Size.x * r->Size.y;
+		const SDL_Rect rect = { r->Pos.x, r->Pos.y, r->Size.x, r->Size.y };
+		if (SDL_UpdateTexture(
+				g->screen, &rect, g->buf + r->Pos.y * size.x + r->Pos.x,
+				pitch) != 0)
+		{
+			LOG(LM_MAIN, LL_ERROR, "Failed to update texture: %s",
+				SDL_GetError());
+		}
+	CA_FOREACH_END()
+	// Only keep comparing while frames are mostly unchanged, as in menus
+	if (dirtyArea * 2 > size.x * size.y)
+	{
+		g->fullUploadFrames = FULL_UPLOAD_FRAMES;
+	}
+}
 static void RenderTexture(SDL_Renderer *r, SDL_Texture *t)
 {
 	if (SDL_RenderCopy(r, t, NULL, NULL) != 0)
@@ -77,6 +77,8 @@ void BlitBackground(
 	GraphicsDevice *device,
 	const Pic *pic, Vec2i pos, const HSV *tint, const bool isTransparent);
 void Blit(GraphicsDevice *device, const Pic *pic, Vec2i pos);
+// Multiply pixel channels
+Uint32 PixelMult(const Uint32 p, const Uint32 m);
 void BlitMasked(
 	GraphicsDevice *device,
 	const Pic *pic,
@@ -90,9 +92,21 @@ void BlitCharMultichannel(
 	const CharColors *masks);
 void BlitBlend(
 	GraphicsDevice *g, const Pic *pic, Vec2i pos, const color_t blend);
+// Tint or multiply a region of the screen, e.g. for menu backgrounds and
+// overlays; same as DrawPointTint and DrawPointMask for every point
+void BlitTintRect(
+	GraphicsDevice *g, const Vec2i pos, const Vec2i size, const HSV tint);
+void BlitMaskRect(
+	GraphicsDevice *g, const Vec2i pos, const Vec2i size, const color_t mask);
 void BlitPicHighlight(
 	GraphicsDevice *g, const Pic *pic, const Vec2i pos, const color_t color);
 
+// Rows of the screen compared together when finding changed regions
+#define BLIT_DIRTY_BAND_H 16
+// Find the rectangles where buf differs from prev, a copy of the last
+// presented frame, and update prev to match; rects is a CArray of Rect2i
+void BlitDirtyRects(
+	CArray *rects, Uint32 *prev, const Uint32 *buf, const Vec2i size);
 void BlitFlip(GraphicsDevice *g);
 
 #define BLIT_BRIGHTNESS_MIN (-10)
@@ -0,0 +1,274 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "blit_kernels.h"
+
+#include <SDL_cpuinfo.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_HAVE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define BLIT_HAVE_AVX2
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define BLIT_HAVE_AVX2
+#define BLIT_TARGET_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+
+static Uint32 PixelMultScalar(const Uint32 p, const Uint32 m)
+{
+	return
+		((p & 0xFF) * (m & 0xFF) / 0xFF) |
+		((((p & 0xFF00) >> 8) * ((m & 0xFF00) >> 8) / 0xFF) << 8) |
+		((((p & 0xFF0000) >> 16) * ((m & 0xFF0000) >> 16) / 0xFF) << 16) |
+		((((p & 0xFF000000) >> 24) * ((m & 0xFF000000) >> 24) / 0xFF) << 24);
+}
+static void CopyKeyedScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (src[i] & amask)
+		{
+			dst[i] = src[i];
+		}
+	}
+}
+static void MultScalar(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const Uint32 amask, const int ashift, const int minAlpha)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if ((int)((src[i] & amask) >> ashift) < minAlpha)
+		{
+			continue;
+		}
+		dst[i] = PixelMultScalar(src[i], mask) | amask;
+	}
+}
+
+#ifdef BLIT_HAVE_SSE2
+// Per-channel a * b / 255 for 8 16-bit lanes; exact for 8-bit inputs
+static __m128i MulDiv255SSE2(const __m128i a, const __m128i b)
+{
+	const __m128i x = _mm_mullo_epi16(a, b);
+	return _mm_srli_epi16(
+		_mm_add_epi16(
+			_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)),
+		8);
+}
+static void CopyKeyedSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	const __m128i am = _mm_set1_epi32((int)amask);
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		// All ones where alpha is zero, i.e. keep dst
+		const __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, am), zero);
+		_mm_storeu_si128(
+			(__m128i *)(dst + i),
+			_mm_or_si128(
+				_mm_and_si128(keep, d), _mm_andnot_si128(keep, s)));
+	}
+	CopyKeyedScalar(dst + i, src + i, n - i, amask);
+}
+static void MultSSE2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const Uint32 amask, const int ashift, const int minAlpha)
+{
+	const __m128i am = _mm_set1_epi32((int)amask);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i m16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)mask), zero);
+	const __m128i minA = _mm_set1_epi32(minAlpha);
+	const __m128i shift = _mm_cvtsi32_si128(ashift);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		const __m128i lo = MulDiv255SSE2(_mm_unpacklo_epi8(s, zero), m16);
+		const __m128i hi = MulDiv255SSE2(_mm_unpackhi_epi8(s, zero), m16);
+		const __m128i r = _mm_or_si128(_mm_packus_epi16(lo, hi), am);
+		const __m128i alpha = _mm_srl_epi32(_mm_and_si128(s, am), shift);
+		const __m128i keep = _mm_cmplt_epi32(alpha, minA);
+		_mm_storeu_si128(
+			(__m128i *)(dst + i),
+			_mm_or_si128(
+				_mm_and_si128(keep, d), _mm_andnot_si128(keep, r)));
+	}
+	MultScalar(dst + i, src + i, n - i, mask, amask, ashift, minAlpha);
+}
+#endif
+
+#ifdef BLIT_HAVE_AVX2
+BLIT_TARGET_AVX2
+static __m256i MulDiv255AVX2(const __m256i a, const __m256i b)
+{
+	const __m256i x = _mm256_mullo_epi16(a, b);
+	return _mm256_srli_epi16(
+		_mm256_add_epi16(
+			_mm256_add_epi16(x, _mm256_set1_epi16(1)),
+			_mm256_srli_epi16(x, 8)),
+		8);
+}
+BLIT_TARGET_AVX2
+static void CopyKeyedAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask)
+{
+	const __m256i am = _mm256_set1_epi32((int)amask);
+	const __m256i zero = _mm256_setzero_si256();
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		const __m256i keep =
+			_mm256_cmpeq_epi32(_mm256_and_si256(s, am), zero);
+		_mm256_storeu_si256(
+			(__m256i *)(dst + i), _mm256_blendv_epi8(s, d, keep));
+	}
+	// Avoid AVX-SSE transition stalls in the legacy-encoded SSE2 tail
+	_mm256_zeroupper();
+	CopyKeyedSSE2(dst + i, src + i, n - i, amask);
+}
+BLIT_TARGET_AVX2
+static void MultAVX2(
+	Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+	const Uint32 amask, const int ashift, const int minAlpha)
+{
+	const __m256i am = _mm256_set1_epi32((int)amask);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i m16 =
+		_mm256_unpacklo_epi8(_mm256_set1_epi32((int)mask), zero);
+	const __m256i minA = _mm256_set1_epi32(minAlpha);
+	const __m128i shift = _mm_cvtsi32_si128(ashift);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+		// Unpack and pack work within 128-bit lanes, so pixel order is kept
+		const __m256i lo =
+			MulDiv255AVX2(_mm256_unpacklo_epi8(s, zero), m16);
+		const __m256i hi =
+			MulDiv255AVX2(_mm256_unpackhi_epi8(s, zero), m16);
+		const __m256i r = _mm256_or_si256(_mm256_packus_epi16(lo, hi), am);
+		const __m256i alpha =
+			_mm256_srl_epi32(_mm256_and_si256(s, am), shift);
+		const __m256i keep = _mm256_cmpgt_epi32(minA, alpha);
+		_mm256_storeu_si256(
+			(__m256i *)(dst + i), _mm256_blendv_epi8(r, d, keep));
+	}
+	_mm256_zeroupper();
+	MultSSE2(dst + i, src + i, n - i, mask, amask, ashift, minAlpha);
+}
+#endif
+
+BlitKernels gBlitKernels = { CopyKeyedScalar, MultScalar };
+
+const char *BlitKernelsTypeStr(const BlitKernelsType t)
+{
+	switch (t)
+	{
+	case BLIT_KERNELS_SCALAR: return "scalar";
+	case BLIT_KERNELS_SSE2: return "SSE2";
+	case BLIT_KERNELS_AVX2: return "AVX2";
+	default: return "";
+	}
+}
+
+bool BlitKernelsIsSupported(const BlitKernelsType t)
+{
+	switch (t)
+	{
+	case BLIT_KERNELS_SCALAR:
+		return true;
+#ifdef BLIT_HAVE_SSE2
+	case BLIT_KERNELS_SSE2:
+		return SDL_HasSSE2();
+#endif
+#ifdef BLIT_HAVE_AVX2
+	case BLIT_KERNELS_AVX2:
+		return SDL_HasAVX2();
+#endif
+	default:
+		return false;
+	}
+}
+
+bool BlitKernelsSelect(const BlitKernelsType t)
+{
+	if (!BlitKernelsIsSupported(t))
+	{
+		return false;
+	}
+	switch (t)
+	{
+#ifdef BLIT_HAVE_SSE2
+	case BLIT_KERNELS_SSE2:
+		gBlitKernels.CopyKeyed = CopyKeyedSSE2;
+		gBlitKernels.Mult = MultSSE2;
+		break;
+#endif
+#ifdef BLIT_HAVE_AVX2
+	case BLIT_KERNELS_AVX2:
+		gBlitKernels.CopyKeyed = CopyKeyedAVX2;
+		gBlitKernels.Mult = MultAVX2;
+		break;
+#endif
+	default:
+		gBlitKernels.CopyKeyed = CopyKeyedScalar;
+		gBlitKernels.Mult = MultScalar;
+		break;
+	}
+	return true;
+}
+
+BlitKernelsType BlitKernelsInit(void)
+{
+	for (int t = BLIT_KERNELS_COUNT - 1; t > BLIT_KERNELS_SCALAR; t--)
+	{
+		if (BlitKernelsSelect((BlitKernelsType)t))
+		{
+			return (BlitKernelsType)t;
+		}
+	}
+	BlitKernelsSelect(BLIT_KERNELS_SCALAR);
+	return BLIT_KERNELS_SCALAR;
+}
@@ -0,0 +1,65 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+// Per-row pixel kernels used by the blitters, with SIMD versions selected
+// at startup according to the CPU. All versions give identical results.
+typedef enum
+{
+	BLIT_KERNELS_SCALAR,
+	BLIT_KERNELS_SSE2,
+	BLIT_KERNELS_AVX2,
+	BLIT_KERNELS_COUNT
+} BlitKernelsType;
+const char *BlitKernelsTypeStr(const BlitKernelsType t);
+
+typedef struct
+{
+	// Copy the pixels whose alpha is not zero
+	void (*CopyKeyed)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 amask);
+	// Write src * mask per channel, fully opaque; pixels whose alpha is less
+	// than minAlpha are skipped
+	void (*Mult)(
+		Uint32 *dst, const Uint32 *src, const int n, const Uint32 mask,
+		const Uint32 amask, const int ashift, const int minAlpha);
+} BlitKernels;
+// Defaults to the scalar kernels
+extern BlitKernels gBlitKernels;
+
+// Whether the kernel type is built in and supported by this CPU
+bool BlitKernelsIsSupported(const BlitKernelsType t);
+// Switch to a kernel type; returns false if not supported
+bool BlitKernelsSelect(const BlitKernelsType t);
+// Select the fastest supported kernels, and return which
+BlitKernelsType BlitKernelsInit(void);
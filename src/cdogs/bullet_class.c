@@ -136,7 +136,8 @@ static Vec2i SeekTowards(
 
 static void FireGuns(const TMobileObject *obj, const CArray *guns);
 static HitType HitItem(
-	TMobileObject *obj, const Vec2i pos, const bool multipleHits);
+	TMobileObject *obj, const Vec2i from, const Vec2i to,
+	const bool multipleHits);
 bool UpdateBullet(TMobileObject *obj, const int ticks)
 {
 	TileItemUpdate(&obj->tileItem, ticks);
@@ -183,7 +184,10 @@ bool UpdateBullet(TMobileObject *obj, const int ticks)
 	HitType hitItem = HIT_NONE;
 	if (!gCampaign.IsClient)
 	{
-		hitItem = HitItem(obj, pos, obj->bulletClass->Persists);
+		// Sweep along the path so fast bullets can't skip past walls or
+		// items; stop at the first wall, then hit anything before it
+		pos = GetWallSweepFullPos(objPos, pos);
+		hitItem = HitItem(obj, objPos, pos, obj->bulletClass->Persists);
 	}
 	const Vec2i realPos = Vec2iFull2Real(pos);
 
@@ -373,7 +377,8 @@ typedef struct
 } HitItemData;
 static bool HitItemFunc(TTileItem *ti, void *data);
 static HitType HitItem(
-	TMobileObject *obj, const Vec2i pos, const bool multipleHits)
+	TMobileObject *obj, const Vec2i from, const Vec2i to,
+	const bool multipleHits)
 {
 	// Don't hit if no damage dealt
 	// This covers non-damaging debris explosions
@@ -388,8 +393,8 @@ static HitType HitItem(
 	data.HitType = HIT_NONE;
 	data.MultipleHits = multipleHits;
 	data.Obj = obj;
-	CollideTileItems(
-		&obj->tileItem, Vec2iFull2Real(pos),
+	CollideTileItemsSwept(
+		&obj->tileItem, Vec2iFull2Real(from), Vec2iFull2Real(to),
 		TILEITEM_CAN_BE_SHOT, COLLISIONTEAM_NONE,
 		IsPVP(gCampaign.Entry.Mode),
 		HitItemFunc, &data);
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "utils.h"
 
 void CArrayInit(CArray *a, size_t elemSize)
@@ -37,6 +38,12 @@ void CArrayInit(CArray *a, size_t elemSize)
 	a->elemSize = elemSize;
 	a->size = 0;
 	a->capacity = 0;
+	a->arena = NULL;
+}
+void CArrayInitArena(CArray *a, size_t elemSize, struct Arena *arena)
+{
+	CArrayInit(a, elemSize);
+	a->arena = arena;
 }
 void CArrayReserve(CArray *a, size_t capacity)
 {
@@ -44,9 +51,14 @@ void CArrayReserve(CArray *a, size_t capacity)
 	{
 		return;
 	}
+	const size_t oldSize = a->capacity * a->elemSize;
 	a->capacity = capacity;
 	const size_t size = a->capacity * a->elemSize;
-	if (size)
+	if (size && a->arena != NULL)
+	{
+		a->data = ArenaRealloc(a->arena, a->data, oldSize, size);
+	}
+	else if (size)
 	{
 		CREALLOC(a->data, size);
 	}
@@ -186,6 +198,9 @@ void CArrayTerminate(CArray *a)
 	{
 		return;
 	}
-	CFREE(a->data);
+	if (a->arena == NULL)
+	{
+		CFREE(a->data);
+	}
 	memset(a, 0, sizeof *a);
 }
@@ -28,6 +28,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+struct Arena;
+
 // dynamic array
 typedef struct
 {
@@ -35,9 +37,13 @@ typedef struct
 	size_t elemSize;
 	size_t size;
 	size_t capacity;
+	// If set, data is allocated from and owned by this arena
+	struct Arena *arena;
 } CArray;
 
 void CArrayInit(CArray *a, size_t elemSize);
+// Array whose storage is released with the arena, not by CArrayTerminate
+void CArrayInitArena(CArray *a, size_t elemSize, struct Arena *arena);
 void CArrayReserve(CArray *a, size_t capacity);
 void CArrayCopy(CArray *dst, const CArray *src);
 void CArrayPushBack(CArray *a, const void *elem);	// insert address
@@ -5,11 +5,14 @@
  *
  * Modified by Pete Warden to fix a serious performance problem, support strings as keys
  * and removed thread synchronization - http://petewarden.typepad.com
+ *
+ * Reworked as an open addressing table with stored hashes, iterated in
+ * insertion order.
  */
 #pragma once
 
 #define MAP_MISSING -3  /* No such element */
-#define MAP_FULL -2 	/* Hashmap is full */
+#define MAP_FULL -2 	/* Hashmap is full; no longer returned */
 #define MAP_OMEM -1 	/* Out of Memory */
 #define MAP_OK 0 	/* OK */
 
@@ -39,7 +42,7 @@ map_t hashmap_new(void);
 
 /*
  * Iteratively call f with argument (item, data) for
- * each element data in the hashmap. The function must
+ * each element data in the hashmap, in the order they were added. The function must
  * return a map status code. If it returns anything other
  * than MAP_OK the traversal is terminated. f must
  * not reenter any hashmap functions, or deadlock may arise.
@@ -47,7 +50,8 @@ map_t hashmap_new(void);
 int hashmap_iterate(map_t in, PFany f, any_t item);
 
 /*
- * Add an element to the hashmap. Return MAP_OK or MAP_OMEM.
+ * Add an element to the hashmap, replacing any with the same key.
+ * Return MAP_OK or MAP_OMEM.
  */
 int hashmap_put(map_t in, const char* key, any_t value);
 
@@ -56,13 +60,23 @@ int hashmap_put(map_t in, const char* key, any_t value);
  */
 int hashmap_get(const map_t in, const char* key, any_t *arg);
 
+/*
+ * Hash a key, so that keys which are looked up often, such as interned
+ * names, can be hashed once and used with the _hashed functions.
+ */
+unsigned int hashmap_hash_key(const char* key);
+int hashmap_put_hashed(
+	map_t in, const char* key, const unsigned int hash, any_t value);
+int hashmap_get_hashed(
+	const map_t in, const char* key, const unsigned int hash, any_t *arg);
+
 /*
  * Remove an element from the hashmap. Return MAP_OK or MAP_MISSING.
  */
-int hashmap_remove(map_t in, char* key);
+int hashmap_remove(map_t in, const char* key);
 
 /*
- * Get any element. Return MAP_OK or MAP_MISSING.
+ * Get the first element. Return MAP_OK or MAP_MISSING.
  * remove - should the element be removed from the hashmap
  */
 int hashmap_get_one(map_t in, any_t *arg, int remove);
@@ -27,8 +27,10 @@
 #include "camera.h"
 
 #include "actors.h"
+#include "draw/actor_pic_cache.h"
 #include "draw/draw.h"
 #include "draw/drawtools.h"
+#include "draw/render_jobs.h"
 #include "events.h"
 #include "font.h"
 #include "los.h"
@@ -36,12 +38,21 @@
 
 
 #define PAN_SPEED 4
+// Don't split views into bands shorter than this, to limit the per-job
+// overhead of going through the buffer
+#define BAND_MIN_HEIGHT 16
 
 void CameraInit(Camera *camera)
 {
 	memset(camera, 0, sizeof *camera);
-	DrawBufferInit(
-		&camera->Buffer, Vec2iNew(X_TILES, Y_TILES), &gGraphicsDevice);
+	MapLayerInit(&camera->Layer);
+	for (int i = 0; i < MAX_LOCAL_PLAYERS; i++)
+	{
+		DrawBuffer *b = &camera->Views[i].Buffer;
+		DrawBufferInit(b, Vec2iNew(X_TILES, Y_TILES), &gGraphicsDevice);
+		b->Layer = &camera->Layer;
+	}
+	CArrayInit(&camera->JobDisplayLists, sizeof(DisplayList));
 	camera->lastPosition = Vec2iZero();
 	HUDInit(&camera->HUD, &gGraphicsDevice, &gMission);
 	camera->shake = ScreenShakeZero();
@@ -49,7 +60,15 @@ void CameraInit(Camera *camera)
 
 void CameraTerminate(Camera *camera)
 {
-	DrawBufferTerminate(&camera->Buffer);
+	for (int i = 0; i < MAX_LOCAL_PLAYERS; i++)
+	{
+		DrawBufferTerminate(&camera->Views[i].Buffer);
+	}
+	CA_FOREACH(DisplayList, displaylist, camera->JobDisplayLists)
+		DisplayListTerminate(displaylist);
+	CA_FOREACH_END()
+	CArrayTerminate(&camera->JobDisplayLists);
+	MapLayerTerminate(&camera->Layer);
 	HUDTerminate(&camera->HUD);
 }
 
@@ -115,8 +134,10 @@ void CameraUpdate(Camera *camera, const int ticks, const int ms)
 }
 
 static void FollowPlayer(Vec2i *pos, const int playerUID);
-static void DoBuffer(
-	DrawBuffer *b, Vec2i center, int w, Vec2i noise, Vec2i offset);
+static void AddView(
+	Camera *camera, const Vec2i center, const int w, const Vec2i noise,
+	const Vec2i offset);
+static void DrawViews(Camera *camera);
 void CameraDraw(
 	Camera *camera, const input_device_e pausingDevice,
 	const bool controllerUnplugged)
@@ -134,6 +155,8 @@ void CameraDraw(
 
 	const Vec2i noise = ScreenShakeGetDelta(camera->shake);
 
+	camera->NumViews = 0;
+	ActorPicCacheNewFrame(&gActorPicCache, gMap.LoadId);
 	GraphicsResetBlitClip(&gGraphicsDevice);
 	if (numPlayersScreen == 0)
 	{
@@ -157,10 +180,8 @@ void CameraDraw(
 		{
 			FollowPlayer(&camera->lastPosition, camera->FollowPlayerUID);
 		}
-		DoBuffer(
-			&camera->Buffer,
-			camera->lastPosition,
-			X_TILES, noise, centerOffset);
+		AddView(camera, camera->lastPosition, X_TILES, noise, centerOffset);
+		DrawViews(camera);
 		SoundSetEars(camera->lastPosition);
 	}
 	else
@@ -219,10 +240,9 @@ void CameraDraw(
 				CA_FOREACH_END()
 			}
 
-			DoBuffer(
-				&camera->Buffer,
-				camera->lastPosition,
-				X_TILES, noise, centerOffset);
+			AddView(
+				camera, camera->lastPosition, X_TILES, noise, centerOffset);
+			DrawViews(camera);
 			SoundSetEars(earPos);
 		}
 		else if (numPlayersScreen == 2)
@@ -250,12 +270,13 @@ void CameraDraw(
 				}
 
 				LOSCalcFrom(&gMap, Vec2iToTile(camera->lastPosition), false);
-				DoBuffer(
-					&camera->Buffer,
-					camera->lastPosition,
+				AddView(
+					camera, camera->lastPosition,
 					X_TILES_HALF, noise, centerOffsetPlayer);
 				SoundSetEarsSide(idx == 0, camera->lastPosition);
 			}
+			DrawViews(camera);
+			GraphicsResetBlitClip(&gGraphicsDevice);
 			Draw_Line(w / 2 - 1, 0, w / 2 - 1, h - 1, colorBlack);
 			Draw_Line(w / 2, 0, w / 2, h - 1, colorBlack);
 		}
@@ -301,9 +322,8 @@ void CameraDraw(
 					centerOffsetPlayer.y += h / 4;
 				}
 				LOSCalcFrom(&gMap, Vec2iToTile(camera->lastPosition), false);
-				DoBuffer(
-					&camera->Buffer,
-					camera->lastPosition,
+				AddView(
+					camera, camera->lastPosition,
 					X_TILES_HALF, noise, centerOffsetPlayer);
 
 				// Set the sound "ears"
@@ -327,6 +347,10 @@ void CameraDraw(
 					SoundSetEarsSide(!isLeft, camera->lastPosition);
 				}
 			}
+			DrawViews(camera);
+			// Unclipped, so that the lines also cover the rows where the
+			// upper and lower views overlap
+			GraphicsResetBlitClip(&gGraphicsDevice);
 			Draw_Line(w / 2 - 1, 0, w / 2 - 1, h - 1, colorBlack);
 			Draw_Line(w / 2, 0, w / 2, h - 1, colorBlack);
 			Draw_Line(0, h / 2 - 1, w - 1, h / 2 - 1, colorBlack);
@@ -411,15 +435,96 @@ static void FollowPlayer(Vec2i *pos, const int playerUID)
 	if (a == NULL) return;
 	*pos = Vec2iFull2Real(a->Pos);
 }
-static void DoBuffer(
-	DrawBuffer *b, Vec2i center, int w, Vec2i noise, Vec2i offset)
+// Set up a view with the current clipping; the map is copied and
+// prepared here, since LOS may be redone for the next view
+static void AddView(
+	Camera *camera, const Vec2i center, const int w, const Vec2i noise,
+	const Vec2i offset)
 {
+	CASSERT(camera->NumViews < MAX_LOCAL_PLAYERS, "too many camera views");
+	CameraView *v = &camera->Views[camera->NumViews];
+	camera->NumViews++;
+	DrawBuffer *b = &v->Buffer;
 	DrawBufferSetFromMap(b, &gMap, Vec2iAdd(center, noise), w);
 	if (gPlayerDatas.size > 0)
 	{
 		DrawBufferFix(b);
 	}
-	DrawBufferDraw(b, offset, NULL);
+	DrawBufferPrepare(b);
+	v->Offset = offset;
+	v->Clip = gGraphicsDevice.clipping;
+}
+// Draw the world of all views in parallel, then their overlays in order.
+// Each job covers one band of one screen column and draws the views that
+// overlap it in order, clipped to the band, so each pixel is written in
+// the same order as if the views were drawn one after the other.
+static void DrawViewsJob(void *data, const int index);
+static void DrawViews(Camera *camera)
+{
+	const int h = gGraphicsDevice.cachedConfig.Res.y;
+	camera->NumColumns = camera->NumViews > 1 ? 2 : 1;
+	camera->NumBands = CLAMP(RenderJobsNumThreads(), 1, h / BAND_MIN_HEIGHT);
+	const int numJobs = camera->NumColumns * camera->NumBands;
+	size_t maxRowThings = 0;
+	for (int i = 0; i < camera->NumViews; i++)
+	{
+		maxRowThings =
+			MAX(maxRowThings, camera->Views[i].Buffer.MaxRowThings);
+	}
+	// Allocate here, as the jobs may run on other threads
+	while ((int)camera->JobDisplayLists.size < numJobs)
+	{
+		DisplayList displaylist;
+		DisplayListInit(&displaylist);
+		CArrayPushBack(&camera->JobDisplayLists, &displaylist);
+	}
+	CA_FOREACH(DisplayList, displaylist, camera->JobDisplayLists)
+		DisplayListReserve(displaylist, maxRowThings);
+	CA_FOREACH_END()
+	RenderJobsRun(DrawViewsJob, camera, numJobs);
+
+	for (int i = 0; i < camera->NumViews; i++)
+	{
+		CameraView *v = &camera->Views[i];
+		GraphicsSetBlitClip(
+			&gGraphicsDevice,
+			v->Clip.left, v->Clip.top, v->Clip.right, v->Clip.bottom);
+		DrawBufferDrawOverlays(&v->Buffer, v->Offset);
+	}
+}
+static void DrawViewsJob(void *data, const int index)
+{
+	Camera *camera = data;
+	const int w = gGraphicsDevice.cachedConfig.Res.x;
+	const int h = gGraphicsDevice.cachedConfig.Res.y;
+	const int column = index % camera->NumColumns;
+	const int band = index / camera->NumColumns;
+	BlitClipping r;
+	r.left = column * w / camera->NumColumns;
+	r.right = (column + 1) * w / camera->NumColumns - 1;
+	r.top = band * h / camera->NumBands;
+	r.bottom = (band + 1) * h / camera->NumBands - 1;
+	// Draw to a copy of the device, which holds this job's clipping
+	GraphicsDevice g = gGraphicsDevice;
+	DisplayList *displaylist = CArrayGet(&camera->JobDisplayLists, index);
+	for (int i = 0; i < camera->NumViews; i++)
+	{
+		const CameraView *v = &camera->Views[i];
+		g.clipping.left = MAX(r.left, v->Clip.left);
+		g.clipping.top = MAX(r.top, v->Clip.top);
+		g.clipping.right = MIN(r.right, v->Clip.right);
+		g.clipping.bottom = MIN(r.bottom, v->Clip.bottom);
+		if (g.clipping.left > g.clipping.right ||
+			g.clipping.top > g.clipping.bottom)
+		{
+			continue;
+		}
+		DrawBuffer b = v->Buffer;
+		b.g = &g;
+		b.displaylist = *displaylist;
+		DrawBufferDrawWorld(&b, v->Offset);
+		*displaylist = b.displaylist;
+	}
 }
 
 bool CameraIsSingleScreen(void)
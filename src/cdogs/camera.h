@@ -27,6 +27,7 @@
 #pragma once
 
 #include "draw/draw_buffer.h"
+#include "draw/map_layer.h"
 #include "hud/hud.h"
 #include "screen_shake.h"
 
@@ -39,9 +40,24 @@ typedef enum
 	SPECTATE_FREE
 } SpectateMode;
 
+// A view of the map on screen; one per split screen
 typedef struct
 {
 	DrawBuffer Buffer;
+	Vec2i Offset;
+	BlitClipping Clip;
+} CameraView;
+
+typedef struct
+{
+	CameraView Views[MAX_LOCAL_PLAYERS];
+	int NumViews;
+	// The views are drawn by render jobs, each covering one band of a
+	// screen column, with its own display list
+	int NumColumns;
+	int NumBands;
+	CArray JobDisplayLists;	// of DisplayList
+	MapLayer Layer;
 	Vec2i lastPosition;
 	HUD HUD;
 	ScreenShake shake;
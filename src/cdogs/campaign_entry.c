@@ -63,15 +63,18 @@ bool CampaignEntryTryLoad(
 	{
 		return false;
 	}
+	CampaignEntryInitScanned(entry, path, buf, numMissions, mode);
+	CFREE(buf);
+	return true;
+}
+void CampaignEntryInitScanned(
+	CampaignEntry *entry, const char *path, const char *title,
+	const int numMissions, const GameMode mode)
+{
 	// cap length of title
-	size_t maxLen = 70;
-	if (strlen(buf) > maxLen)
-	{
-		buf[maxLen] = '\0';
-	}
-	char title[256];
-	sprintf(title, "%s (%d)", buf, numMissions);
-	CampaignEntryInit(entry, title, mode);
+	char info[256];
+	sprintf(info, "%.70s (%d)", title, numMissions);
+	CampaignEntryInit(entry, info, mode);
 	CSTRDUP(entry->Filename, PathGetBasename(path));
 	// Get relative path for the campaign entry, so when we transmit it to
 	// network clients they can load it regardless of install path
@@ -82,8 +85,6 @@ bool CampaignEntryTryLoad(
 	RelPath(pathBuf, path, dataDirBuf);
 	CSTRDUP(entry->Path, pathBuf);
 	entry->NumMissions = numMissions;
-	CFREE(buf);
-	return true;
 }
 void CampaignEntryTerminate(CampaignEntry *entry)
 {
@@ -43,4 +43,8 @@ void CampaignEntryInit(CampaignEntry *entry, const char *title, GameMode mode);
 void CampaignEntryCopy(CampaignEntry *dst, CampaignEntry *src);
 bool CampaignEntryTryLoad(
 	CampaignEntry *entry, const char *path, GameMode mode);
+// Make the entry from a campaign's already scanned title and missions
+void CampaignEntryInitScanned(
+	CampaignEntry *entry, const char *path, const char *title,
+	const int numMissions, const GameMode mode);
 void CampaignEntryTerminate(CampaignEntry *entry);
@@ -0,0 +1,275 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "campaign_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "json_utils.h"
+#include "log.h"
+#include "map_new.h"
+#include "sys_config.h"
+#include "utils.h"
+
+#define CAMPAIGN_INDEX_VERSION 1
+
+
+static CampaignIndexEntry *AddEntry(CampaignIndex *ci, const char *path);
+static Sint64 LoadInt64(json_t *node, const char *name);
+void CampaignIndexLoad(CampaignIndex *ci, const char *filename)
+{
+	memset(ci, 0, sizeof *ci);
+	ci->entries = hashmap_new();
+	FILE *f = fopen(filename, "r");
+	json_t *root = NULL;
+	if (f == NULL)
+	{
+		// Not an error; the index is created on first run
+		goto bail;
+	}
+	if (json_stream_parse(f, &root) != JSON_OK)
+	{
+		LOG(LM_MAIN, LL_WARN, "Error parsing campaign index '%s'", filename);
+		goto bail;
+	}
+	int version = 0;
+	LoadInt(&version, root, "Version");
+	if (version != CAMPAIGN_INDEX_VERSION ||
+		json_find_first_label(root, "Campaigns") == NULL)
+	{
+		goto bail;
+	}
+	for (json_t *node =
+		json_find_first_label(root, "Campaigns")->child->child;
+		node;
+		node = node->next)
+	{
+		char *path = NULL;
+		LoadStr(&path, node, "Path");
+		if (path == NULL)
+		{
+			continue;
+		}
+		CampaignIndexEntry *e = AddEntry(ci, path);
+		CFREE(path);
+		if (e == NULL)
+		{
+			continue;
+		}
+		e->MTime = LoadInt64(node, "MTime");
+		e->Size = LoadInt64(node, "Size");
+		LoadStr(&e->Title, node, "Title");
+		LoadInt(&e->NumMissions, node, "Missions");
+	}
+
+bail:
+	json_free_value(&root);
+	if (f != NULL)
+	{
+		fclose(f);
+	}
+}
+static Sint64 LoadInt64(json_t *node, const char *name)
+{
+	if (!TryLoadValue(&node, name))
+	{
+		return -1;
+	}
+	return strtoll(node->text, NULL, 10);
+}
+
+static int AddEntryNode(any_t data, any_t item);
+static int IsEntryUnused(any_t data, any_t item);
+void CampaignIndexSave(CampaignIndex *ci, const char *filename)
+{
+	// Also save if any campaigns have been removed
+	const bool hasUnused = hashmap_length(ci->entries) > 0 &&
+		hashmap_iterate(ci->entries, IsEntryUnused, NULL) != MAP_OK;
+	if (!ci->IsDirty && !hasUnused)
+	{
+		return;
+	}
+	FILE *f = FileReplaceOpen(filename, "w");
+	if (f == NULL)
+	{
+		LOG(LM_MAIN, LL_WARN, "Error saving campaign index '%s'", filename);
+		return;
+	}
+
+	json_t *root = json_new_object();
+	AddIntPair(root, "Version", CAMPAIGN_INDEX_VERSION);
+	json_t *campaigns = json_new_array();
+	hashmap_iterate(ci->entries, AddEntryNode, campaigns);
+	json_insert_pair_into_object(root, "Campaigns", campaigns);
+
+	char *text = NULL;
+	json_tree_to_string(root, &text);
+	char *formatText = json_format_string(text);
+	const bool ok = fputs(formatText, f) >= 0;
+
+	// clean up
+	free(formatText);
+	free(text);
+	json_free_value(&root);
+
+	if (!FileReplaceClose(f, filename, ok))
+	{
+		LOG(LM_MAIN, LL_WARN, "Error saving campaign index '%s'", filename);
+		return;
+	}
+	ci->IsDirty = false;
+}
+static int AddEntryNode(any_t data, any_t item)
+{
+	json_t *campaigns = data;
+	const CampaignIndexEntry *e = item;
+	if (!e->IsUsed)
+	{
+		return MAP_OK;
+	}
+	json_t *node = json_new_object();
+	AddStringPair(node, "Path", e->Path);
+	char buf[32];
+	sprintf(buf, "%lld", (long long)e->MTime);
+	json_insert_pair_into_object(node, "MTime", json_new_number(buf));
+	sprintf(buf, "%lld", (long long)e->Size);
+	json_insert_pair_into_object(node, "Size", json_new_number(buf));
+	if (e->Title != NULL)
+	{
+		AddStringPair(node, "Title", e->Title);
+		AddIntPair(node, "Missions", e->NumMissions);
+	}
+	json_insert_child(campaigns, node);
+	return MAP_OK;
+}
+static int IsEntryUnused(any_t data, any_t item)
+{
+	UNUSED(data);
+	const CampaignIndexEntry *e = item;
+	return e->IsUsed ? MAP_OK : MAP_MISSING;
+}
+
+static void EntryDestroy(any_t data);
+void CampaignIndexTerminate(CampaignIndex *ci)
+{
+	hashmap_destroy(ci->entries, EntryDestroy);
+	memset(ci, 0, sizeof *ci);
+}
+static void EntryDestroy(any_t data)
+{
+	CampaignIndexEntry *e = data;
+	CFREE(e->Path);
+	CFREE(e->Title);
+	CFREE(e);
+}
+
+static void GetCampaignStat(const char *path, Sint64 *mtime, Sint64 *size);
+bool CampaignIndexScan(
+	CampaignIndex *ci, const char *path, char **title, int *numMissions)
+{
+	Sint64 mtime, size;
+	GetCampaignStat(path, &mtime, &size);
+	CampaignIndexEntry *e;
+	if (hashmap_get(ci->entries, path, (any_t *)&e) != MAP_OK)
+	{
+		e = AddEntry(ci, path);
+	}
+	if (e == NULL || e->MTime != mtime || e->Size != size)
+	{
+		// New or changed; scan it again
+		char *buf;
+		int n;
+		const bool ok = MapNewScan(path, &buf, &n) == 0;
+		if (e == NULL)
+		{
+			// Can't index it; just return what was scanned
+			if (ok)
+			{
+				*title = buf;
+				*numMissions = n;
+			}
+			return ok;
+		}
+		CFREE(e->Title);
+		e->Title = ok ? buf : NULL;
+		e->NumMissions = ok ? n : 0;
+		e->MTime = mtime;
+		e->Size = size;
+		ci->IsDirty = true;
+	}
+	e->IsUsed = true;
+	if (e->Title == NULL)
+	{
+		return false;
+	}
+	CSTRDUP(*title, e->Title);
+	*numMissions = e->NumMissions;
+	return true;
+}
+// Archives are directories, which don't change when the files inside are
+// edited; use the campaign file inside instead
+static void GetCampaignStat(const char *path, Sint64 *mtime, Sint64 *size)
+{
+	char buf[CDOGS_PATH_MAX];
+	if (strcmp(StrGetFileExt(path), "cdogscpn") == 0 ||
+		strcmp(StrGetFileExt(path), "CDOGSCPN") == 0)
+	{
+		sprintf(buf, "%s/campaign.json", path);
+		path = buf;
+	}
+	struct stat st;
+	if (stat(path, &st) != 0)
+	{
+		*mtime = -1;
+		*size = -1;
+		return;
+	}
+	*mtime = (Sint64)st.st_mtime;
+	*size = (Sint64)st.st_size;
+}
+
+static CampaignIndexEntry *AddEntry(CampaignIndex *ci, const char *path)
+{
+	CampaignIndexEntry *e;
+	CCALLOC(e, sizeof *e);
+	CSTRDUP(e->Path, path);
+	e->MTime = -1;
+	e->Size = -1;
+	const int error = hashmap_put(ci->entries, path, e);
+	if (error != MAP_OK)
+	{
+		LOG(LM_MAIN, LL_ERROR, "failed to add campaign index %s: %d",
+			path, error);
+		EntryDestroy(e);
+		return NULL;
+	}
+	return e;
+}
@@ -0,0 +1,68 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+#include "c_hashmap/hashmap.h"
+
+#define CAMPAIGN_INDEX_FILE "campaigns.json"
+
+// What a campaign file was last scanned to contain, so that it doesn't
+// need to be parsed again unless it changes
+typedef struct
+{
+	char *Path;
+	Sint64 MTime;
+	Sint64 Size;
+	char *Title;	// NULL if the file is not a valid campaign
+	int NumMissions;
+	bool IsUsed;
+} CampaignIndexEntry;
+
+typedef struct
+{
+	map_t entries;	// of CampaignIndexEntry, keyed by path
+	bool IsDirty;
+} CampaignIndex;
+
+void CampaignIndexLoad(CampaignIndex *ci, const char *filename);
+// Save the index, if it has changed, dropping the entries for files that
+// weren't scanned
+void CampaignIndexSave(CampaignIndex *ci, const char *filename);
+void CampaignIndexTerminate(CampaignIndex *ci);
+
+// Get the title and number of missions of a campaign, from the index if
+// the file hasn't changed since, otherwise by scanning it.
+// Returns false if it isn't a valid campaign.
+// Remember to free the title.
+bool CampaignIndexScan(
+	CampaignIndex *ci, const char *path, char **title, int *numMissions);
@@ -32,6 +32,7 @@
 
 #include <tinydir/tinydir.h>
 
+#include <cdogs/campaign_index.h>
 #include <cdogs/files.h>
 #include <cdogs/log.h>
 #include <cdogs/map_new.h>
@@ -86,8 +87,8 @@ void CampaignSettingTerminate(CampaignSetting *setting)
 static void CampaignListInit(campaign_list_t *list);
 static void CampaignListTerminate(campaign_list_t *list);
 static void LoadCampaignsFromFolder(
-	campaign_list_t *list, const char *name, const char *path,
-	const GameMode mode);
+	campaign_list_t *list, CampaignIndex *ci, const char *name,
+	const char *path, const GameMode mode);
 static void LoadQuickPlayEntry(CampaignEntry *entry);
 
 void LoadAllCampaigns(custom_campaigns_t *campaigns)
@@ -97,10 +98,17 @@ void LoadAllCampaigns(custom_campaigns_t *campaigns)
 	CampaignListInit(&campaigns->campaignList);
 	CampaignListInit(&campaigns->dogfightList);
 
+	// Only parse the campaigns that have changed since the last run
+	char indexPath[CDOGS_PATH_MAX];
+	GetConfigFilePathBuf(indexPath, CAMPAIGN_INDEX_FILE);
+	CampaignIndex ci;
+	CampaignIndexLoad(&ci, indexPath);
+
 	GetDataFilePath(buf, CDOGS_CAMPAIGN_DIR);
 	LOG(LM_MAIN, LL_INFO, "Load campaigns from dir %s...", buf);
 	LoadCampaignsFromFolder(
 		&campaigns->campaignList,
+		&ci,
 		"",
 		buf,
 		GAME_MODE_NORMAL);
@@ -109,10 +117,14 @@ void LoadAllCampaigns(custom_campaigns_t *campaigns)
 	LOG(LM_MAIN, LL_INFO, "Load dogfights from dir %s...", buf);
 	LoadCampaignsFromFolder(
 		&campaigns->dogfightList,
+		&ci,
 		"",
 		buf,
 		GAME_MODE_DOGFIGHT);
 
+	CampaignIndexSave(&ci, indexPath);
+	CampaignIndexTerminate(&ci);
+
 	LOG(LM_MAIN, LL_INFO, "Load quick play...");
 	LoadQuickPlayEntry(&campaigns->quickPlayEntry);
 }
@@ -154,8 +166,8 @@ static void LoadQuickPlayEntry(CampaignEntry *entry)
 }
 
 static void LoadCampaignsFromFolder(
-	campaign_list_t *list, const char *name, const char *path,
-	const GameMode mode)
+	campaign_list_t *list, CampaignIndex *ci, const char *name,
+	const char *path, const GameMode mode)
 {
 	tinydir_dir dir;
 	int i;
@@ -183,15 +195,21 @@ static void LoadCampaignsFromFolder(
 		{
 			campaign_list_t subFolder;
 			CampaignListInit(&subFolder);
-			LoadCampaignsFromFolder(&subFolder, file.name, file.path, mode);
+			LoadCampaignsFromFolder(
+				&subFolder, ci, file.name, file.path, mode);
 			CArrayPushBack(&list->subFolders, &subFolder);
 		}
 		else if ((file.is_reg || isArchive) && file.name[0] != '~')
 		{
-			CampaignEntry entry;
-			if (CampaignEntryTryLoad(&entry, file.path, mode))
+			char *title;
+			int numMissions;
+			if (CampaignIndexScan(ci, file.path, &title, &numMissions))
 			{
+				CampaignEntry entry;
+				CampaignEntryInitScanned(
+					&entry, file.path, title, numMissions, mode);
 				CArrayPushBack(&list->list, &entry);
+				CFREE(title);
 			}
 		}
 	}
@@ -50,6 +50,7 @@
 
 #include "actors.h"
 #include "config.h"
+#include "wall_collision.h"
 
 
 CollisionSystem gCollisionSystem;
@@ -76,28 +77,19 @@ CollisionTeam CalcCollisionTeam(const bool isActor, const TActor *actor)
 	return COLLISIONTEAM_BAD;
 }
 
+static WallPlane MapWallPlane(const Map *map, const MapPlane plane)
+{
+	WallPlane w;
+	w.Bits = map->Planes[plane];
+	w.Stride = map->PlaneStride;
+	w.Size = map->Size;
+	return w;
+}
+
 bool IsCollisionWithWall(const Vec2i pos, const Vec2i fullSize)
 {
-	Vec2i size = Vec2iScaleDiv(fullSize, 2);
-	if (pos.x - size.x < 0 ||
-		pos.y - size.y < 0 ||
-		pos.x + size.x >= gMap.Size.x * TILE_WIDTH ||
-		pos.y + size.y >= gMap.Size.y * TILE_HEIGHT)
-	{
-		return true;
-	}
-	if (HitWall(pos.x - size.x,	pos.y - size.y) ||
-		HitWall(pos.x - size.x,	pos.y) ||
-		HitWall(pos.x - size.x,	pos.y + size.y) ||
-		HitWall(pos.x,			pos.y + size.y) ||
-		HitWall(pos.x + size.x,	pos.y + size.y) ||
-		HitWall(pos.x + size.x,	pos.y) ||
-		HitWall(pos.x + size.x,	pos.y - size.y) ||
-		HitWall(pos.x,			pos.y - size.y))
-	{
-		return true;
-	}
-	return false;
+	const WallPlane w = MapWallPlane(&gMap, MAP_PLANE_NO_WALK);
+	return WallPlaneCollideBox(&w, pos, fullSize);
 }
 
 // Check collision with a diamond shape
@@ -118,62 +110,8 @@ bool IsCollisionWithWall(const Vec2i pos, const Vec2i fullSize)
 // Where 'x' denotes the bounding diamond, and 'w' represents a wall corner.
 bool IsCollisionDiamond(const Map *map, const Vec2i pos, const Vec2i fullSize)
 {
-	const Vec2i mapSize =
-		Vec2iNew(map->Size.x * TILE_WIDTH, map->Size.y * TILE_HEIGHT);
-	const Vec2i size = Vec2iScaleDiv(fullSize, 2);
-	if (pos.x - size.x < 0 || pos.x + size.x >= mapSize.x ||
-		pos.y - size.y < 0 || pos.y + size.y >= mapSize.y)
-	{
-		return true;
-	}
-
-	// Only support wider-than-taller collision diamonds for now
-	CASSERT(size.x >= size.y, "not implemented, taller than wider diamond");
-	const double gradient = (double)size.y / size.x;
-
-	// Now we need to check in a diamond pattern that the boundary does not
-	// collide
-	// Top to right
-	for (int i = 0; i < size.x; i++)
-	{
-		const int y = (int)Round((-size.x + i)* gradient);
-		const Vec2i p = Vec2iAdd(pos, Vec2iNew(i, y));
-		if (HitWall(p.x, p.y))
-		{
-			return true;
-		}
-	}
-	// Right to bottom
-	for (int i = 0; i < size.x; i++)
-	{
-		const int y = (int)Round(i * gradient);
-		const Vec2i p = Vec2iAdd(pos, Vec2iNew(size.x - i, y));
-		if (HitWall(p.x, p.y))
-		{
-			return true;
-		}
-	}
-	// Bottom to left
-	for (int i = 0; i < size.x; i++)
-	{
-		const int y = (int)Round((size.x - i) * gradient);
-		const Vec2i p = Vec2iAdd(pos, Vec2iNew(-i, y));
-		if (HitWall(p.x, p.y))
-		{
-			return true;
-		}
-	}
-	// Left to top
-	for (int i = 0; i < size.x; i++)
-	{
-		const int y = (int)Round(-i * gradient);
-		const Vec2i p = Vec2iAdd(pos, Vec2iNew(-size.x + i, y));
-		if (HitWall(p.x, p.y))
-		{
-			return true;
-		}
-	}
-	return false;
+	const WallPlane w = MapWallPlane(map, MAP_PLANE_NO_WALK);
+	return WallPlaneCollideDiamond(&w, pos, fullSize);
 }
 
 static bool ItemsCollide(
@@ -259,6 +197,117 @@ void CollideTileItems(
 		}
 	}
 }
+// Entry time of the segment from -> to into the open box centred at c with
+// half extents r; false if it misses
+static bool SegmentEntersBox(
+	const Vec2i from, const Vec2i to, const Vec2i c, const Vec2i r,
+	double *tEnter)
+{
+	double t0 = 0, t1 = 1;
+	const int p[2] = { from.x, from.y };
+	const int d[2] = { to.x - from.x, to.y - from.y };
+	const int lo[2] = { c.x - r.x, c.y - r.y };
+	const int hi[2] = { c.x + r.x, c.y + r.y };
+	for (int i = 0; i < 2; i++)
+	{
+		if (d[i] == 0)
+		{
+			if (p[i] <= lo[i] || p[i] >= hi[i]) return false;
+			continue;
+		}
+		double ta = (double)(lo[i] - p[i]) / d[i];
+		double tb = (double)(hi[i] - p[i]) / d[i];
+		if (ta > tb)
+		{
+			const double tmp = ta;
+			ta = tb;
+			tb = tmp;
+		}
+		t0 = MAX(t0, ta);
+		t1 = MIN(t1, tb);
+		if (t0 >= t1) return false;
+	}
+	*tEnter = t0;
+	return true;
+}
+typedef struct
+{
+	double T;
+	TTileItem *Item;
+} SweptHit;
+#define SWEPT_MAX_HITS 32
+static bool SweptHitBefore(const SweptHit *a, const SweptHit *b)
+{
+	if (a->T != b->T) return a->T < b->T;
+	if (a->Item->kind != b->Item->kind) return a->Item->kind < b->Item->kind;
+	return a->Item->id < b->Item->id;
+}
+void CollideTileItemsSwept(
+	const TTileItem *item, const Vec2i from, const Vec2i to,
+	const int mask, const CollisionTeam team, const bool isPVP,
+	CollideItemFunc func, void *data)
+{
+	// Gather hits from all the tiles around the segment, sorted by time of
+	// first contact, then call back in that order
+	SweptHit hits[SWEPT_MAX_HITS];
+	int numHits = 0;
+	const Vec2i tStart = Vec2iToTile(from);
+	const Vec2i tEnd = Vec2iToTile(to);
+	Vec2i tv;
+	for (tv.y = MIN(tStart.y, tEnd.y) - 1; tv.y <= MAX(tStart.y, tEnd.y) + 1;
+		tv.y++)
+	{
+		for (tv.x = MIN(tStart.x, tEnd.x) - 1;
+			tv.x <= MAX(tStart.x, tEnd.x) + 1;
+			tv.x++)
+		{
+			if (!MapIsTileIn(&gMap, tv))
+			{
+				continue;
+			}
+			CArray *tileThings = &MapGetTile(&gMap, tv)->things;
+			for (int i = 0; i < (int)tileThings->size; i++)
+			{
+				TTileItem *ti = ThingIdGetTileItem(CArrayGet(tileThings, i));
+				if (CollisionIsOnSameTeam(ti, team, isPVP)) continue;
+				if (item == ti) continue;
+				if (mask != 0 && !(ti->flags & mask)) continue;
+				const Vec2i r = Vec2iScaleDiv(Vec2iAdd(item->size, ti->size), 2);
+				SweptHit h;
+				h.Item = ti;
+				if (!SegmentEntersBox(
+					from, to, Vec2iNew(ti->x, ti->y), r, &h.T))
+				{
+					continue;
+				}
+				// Already overlapping at the start; keep the end position
+				// test so items aren't hit again while moving away
+				if (h.T <= 0 && !ItemsCollide(item, ti, to)) continue;
+				// Insert in order; drop the furthest if full
+				if (numHits == SWEPT_MAX_HITS)
+				{
+					if (!SweptHitBefore(&h, &hits[numHits - 1])) continue;
+					numHits--;
+				}
+				int j = numHits;
+				while (j > 0 && SweptHitBefore(&h, &hits[j - 1]))
+				{
+					hits[j] = hits[j - 1];
+					j--;
+				}
+				hits[j] = h;
+				numHits++;
+			}
+		}
+	}
+	for (int i = 0; i < numHits; i++)
+	{
+		if (!func(hits[i].Item, data))
+		{
+			return;
+		}
+	}
+}
 static bool CollideGetFirstItemCallback(TTileItem *ti, void *data);
 TTileItem *CollideGetFirstItem(
 	const TTileItem *item, const Vec2i pos,
@@ -315,6 +364,20 @@ TTileItem *OverlapGetFirstItem(
 	return NULL;
 }
 
+Vec2i GetWallSweepFullPos(const Vec2i startFull, const Vec2i newFull)
+{
+	const Vec2i startReal = Vec2iFull2Real(startFull);
+	const Vec2i newReal = Vec2iFull2Real(newFull);
+	const WallPlane w = MapWallPlane(&gMap, MAP_PLANE_NO_SHOOT);
+	Vec2i hit;
+	if (!WallPlaneRaycast(&w, startReal, newReal, &hit) ||
+		Vec2iEqual(Vec2iToTile(hit), Vec2iToTile(newReal)))
+	{
+		return newFull;
+	}
+	return Vec2iReal2FullCentered(hit);
+}
+
 Vec2i GetWallBounceFullPos(
 	const Vec2i startFull, const Vec2i newFull, Vec2i *velFull)
 {
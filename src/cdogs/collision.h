@@ -60,8 +60,10 @@ extern CollisionSystem gCollisionSystem;
 
 void CollisionSystemInit(CollisionSystem *cs);
 
-#define HitWall(x, y) (MapGetTile(&gMap, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))->flags & MAPTILE_NO_WALK)
-#define ShootWall(x, y) (MapGetTile(&gMap, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))->flags & MAPTILE_NO_SHOOT)
+#define HitWall(x, y) MapPlaneGet(\
+	&gMap, MAP_PLANE_NO_WALK, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))
+#define ShootWall(x, y) MapPlaneGet(\
+	&gMap, MAP_PLANE_NO_SHOOT, Vec2iNew((x)/TILE_WIDTH, (y)/TILE_HEIGHT))
 
 // Which "team" the actor's on, for collision
 // Actors on the same team don't have to collide
@@ -87,6 +89,13 @@ void CollideTileItems(
 	const TTileItem *item, const Vec2i pos,
 	const int mask, const CollisionTeam team, const bool isPVP,
 	CollideItemFunc func, void *data);
+// As CollideTileItems, but for an item moving from one position to another
+// this step; callbacks are made in order of contact along the way, with
+// ties broken by kind and id
+void CollideTileItemsSwept(
+	const TTileItem *item, const Vec2i from, const Vec2i to,
+	const int mask, const CollisionTeam team, const bool isPVP,
+	CollideItemFunc func, void *data);
 // Get the first TTileItem in collision
 TTileItem *CollideGetFirstItem(
 	const TTileItem *item, const Vec2i pos,
@@ -100,6 +109,9 @@ TTileItem *OverlapGetFirstItem(
 bool AreasCollide(
 	const Vec2i pos1, const Vec2i pos2, const Vec2i size1, const Vec2i size2);
 
+// Shorten a move so that it stops in the first shoot-blocking tile on the
+// way, so fast movers can't pass through thin walls
+Vec2i GetWallSweepFullPos(const Vec2i startFull, const Vec2i newFull);
 // Resolve wall bounces
 Vec2i GetWallBounceFullPos(
 	const Vec2i startFull, const Vec2i newFull, Vec2i *velFull);
@@ -191,6 +191,59 @@ color_t ColorTint(color_t c, HSV hsv)
 	return out;
 }
 
+void ColorTintLUTInit(ColorTintLUT *l, const HSV hsv)
+{
+	l->Channel = NULL;
+	if (hsv.s <= 0.0 || hsv.h >= 0)
+	{
+		// A grey colour has its own average
+		for (int i = 0; i < 256; i++)
+		{
+			const color_t grey = { (uint8_t)i, (uint8_t)i, (uint8_t)i, 255 };
+			const color_t out = ColorTint(grey, hsv);
+			l->Average[0][i] = out.r;
+			l->Average[1][i] = out.g;
+			l->Average[2][i] = out.b;
+		}
+		return;
+	}
+	// Same expression as ColorTint, for the same rounding
+	CMALLOC(l->Channel, 256 * 256);
+	for (int vAvg = 0; vAvg < 256; vAvg++)
+	{
+		for (int c = 0; c < 256; c++)
+		{
+			l->Channel[vAvg * 256 + c] = (uint8_t)CLAMP(
+				hsv.v * (vAvg*(1.0-hsv.s) + hsv.s*c), 0, 255);
+		}
+	}
+}
+void ColorTintLUTTerminate(ColorTintLUT *l)
+{
+	CFREE(l->Channel);
+	l->Channel = NULL;
+}
+color_t ColorTintLUTApply(const ColorTintLUT *l, const color_t c)
+{
+	const int vAvg = ((int)c.r + c.g + c.b) / 3;
+	color_t out;
+	if (l->Channel == NULL)
+	{
+		out.r = l->Average[0][vAvg];
+		out.g = l->Average[1][vAvg];
+		out.b = l->Average[2][vAvg];
+	}
+	else
+	{
+		const uint8_t *row = l->Channel + vAvg * 256;
+		out.r = row[c.r];
+		out.g = row[c.g];
+		out.b = row[c.b];
+	}
+	out.a = c.a;
+	return out;
+}
+
 bool ColorEquals(const color_t a, const color_t b)
 {
 	return a.r == b.r && a.g == b.g && a.b == b.b;
@@ -109,6 +109,19 @@ extern HSV tintDarker;
 // s: saturation, where all RGB components are shifted towards the average value
 // v: scale factor on the final components
 color_t ColorTint(color_t c, HSV hsv);
+// ColorTint for one tint, precomputed to tint many colours with lookups;
+// gives the same results as ColorTint
+typedef struct
+{
+	// Hue and grey tints only depend on the average of r, g and b
+	uint8_t Average[3][256];
+	// Saturation tints also depend on each channel; indexed by
+	// average * 256 + channel, or NULL if not needed
+	uint8_t *Channel;
+} ColorTintLUT;
+void ColorTintLUTInit(ColorTintLUT *l, const HSV hsv);
+void ColorTintLUTTerminate(ColorTintLUT *l);
+color_t ColorTintLUTApply(const ColorTintLUT *l, const color_t c);
 
 bool ColorEquals(const color_t a, const color_t b);
 bool HSVEquals(const HSV a, const HSV b);
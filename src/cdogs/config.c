@@ -313,21 +313,24 @@ int ConfigGetVersion(FILE *f)
 	return ConfigGetJSONVersion(f);
 }
 
+// Walks the dotted name in place, without copying or strtok, so that
+// lookups can be made from several threads at once, e.g. while drawing
 Config *ConfigGet(Config *c, const char *name)
 {
-	char *nameCopy;
-	CSTRDUP(nameCopy, name);
-	char *pch = strtok(nameCopy, ".");
-	while (pch != NULL)
+	const char *pch = name;
+	while (*pch != '\0')
 	{
+		const char *dot = strchr(pch, '.');
+		const size_t len = dot != NULL ? (size_t)(dot - pch) : strlen(pch);
 		if (c->Type != CONFIG_TYPE_GROUP)
 		{
 			CASSERT(false, "Invalid config type");
-			goto bail;
+			return c;
 		}
 		bool found = false;
 		CA_FOREACH(Config, child, c->u.Group)
-			if (strcmp(child->Name, pch) == 0)
+			if (strncmp(child->Name, pch, len) == 0 &&
+				child->Name[len] == '\0')
 			{
 				c = child;
 				found = true;
@@ -337,12 +340,14 @@ Config *ConfigGet(Config *c, const char *name)
 		if (!found)
 		{
 			CASSERT(false, "Config not found");
-			goto bail;
+			return c;
+		}
+		pch += len;
+		if (*pch == '.')
+		{
+			pch++;
 		}
-		pch = strtok(NULL, ".");
 	}
-bail:
-	CFREE(nameCopy);
 	return c;
 }
 
@@ -641,6 +646,9 @@ Config ConfigDefault(void)
 	ConfigGroupAdd(&gfx, ConfigNewEnum(
 		"Gore", GORE_LOW, GORE_NONE, GORE_HIGH, StrGoreAmount, GoreAmountStr));
 	ConfigGroupAdd(&gfx, ConfigNewBool("Brass", true));
+	// Threads that draw the map; 0 uses one per CPU
+	ConfigGroupAdd(&gfx,
+		ConfigNewInt("RenderThreads", 0, 0, 16, 1, NULL, NULL));
 	ConfigGroupAdd(&root, gfx);
 
 	Config input = ConfigNewGroup("Input");
@@ -169,7 +169,7 @@ static TWatch *CreateCloseDoorWatch(
 	const bool isHorizontal, const int doorGroupCount,
 	const char *picAltName)
 {
-	TWatch *w = WatchNew();
+	TWatch *w = WatchNew(&map->arena);
 	const Vec2i dv = Vec2iNew(isHorizontal ? 1 : 0, isHorizontal ? 0 : 1);
 	const Vec2i dAside = Vec2iNew(dv.y, dv.x);
 
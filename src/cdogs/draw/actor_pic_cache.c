@@ -0,0 +1,310 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "draw/actor_pic_cache.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+#define NUM_BUCKETS 256
+
+typedef struct
+{
+	ActorPicKey Key;
+	Uint32 Hash;
+	Pic Pic;
+	int LastFrame;
+	// LRU list and bucket chain, by entry index; -1 for none.
+	// Unused entries are chained from Free by Next.
+	int Prev;
+	int Next;
+	int BucketNext;
+} ActorPicCacheEntry;
+
+ActorPicCache gActorPicCache;
+
+void ActorPicCacheInit(ActorPicCache *c, const size_t maxBytes)
+{
+	memset(c, 0, sizeof *c);
+	CArrayInit(&c->Entries, sizeof(ActorPicCacheEntry));
+	CMALLOC(c->Buckets, NUM_BUCKETS * sizeof *c->Buckets);
+	c->MaxBytes = maxBytes;
+	c->Head = -1;
+	ActorPicCacheClear(c);
+}
+void ActorPicCacheTerminate(ActorPicCache *c)
+{
+	ActorPicCacheClear(c);
+	CArrayTerminate(&c->Entries);
+	CFREE(c->Buckets);
+}
+
+void ActorPicCacheClear(ActorPicCache *c)
+{
+	for (int i = c->Head; i >= 0;)
+	{
+		ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+		PicFree(&e->Pic);
+		i = e->Next;
+	}
+	CArrayClear(&c->Entries);
+	for (int i = 0; i < NUM_BUCKETS; i++)
+	{
+		c->Buckets[i] = -1;
+	}
+	c->Head = c->Tail = c->Free = -1;
+	c->Bytes = 0;
+}
+
+void ActorPicCacheNewFrame(ActorPicCache *c, const int generation)
+{
+	if (generation != c->Generation)
+	{
+		ActorPicCacheClear(c);
+		c->Generation = generation;
+	}
+	c->Frame++;
+}
+
+// FNV-1a; keys are zeroed before being filled in, so padding is stable
+static Uint32 KeyHash(const ActorPicKey *key)
+{
+	const Uint8 *p = (const Uint8 *)key;
+	Uint32 h = 2166136261u;
+	for (size_t i = 0; i < sizeof *key; i++)
+	{
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return h;
+}
+static int FindIndex(
+	const ActorPicCache *c, const ActorPicKey *key, const Uint32 hash)
+{
+	for (int i = c->Buckets[hash % NUM_BUCKETS]; i >= 0;)
+	{
+		const ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+		if (e->Hash == hash && memcmp(&e->Key, key, sizeof *key) == 0)
+		{
+			return i;
+		}
+		i = e->BucketNext;
+	}
+	return -1;
+}
+
+const Pic *ActorPicCacheFind(const ActorPicCache *c, const ActorPicKey *key)
+{
+	if (c->Buckets == NULL)
+	{
+		return NULL;
+	}
+	const int i = FindIndex(c, key, KeyHash(key));
+	if (i < 0)
+	{
+		return NULL;
+	}
+	const ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+	return &e->Pic;
+}
+
+static void ListRemove(ActorPicCache *c, const int i);
+static void ListPushFront(ActorPicCache *c, const int i);
+static void Evict(ActorPicCache *c, const int i);
+static bool GetBounds(const ActorPicKey *key, Vec2i *pos, Vec2i *size);
+static Pic Composite(
+	const ActorPicKey *key, const Vec2i pos, const Vec2i size);
+const Pic *ActorPicCacheAdd(ActorPicCache *c, const ActorPicKey *key)
+{
+	if (c->Buckets == NULL)
+	{
+		return NULL;
+	}
+	const Uint32 hash = KeyHash(key);
+	int i = FindIndex(c, key, hash);
+	if (i >= 0)
+	{
+		ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+		e->LastFrame = c->Frame;
+		ListRemove(c, i);
+		ListPushFront(c, i);
+		return &e->Pic;
+	}
+
+	Vec2i pos, size;
+	if (!GetBounds(key, &pos, &size))
+	{
+		return NULL;
+	}
+	// Make room, but keep the frames already used this frame since they
+	// will still be drawn
+	const size_t bytes = size.x * size.y * sizeof(Uint32);
+	while (c->Bytes + bytes > c->MaxBytes && c->Tail >= 0)
+	{
+		const ActorPicCacheEntry *tail = CArrayGet(&c->Entries, c->Tail);
+		if (tail->LastFrame == c->Frame)
+		{
+			break;
+		}
+		Evict(c, c->Tail);
+	}
+	if (c->Bytes + bytes > c->MaxBytes)
+	{
+		return NULL;
+	}
+
+	ActorPicCacheEntry *e;
+	if (c->Free >= 0)
+	{
+		i = c->Free;
+		e = CArrayGet(&c->Entries, i);
+		c->Free = e->Next;
+	}
+	else
+	{
+		ActorPicCacheEntry eNew;
+		memset(&eNew, 0, sizeof eNew);
+		CArrayPushBack(&c->Entries, &eNew);
+		i = (int)c->Entries.size - 1;
+		e = CArrayGet(&c->Entries, i);
+	}
+	e->Key = *key;
+	e->Hash = hash;
+	e->Pic = Composite(key, pos, size);
+	e->LastFrame = c->Frame;
+	e->BucketNext = c->Buckets[hash % NUM_BUCKETS];
+	c->Buckets[hash % NUM_BUCKETS] = i;
+	ListPushFront(c, i);
+	c->Bytes += bytes;
+	return &e->Pic;
+}
+static void ListRemove(ActorPicCache *c, const int i)
+{
+	ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+	if (e->Prev >= 0)
+	{
+		((ActorPicCacheEntry *)CArrayGet(&c->Entries, e->Prev))->Next =
+			e->Next;
+	}
+	else
+	{
+		c->Head = e->Next;
+	}
+	if (e->Next >= 0)
+	{
+		((ActorPicCacheEntry *)CArrayGet(&c->Entries, e->Next))->Prev =
+			e->Prev;
+	}
+	else
+	{
+		c->Tail = e->Prev;
+	}
+}
+static void ListPushFront(ActorPicCache *c, const int i)
+{
+	ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+	e->Prev = -1;
+	e->Next = c->Head;
+	if (c->Head >= 0)
+	{
+		((ActorPicCacheEntry *)CArrayGet(&c->Entries, c->Head))->Prev = i;
+	}
+	else
+	{
+		c->Tail = i;
+	}
+	c->Head = i;
+}
+static void Evict(ActorPicCache *c, const int i)
+{
+	ActorPicCacheEntry *e = CArrayGet(&c->Entries, i);
+	// Unlink from its bucket
+	int *link = &c->Buckets[e->Hash % NUM_BUCKETS];
+	while (*link != i)
+	{
+		link = &((ActorPicCacheEntry *)CArrayGet(&c->Entries, *link))
+			->BucketNext;
+	}
+	*link = e->BucketNext;
+	ListRemove(c, i);
+	c->Bytes -= e->Pic.size.x * e->Pic.size.y * sizeof(Uint32);
+	PicFree(&e->Pic);
+	e->Next = c->Free;
+	c->Free = i;
+}
+
+static bool GetBounds(const ActorPicKey *key, Vec2i *pos, Vec2i *size)
+{
+	bool hasParts = false;
+	Vec2i min = Vec2iZero(), max = Vec2iZero();
+	for (int i = 0; i < ACTOR_PIC_PARTS_MAX; i++)
+	{
+		const Pic *p = key->Pics[i];
+		if (p == NULL || PicIsNone(p))
+		{
+			continue;
+		}
+		const Vec2i partPos = Vec2iAdd(key->Offsets[i], p->offset);
+		const Vec2i partEnd = Vec2iAdd(partPos, p->size);
+		min = hasParts ? Vec2iMin(min, partPos) : partPos;
+		max = hasParts ? Vec2iMax(max, partEnd) : partEnd;
+		hasParts = true;
+	}
+	*pos = min;
+	*size = Vec2iMinus(max, min);
+	return hasParts;
+}
+// Draw the parts into a pic the way they would be drawn to the screen
+static Pic Composite(
+	const ActorPicKey *key, const Vec2i pos, const Vec2i size)
+{
+	Pic pic;
+	memset(&pic, 0, sizeof pic);
+	pic.size = size;
+	pic.offset = pos;
+	CCALLOC(pic.Data, size.x * size.y * sizeof *pic.Data);
+	GraphicsDevice g;
+	memset(&g, 0, sizeof g);
+	g.Format = gGraphicsDevice.Format;
+	g.cachedConfig.Res = size;
+	g.buf = pic.Data;
+	g.clipping.right = size.x - 1;
+	g.clipping.bottom = size.y - 1;
+	for (int i = 0; i < ACTOR_PIC_PARTS_MAX; i++)
+	{
+		const Pic *p = key->Pics[i];
+		if (p == NULL || PicIsNone(p))
+		{
+			continue;
+		}
+		BlitCharMultichannel(
+			&g, p, Vec2iMinus(key->Offsets[i], pos), &key->Colors);
+	}
+	PicUpdateSpans(&pic);
+	return pic;
+}
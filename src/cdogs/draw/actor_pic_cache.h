@@ -0,0 +1,80 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "blit.h"
+#include "c_array.h"
+#include "pic.h"
+
+// Pixel memory for composited actor pics; about a thousand 32x32 frames
+#define ACTOR_PIC_CACHE_MAX_BYTES (4 * 1024 * 1024)
+#define ACTOR_PIC_PARTS_MAX 4
+
+// The coloured body parts that make up one actor frame, in draw order.
+// The part pics identify the character sprites, direction and animation
+// frame. Zero the key before filling it in; unused parts are NULL.
+typedef struct
+{
+	const Pic *Pics[ACTOR_PIC_PARTS_MAX];
+	Vec2i Offsets[ACTOR_PIC_PARTS_MAX];
+	CharColors Colors;
+} ActorPicKey;
+
+// LRU cache of actor frames with their parts composited and coloured into
+// one pic, so that a visible actor takes one blit instead of one
+// multichannel blit per part.
+// Frames are added serially, before drawing; lookups only read the cache,
+// so they can run in parallel render jobs. Until it is initialised, the
+// cache is empty and adds do nothing.
+typedef struct
+{
+	CArray Entries;	// of ActorPicCacheEntry
+	int *Buckets;
+	int Head;	// most recently used
+	int Tail;
+	int Free;
+	size_t Bytes;
+	size_t MaxBytes;
+	int Frame;
+	int Generation;
+} ActorPicCache;
+
+extern ActorPicCache gActorPicCache;
+
+void ActorPicCacheInit(ActorPicCache *c, const size_t maxBytes);
+void ActorPicCacheTerminate(ActorPicCache *c);
+void ActorPicCacheClear(ActorPicCache *c);
+// Start drawing a frame; frames used since are not evicted until the next
+// one. The cache is cleared if the generation, such as the map load ID,
+// has changed, since the part pics may have been reloaded.
+void ActorPicCacheNewFrame(ActorPicCache *c, const int generation);
+// Composite the frame if it is not cached yet; returns NULL if it does not
+// fit. The pic is valid until the next add.
+const Pic *ActorPicCacheAdd(ActorPicCache *c, const ActorPicKey *key);
+const Pic *ActorPicCacheFind(const ActorPicCache *c, const ActorPicKey *key);
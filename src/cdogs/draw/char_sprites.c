@@ -43,9 +43,11 @@ CharSpriteClasses gCharSpriteClasses;
 const CharSprites *StrCharSpriteClass(const char *s)
 {
 	CharSprites *c;
-	int error = hashmap_get(gCharSpriteClasses.customClasses, s, (any_t *)&c);
+	const unsigned int hash = hashmap_hash_key(s);
+	int error = hashmap_get_hashed(
+		gCharSpriteClasses.customClasses, s, hash, (any_t *)&c);
 	if (error == MAP_OK) return c;
-	error = hashmap_get(gCharSpriteClasses.classes, s, (any_t *)&c);
+	error = hashmap_get_hashed(gCharSpriteClasses.classes, s, hash, (any_t *)&c);
 	if (error == MAP_OK) return c;
 	return NULL;
 }
@@ -61,6 +63,7 @@ void CharSpriteClassesInit(CharSpriteClasses *c)
 }
 
 static CharSprites *CharSpritesLoadJSON(const char *name, const char *path);
+static void AddCharSprites(map_t classes, CharSprites *c);
 void CharSpriteClassesLoadDir(map_t classes, const char *path)
 {
 	char buf[CDOGS_PATH_MAX];
@@ -84,24 +87,74 @@ void CharSpriteClassesLoadDir(map_t classes, const char *path)
 		{
 			continue;
 		}
-		CharSprites *c = CharSpritesLoadJSON(file.name, file.path);
-		if (c == NULL)
+		AddCharSprites(classes, CharSpritesLoadJSON(file.name, file.path));
+	}
+
+bail:
+	tinydir_close(&dir);
+}
+static CharSprites *CharSpritesFromJSON(const char *name, yajl_val node);
+void CharSpriteClassesLoadPack(map_t classes, MapPack *pack)
+{
+	static const char *dir = "graphics/chars/bodies/";
+	const size_t dirLen = strlen(dir);
+	CA_FOREACH(const MapPackMember, m, pack->Members)
+		// Look for graphics/chars/bodies/<name>/data.json
+		if (strncmp(m->Name, dir, dirLen) != 0)
 		{
 			continue;
 		}
-		const int error = hashmap_put(classes, file.name, c);
-		if (error != MAP_OK)
+		const char *slash = strchr(m->Name + dirLen, '/');
+		if (slash == NULL || strcmp(slash, "/data.json") != 0 ||
+			slash == m->Name + dirLen || m->Name[dirLen] == '.')
+		{
+			continue;
+		}
+		char name[CDOGS_FILENAME_MAX];
+		const size_t nameLen = slash - m->Name - dirLen;
+		if (nameLen >= sizeof name)
 		{
-			LOG(LM_MAIN, LL_ERROR, "failed to add char sprites %s: %d",
-				file.name, error);
 			continue;
 		}
+		strncpy(name, m->Name + dirLen, nameLen);
+		name[nameLen] = '\0';
+		size_t size;
+		const char *data = MapPackGet(pack, m->Name, &size);
+		if (data == NULL)
+		{
+			continue;
+		}
+		// The parser needs a terminated string
+		char *buf;
+		CMALLOC(buf, size + 1);
+		memcpy(buf, data, size);
+		buf[size] = '\0';
+		char errbuf[1024];
+		yajl_val node = yajl_tree_parse(buf, errbuf, sizeof errbuf);
+		CFREE(buf);
+		if (node == NULL)
+		{
+			LOG(LM_MAIN, LL_ERROR, "Error parsing char sprite JSON '%s': %s",
+				m->Name, errbuf);
+			continue;
+		}
+		AddCharSprites(classes, CharSpritesFromJSON(name, node));
+		yajl_tree_free(node);
+	CA_FOREACH_END()
+}
+static void AddCharSprites(map_t classes, CharSprites *c)
+{
+	if (c == NULL)
+	{
+		return;
+	}
+	const int error = hashmap_put(classes, c->Name, c);
+	if (error != MAP_OK)
+	{
+		LOG(LM_MAIN, LL_ERROR, "failed to add char sprites %s: %d",
+			c->Name, error);
 	}
-
-bail:
-	tinydir_close(&dir);
 }
-static map_t LoadYOffsets(yajl_val node, const char *path);
 static CharSprites *CharSpritesLoadJSON(const char *name, const char *path)
 {
 	CharSprites *c = NULL;
@@ -120,16 +173,22 @@ static CharSprites *CharSpritesLoadJSON(const char *name, const char *path)
 		LOG(LM_MAIN, LL_ERROR, "Error parsing char sprite JSON '%s'", buf);
 		goto bail;
 	}
+	c = CharSpritesFromJSON(name, node);
 
+bail:
+	yajl_tree_free(node);
+	return c;
+}
+static map_t LoadYOffsets(yajl_val node, const char *path);
+static CharSprites *CharSpritesFromJSON(const char *name, yajl_val node)
+{
+	CharSprites *c;
 	CCALLOC(c, sizeof *c);
 	CSTRDUP(c->Name, name);
 	c->HeadYOffsets = LoadYOffsets(node, "HeadYOffsets");
 	YAJLInt(&c->BodyYOffset, node, "BodyYOffset");
 	YAJLInt(&c->LegsYOffset, node, "LegsYOffset");
 	c->GunYOffsets = LoadYOffsets(node, "GunYOffsets");
-
-bail:
-	yajl_tree_free(node);
 	return c;
 }
 static map_t LoadYOffsets(yajl_val node, const char *path)
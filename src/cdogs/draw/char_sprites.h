@@ -28,6 +28,7 @@
 #pragma once
 
 #include "c_hashmap/hashmap.h"
+#include "map_pack.h"
 
 typedef struct
 {
@@ -48,6 +49,7 @@ const CharSprites *StrCharSpriteClass(const char *s);
 
 void CharSpriteClassesInit(CharSpriteClasses *c);
 void CharSpriteClassesLoadDir(map_t classes, const char *path);
+void CharSpriteClassesLoadPack(map_t classes, MapPack *pack);
 void CharSpriteClassesClear(map_t classes);
 void CharSpriteClassesTerminate(CharSpriteClasses *c);
 
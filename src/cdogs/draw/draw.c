@@ -54,9 +54,11 @@
 #include "actors.h"
 #include "algorithms.h"
 #include "config.h"
+#include "draw/actor_pic_cache.h"
 #include "draw/draw_actor.h"
 #include "draw_highlight.h"
 #include "draw/drawtools.h"
+#include "draw/map_layer.h"
 #include "font.h"
 #include "game_events.h"
 #include "net_util.h"
@@ -90,7 +92,7 @@ static TileLOS GetTileLOS(const Tile *tile, const bool useFog)
 	}
 	return TILE_LOS_NORMAL;
 }
-void DrawWallColumn(int y, Vec2i pos, Tile *tile)
+static void DrawWallColumn(GraphicsDevice *g, int y, Vec2i pos, Tile *tile)
 {
 	const bool useFog = ConfigGetBool(&gConfig, "Game.Fog");
 	while (y >= 0 && (tile->flags & MAPTILE_IS_WALL))
@@ -98,10 +100,10 @@ void DrawWallColumn(int y, Vec2i pos, Tile *tile)
 		switch (GetTileLOS(tile, useFog))
 		{
 		case TILE_LOS_NORMAL:
-			Blit(&gGraphicsDevice, &tile->pic->pic, pos);
+			Blit(g, &tile->pic->pic, pos);
 			break;
 		case TILE_LOS_FOG:
-			BlitMasked(&gGraphicsDevice, &tile->pic->pic, pos, colorFog, false);
+			BlitMasked(g, &tile->pic->pic, pos, colorFog, false);
 			break;
 		case TILE_LOS_NONE:
 		default:
@@ -121,6 +123,67 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset);
 static void DrawExtra(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra);
 
 void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
+{
+	ActorPicCacheNewFrame(&gActorPicCache, gMap.LoadId);
+	DrawBufferPrepare(b);
+	DrawBufferDrawWorld(b, offset);
+	DrawBufferDrawOverlays(b, offset);
+	// Draw editor-only things
+	if (extra)
+	{
+		DrawExtra(b, offset, extra);
+	}
+}
+
+static TileLOS GetFloorLOS(const Tile *tile, const bool useFog);
+void DrawBufferPrepare(DrawBuffer *b)
+{
+	const bool useFog = ConfigGetBool(&gConfig, "Game.Fog");
+	const Tile *tile = &b->tiles[0][0];
+	size_t maxRowThings = 0;
+	for (int y = 0; y < Y_TILES; y++)
+	{
+		size_t rowThings = 0;
+		for (int x = 0; x < b->Size.x; x++, tile++)
+		{
+			rowThings += tile->things.size;
+			// Composite visible actors now, so that drawing only reads them
+			if (!(tile->flags & MAPTILE_OUT_OF_SIGHT))
+			{
+				CA_FOREACH(ThingId, tid, tile->things)
+					const TTileItem *ti = ThingIdGetTileItem(tid);
+					if (ti->kind == KIND_CHARACTER)
+					{
+						const ActorPics pics = GetCharacterPicsFromActor(
+							CArrayGet(&gActors, ti->id));
+						CacheActorPics(&pics);
+					}
+				CA_FOREACH_END()
+			}
+			if (b->Layer == NULL)
+			{
+				continue;
+			}
+			// Render floor chunks now, so that drawing only reads them
+			const TileLOS los = GetFloorLOS(tile, useFog);
+			if (los != TILE_LOS_NONE)
+			{
+				MapLayerGetChunk(
+					b->Layer, &gMap,
+					Vec2iNew(
+						(b->xStart + x) / MAP_CHUNK_SIZE,
+						(b->yStart + y) / MAP_CHUNK_SIZE),
+					los == TILE_LOS_FOG);
+			}
+		}
+		maxRowThings = MAX(maxRowThings, rowThings);
+		tile += X_TILES - b->Size.x;
+	}
+	b->MaxRowThings = maxRowThings;
+	DisplayListReserve(&b->displaylist, maxRowThings);
+}
+
+void DrawBufferDrawWorld(DrawBuffer *b, const Vec2i offset)
 {
 	// First draw the floor tiles (which do not obstruct anything)
 	DrawFloor(b, offset);
@@ -128,19 +191,95 @@ void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra)
 	DrawDebris(b, offset);
 	// Now draw walls and (non-wreck) things in proper order
 	DrawWallsAndThings(b, offset);
+}
+
+void DrawBufferDrawOverlays(DrawBuffer *b, const Vec2i offset)
+{
 	// Draw objective highlights, for visible and always-visible objectives
 	DrawObjectiveHighlights(b, offset);
 	// Draw actor chatter
 	DrawChatters(b, offset);
-	// Draw editor-only things
-	if (extra)
+}
+
+static TileLOS GetFloorLOS(const Tile *tile, const bool useFog)
+{
+	if (tile->pic == NULL || tile->pic->pic.Data == NULL ||
+		(tile->flags & MAPTILE_IS_WALL))
 	{
-		DrawExtra(b, offset, extra);
+		return TILE_LOS_NONE;
+	}
+	return GetTileLOS(tile, useFog);
+}
+// Copy the floor from the cached map layer, one row copy per scanline for
+// each run of tiles in the same chunk and with the same visibility
+static void DrawFloorCached(DrawBuffer *b, const Vec2i offset)
+{
+	GraphicsDevice *g = b->g;
+	const bool useFog = ConfigGetBool(&gConfig, "Game.Fog");
+	Vec2i pos;
+	pos.y = b->dy + offset.y;
+	for (int y = 0; y < Y_TILES; y++, pos.y += TILE_HEIGHT)
+	{
+		const int y0 = MAX(pos.y, g->clipping.top);
+		const int y1 = MIN(pos.y + TILE_HEIGHT - 1, g->clipping.bottom);
+		if (y0 > y1)
+		{
+			continue;
+		}
+		const Tile *row = &b->tiles[0][0] + y * b->OrigSize.x;
+		const int mapY = b->yStart + y;
+		int x = 0;
+		while (x < b->Size.x)
+		{
+			const TileLOS los = GetFloorLOS(&row[x], useFog);
+			const int chunkX = (b->xStart + x) / MAP_CHUNK_SIZE;
+			int end = x + 1;
+			while (end < b->Size.x &&
+				GetFloorLOS(&row[end], useFog) == los &&
+				(b->xStart + end) / MAP_CHUNK_SIZE == chunkX)
+			{
+				end++;
+			}
+			if (los != TILE_LOS_NONE)
+			{
+				// Only tiles in the map have pics, so this run is in one
+				// chunk of the map
+				const Uint32 *chunk = MapLayerGetChunk(
+					b->Layer, &gMap,
+					Vec2iNew(chunkX, mapY / MAP_CHUNK_SIZE),
+					los == TILE_LOS_FOG);
+				const int runX = b->dx + offset.x + x * TILE_WIDTH;
+				const int x0 = MAX(runX, g->clipping.left);
+				const int x1 = MIN(
+					runX + (end - x) * TILE_WIDTH - 1, g->clipping.right);
+				if (x0 <= x1)
+				{
+					const int srcX =
+						((b->xStart + x) % MAP_CHUNK_SIZE) * TILE_WIDTH +
+						x0 - runX;
+					const int srcY =
+						(mapY % MAP_CHUNK_SIZE) * TILE_HEIGHT + y0 - pos.y;
+					for (int sy = y0; sy <= y1; sy++)
+					{
+						memcpy(
+							g->buf + sy * g->cachedConfig.Res.x + x0,
+							chunk + (srcY + sy - y0) * MAP_LAYER_CHUNK_W + srcX,
+							(x1 - x0 + 1) * sizeof *g->buf);
+					}
+				}
+			}
+			x = end;
+		}
 	}
 }
 
 static void DrawFloor(DrawBuffer *b, Vec2i offset)
 {
+	if (b->Layer != NULL)
+	{
+		DrawFloorCached(b, offset);
+		return;
+	}
 	int x, y;
 	Vec2i pos;
 	const Tile *tile = &b->tiles[0][0];
@@ -159,11 +298,11 @@ static void DrawFloor(DrawBuffer *b, Vec2i offset)
 				switch (GetTileLOS(tile, useFog))
 				{
 				case TILE_LOS_NORMAL:
-					Blit(&gGraphicsDevice, &tile->pic->pic, pos);
+					Blit(b->g, &tile->pic->pic, pos);
 					break;
 				case TILE_LOS_FOG:
 					BlitMasked(
-						&gGraphicsDevice,
+						b->g,
 						&tile->pic->pic,
 						pos,
 						colorFog,
@@ -187,7 +326,7 @@ static void DrawDebris(DrawBuffer *b, Vec2i offset)
 	Tile *tile = &b->tiles[0][0];
 	for (int y = 0; y < Y_TILES; y++)
 	{
-		CArrayClear(&b->displaylist);
+		CArrayClear(&b->displaylist.Items);
 		for (int x = 0; x < b->Size.x; x++, tile++)
 		{
 			if (tile->flags & MAPTILE_OUT_OF_SIGHT)
@@ -198,12 +337,12 @@ static void DrawDebris(DrawBuffer *b, Vec2i offset)
 				const TTileItem *ti = ThingIdGetTileItem(tid);
 				if (TileItemDrawLast(ti))
 				{
-					CArrayPushBack(&b->displaylist, &ti);
+					CArrayPushBack(&b->displaylist.Items, &ti);
 				}
 			CA_FOREACH_END()
 		}
 		DrawBufferSortDisplayList(b);
-		CA_FOREACH(const TTileItem *, tp, b->displaylist)
+		CA_FOREACH(const TTileItem *, tp, b->displaylist.Items)
 			DrawThing(b, *tp, offset);
 		CA_FOREACH_END()
 		tile += X_TILES - b->Size.x;
@@ -219,7 +358,7 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 	const bool useFog = ConfigGetBool(&gConfig, "Game.Fog");
 	for (int y = 0; y < Y_TILES; y++, pos.y += TILE_HEIGHT)
 	{
-		CArrayClear(&b->displaylist);
+		CArrayClear(&b->displaylist.Items);
 		pos.x = b->dx + offset.x;
 		for (int x = 0; x < b->Size.x; x++, tile++, pos.x += TILE_WIDTH)
 		{
@@ -227,7 +366,7 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 			{
 				if (!(tile->flags & MAPTILE_DELAY_DRAW))
 				{
-					DrawWallColumn(y, pos, tile);
+					DrawWallColumn(b->g, y, pos, tile);
 				}
 			}
 			else if (tile->flags & MAPTILE_OFFSET_PIC)
@@ -245,11 +384,11 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 				switch (GetTileLOS(tile, useFog))
 				{
 				case TILE_LOS_NORMAL:
-					Blit(&gGraphicsDevice, &tile->picAlt->pic, doorPos);
+					Blit(b->g, &tile->picAlt->pic, doorPos);
 					break;
 				case TILE_LOS_FOG:
 					BlitMasked(
-						&gGraphicsDevice,
+						b->g,
 						&tile->picAlt->pic,
 						doorPos,
 						colorFog,
@@ -274,11 +413,11 @@ static void DrawWallsAndThings(DrawBuffer *b, Vec2i offset)
 				{
 					continue;
 				}
-				CArrayPushBack(&b->displaylist, &ti);
+				CArrayPushBack(&b->displaylist.Items, &ti);
 			CA_FOREACH_END()
 		}
 		DrawBufferSortDisplayList(b);
-		CA_FOREACH(const TTileItem *, tp, b->displaylist)
+		CA_FOREACH(const TTileItem *, tp, b->displaylist.Items)
 			DrawThing(b, *tp, offset);
 		CA_FOREACH_END()
 		tile += X_TILES - b->Size.x;
@@ -291,7 +430,7 @@ static void DrawThing(DrawBuffer *b, const TTileItem *t, const Vec2i offset)
 
 	if (!Vec2iIsZero(t->ShadowSize))
 	{
-		DrawShadow(&gGraphicsDevice, picPos, t->ShadowSize);
+		DrawShadow(b->g, picPos, t->ShadowSize);
 	}
 
 	if (t->CPicFunc)
@@ -303,19 +442,19 @@ static void DrawThing(DrawBuffer *b, const TTileItem *t, const Vec2i offset)
 	{
 		Vec2i picOffset;
 		const Pic *pic = t->getPicFunc(t->id, &picOffset);
-		Blit(&gGraphicsDevice, pic, Vec2iAdd(picPos, picOffset));
+		Blit(b->g, pic, Vec2iAdd(picPos, picOffset));
 	}
 	else if (t->kind == KIND_CHARACTER)
 	{
 		TActor *a = CArrayGet(&gActors, t->id);
 		ActorPics pics = GetCharacterPicsFromActor(a);
-		DrawActorPics(&pics, picPos);
+		DrawActorPics(b->g, &pics, picPos);
 		// Draw weapon indicators
-		DrawLaserSight(&pics, a, picPos);
+		DrawLaserSight(b->g, &pics, a, picPos);
 	}
 	else
 	{
-		(*(t->drawFunc))(picPos, &t->drawData);
+		(*(t->drawFunc))(b->g, picPos, &t->drawData);
 	}
 }
 
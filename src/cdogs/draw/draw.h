@@ -53,3 +53,19 @@
 #include "grafx_bg.h"
 
 void DrawBufferDraw(DrawBuffer *b, Vec2i offset, GrafxDrawExtra *extra);
+
+// DrawBufferDraw in steps, so that the world can be drawn by several
+// threads at once, e.g. one per screen band:
+// - DrawBufferPrepare runs first, on one thread; it renders the floor
+//   chunks the buffer needs, composites visible actors into the actor pic
+//   cache and reserves its display list. Start the frame with
+//   ActorPicCacheNewFrame before preparing its buffers
+// - DrawBufferDrawWorld draws the floor, walls and things. It only reads
+//   shared state and writes within b->g's clipping, so parallel calls need
+//   their own device copy (for the clipping) and display list,
+//   reserved to at least b->MaxRowThings
+// - DrawBufferDrawOverlays draws objective highlights and chatter
+//   to the global device, on one thread
+void DrawBufferPrepare(DrawBuffer *b);
+void DrawBufferDrawWorld(DrawBuffer *b, const Vec2i offset);
+void DrawBufferDrawOverlays(DrawBuffer *b, const Vec2i offset);
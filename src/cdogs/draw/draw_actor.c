@@ -56,6 +56,7 @@
 #include "actors.h"
 #include "algorithms.h"
 #include "config.h"
+#include "draw/actor_pic_cache.h"
 #include "draw/drawtools.h"
 #include "font.h"
 #include "game_events.h"
@@ -275,15 +276,67 @@ static Character *ActorGetCharacterMutable(TActor *a)
 	return CArrayGet(&gCampaign.Setting.characters.OtherChars, a->charId);
 }
 
+static const Pic *GetBodyPart(
+	const ActorPics *pics, const BodyPart part, Vec2i *offset)
+{
+	switch (part)
+	{
+	case BODY_PART_HEAD:
+		*offset = pics->HeadOffset;
+		return pics->Head;
+	case BODY_PART_BODY:
+		*offset = pics->BodyOffset;
+		return pics->Body;
+	case BODY_PART_LEGS:
+		*offset = pics->LegsOffset;
+		return pics->Legs;
+	case BODY_PART_GUN:
+		*offset = pics->GunOffset;
+		return pics->Gun;
+	default:
+		*offset = Vec2iZero();
+		return NULL;
+	}
+}
+// Only living, normally coloured actors can be composited, and only with
+// opaque colours, whose coloured pixels can never be empty
+static bool GetActorPicKey(const ActorPics *pics, ActorPicKey *key)
+{
+	if (pics->IsDead || pics->IsTransparent || pics->Mask != NULL ||
+		pics->Colors->Skin.a != 255 || pics->Colors->Arms.a != 255 ||
+		pics->Colors->Body.a != 255 || pics->Colors->Legs.a != 255 ||
+		pics->Colors->Hair.a != 255)
+	{
+		return false;
+	}
+	memset(key, 0, sizeof *key);
+	for (int i = 0; i < BODY_PART_COUNT; i++)
+	{
+		key->Pics[i] =
+			GetBodyPart(pics, pics->DrawOrder[i], &key->Offsets[i]);
+	}
+	key->Colors = *pics->Colors;
+	return true;
+}
+void CacheActorPics(const ActorPics *pics)
+{
+	ActorPicKey key;
+	if (GetActorPicKey(pics, &key))
+	{
+		ActorPicCacheAdd(&gActorPicCache, &key);
+	}
+}
+
 static void DrawDyingBody(
 	GraphicsDevice *g, const ActorPics *pics, const Vec2i pos);
-void DrawActorPics(const ActorPics *pics, const Vec2i pos)
+void DrawActorPics(
+	GraphicsDevice *g, const ActorPics *pics, const Vec2i pos)
 {
 	if (pics->IsDead)
 	{
 		if (pics->IsDying)
 		{
-			DrawDyingBody(&gGraphicsDevice, pics, pos);
+			DrawDyingBody(g, pics, pos);
 		}
 	}
 	else
@@ -291,59 +344,47 @@ void DrawActorPics(const ActorPics *pics, const Vec2i pos)
 		// Draw shadow
 		if (!pics->IsTransparent)
 		{
-			DrawShadow(&gGraphicsDevice, pos, Vec2iNew(8, 6));
+			DrawShadow(g, pos, Vec2iNew(8, 6));
+		}
+		// Draw the composited actor if it was cached beforehand
+		ActorPicKey key;
+		const Pic *cached = GetActorPicKey(pics, &key) ?
+			ActorPicCacheFind(&gActorPicCache, &key) : NULL;
+		if (cached != NULL)
+		{
+			BlitBackground(g, cached, pos, NULL, true);
+			return;
 		}
 		for (int i = 0; i < BODY_PART_COUNT; i++)
 		{
-			const Pic *picp = NULL;
-			Vec2i drawPos = pos;
-			switch (pics->DrawOrder[i])
-			{
-			case BODY_PART_HEAD:
-				picp = pics->Head;
-				drawPos = Vec2iAdd(pos, pics->HeadOffset);
-				break;
-			case BODY_PART_BODY:
-				picp = pics->Body;
-				drawPos = Vec2iAdd(pos, pics->BodyOffset);
-				break;
-			case BODY_PART_LEGS:
-				picp = pics->Legs;
-				drawPos = Vec2iAdd(pos, pics->LegsOffset);
-				break;
-			case BODY_PART_GUN:
-				picp = pics->Gun;
-				drawPos = Vec2iAdd(pos, pics->GunOffset);
-				break;
-			default:
-				break;
-			}
+			Vec2i offset;
+			const Pic *picp = GetBodyPart(pics, pics->DrawOrder[i], &offset);
 			if (picp == NULL)
 			{
 				continue;
 			}
+			const Vec2i drawPos = Vec2iAdd(pos, offset);
 			if (pics->IsTransparent)
 			{
-				BlitBackground(
-					&gGraphicsDevice, picp, drawPos, pics->Tint, true);
+				BlitBackground(g, picp, drawPos, pics->Tint, true);
 			}
 			else if (pics->Mask != NULL)
 			{
-				BlitMasked(&gGraphicsDevice, picp, drawPos, *pics->Mask, true);
+				BlitMasked(g, picp, drawPos, *pics->Mask, true);
 			}
 			else
 			{
-				BlitCharMultichannel(
-					&gGraphicsDevice, picp, drawPos, pics->Colors);
+				BlitCharMultichannel(g, picp, drawPos, pics->Colors);
 			}
 		}
 	}
 }
 static void DrawLaserSightSingle(
-	const Vec2i from, const double radians, const int range,
-	const color_t color);
+	GraphicsDevice *device, const Vec2i from, const double radians,
+	const int range, const color_t color);
 void DrawLaserSight(
-	const ActorPics *pics, const TActor *a, const Vec2i picPos)
+	GraphicsDevice *device, const ActorPics *pics, const TActor *a,
+	const Vec2i picPos)
 {
 	// Don't draw if dead or transparent
 	if (pics->IsDead || pics->IsTransparent) return;
@@ -367,23 +408,25 @@ void DrawLaserSight(
 		(g->Spread.Count - 1) * g->Spread.Width / 2 + g->Recoil / 2;
 	if (spreadHalf > 0)
 	{
-		DrawLaserSightSingle(muzzlePos, radians - spreadHalf, range, color);
-		DrawLaserSightSingle(muzzlePos, radians + spreadHalf, range, color);
+		DrawLaserSightSingle(
+			device, muzzlePos, radians - spreadHalf, range, color);
+		DrawLaserSightSingle(
+			device, muzzlePos, radians + spreadHalf, range, color);
 	}
 	else
 	{
-		DrawLaserSightSingle(muzzlePos, radians, range, color);
+		DrawLaserSightSingle(device, muzzlePos, radians, range, color);
 	}
 }
 static void DrawLaserSightSingle(
-	const Vec2i from, const double radians, const int range,
-	const color_t color)
+	GraphicsDevice *device, const Vec2i from, const double radians,
+	const int range, const color_t color)
 {
 	double x, y;
 	GetVectorsForRadians(radians, &x, &y);
 	const Vec2i to = Vec2iAdd(
 		from, Vec2iNew((int)round(x * range), (int)round(y * range)));
-	DrawLine(from, to, color);
+	DrawLine(device, from, to, color);
 }
 
 void DrawActorHighlight(
@@ -514,7 +557,7 @@ void DrawCharacterSimple(
 	ActorPics pics = GetCharacterPics(
 		c, d, ACTORANIMATION_IDLE, 0, NULL, GUNSTATE_READY,
 		false, NULL, NULL, 0);
-	DrawActorPics(&pics, pos);
+	DrawActorPics(&gGraphicsDevice, &pics, pos);
 	if (hilite)
 	{
 		FontCh('>', Vec2iAdd(pos, Vec2iNew(-8, -16)));
@@ -90,8 +90,13 @@ void DrawHead(const Character *c, const direction_e dir, const Vec2i pos);
 void DrawChatters(DrawBuffer *b, const Vec2i offset);
 
 ActorPics GetCharacterPicsFromActor(TActor *a);
-void DrawActorPics(const ActorPics *pics, const Vec2i pos);
+// Composite the actor into the actor pic cache, so that drawing it later
+// takes one blit; call before drawing, outside of render jobs
+void CacheActorPics(const ActorPics *pics);
+void DrawActorPics(
+	GraphicsDevice *g, const ActorPics *pics, const Vec2i pos);
 void DrawLaserSight(
-	const ActorPics *pics, const TActor *a, const Vec2i picPos);
+	GraphicsDevice *device, const ActorPics *pics, const TActor *a,
+	const Vec2i picPos);
 void DrawActorHighlight(
 	const ActorPics *pics, const Vec2i pos, const color_t color);
@@ -49,6 +49,7 @@
 #include "draw/draw_buffer.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "algorithms.h"
 #include "los.h"
@@ -65,15 +66,17 @@ void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g)
 		b->tiles[i] = b->tiles[0] + i * size.y;
 	}
 	b->g = g;
-	CArrayInit(&b->displaylist, sizeof(const TTileItem *));
-	CArrayReserve(&b->displaylist, 32);
+	b->Layer = NULL;
+	b->MaxRowThings = 0;
+	DisplayListInit(&b->displaylist);
+	DisplayListReserve(&b->displaylist, 32);
 	debug(D_MAX, "Initialised draw buffer %dx%d\n", size.x, size.y);
 }
 void DrawBufferTerminate(DrawBuffer *b)
 {
 	CFREE(b->tiles[0]);
 	CFREE(b->tiles);
-	CArrayTerminate(&b->displaylist);
+	DisplayListTerminate(&b->displaylist);
 }
 
 void DrawBufferSetFromMap(
@@ -166,26 +169,78 @@ void DrawBufferFix(DrawBuffer *buffer)
 	}
 }
 
-static int CompareY(const void *v1, const void *v2);
-void DrawBufferSortDisplayList(DrawBuffer *buffer)
+void DisplayListInit(DisplayList *dl)
+{
+	CArrayInit(&dl->Items, sizeof(const TTileItem *));
+	CArrayInit(&dl->Bins, sizeof(const TTileItem *));
+}
+void DisplayListTerminate(DisplayList *dl)
+{
+	CArrayTerminate(&dl->Items);
+	CArrayTerminate(&dl->Bins);
+}
+void DisplayListReserve(DisplayList *dl, const size_t size)
 {
-	qsort(
-		buffer->displaylist.data,
-		buffer->displaylist.size,
-		buffer->displaylist.elemSize,
-		CompareY);
+	CArrayReserve(&dl->Items, size);
+	CArrayReserve(&dl->Bins, size);
 }
-static int CompareY(const void *v1, const void *v2)
+
+// Order by y, keeping the order items were added in for equal y.
+// Items come from a row of tiles so their y spans about a tile; instead of
+// sorting by comparison, bin them by pixel row (y - min y), 256 rows per
+// pass, which is a single pass unless the items are unusually spread out.
+#define SORT_BINS 256
+void DrawBufferSortDisplayList(DrawBuffer *buffer)
 {
-	const TTileItem * const *t1 = v1;
-	const TTileItem * const *t2 = v2;
-	if ((*t1)->y < (*t2)->y)
+	DisplayList *dl = &buffer->displaylist;
+	const int n = (int)dl->Items.size;
+	if (n < 2)
 	{
-		return -1;
+		return;
+	}
+	CArrayReserve(&dl->Bins, n);
+	const TTileItem **items = dl->Items.data;
+	const TTileItem **binned = dl->Bins.data;
+	int minY = items[0]->y;
+	int maxY = minY;
+	for (int i = 1; i < n; i++)
+	{
+		minY = MIN(minY, items[i]->y);
+		maxY = MAX(maxY, items[i]->y);
+	}
+	const unsigned range = (unsigned)(maxY - minY);
+	for (unsigned shift = 0;; shift += 8)
+	{
+		// Only as many bins as the items need, typically a tile's height
+		const unsigned numBins = MIN(range >> shift, SORT_BINS - 1) + 1;
+		int starts[SORT_BINS + 1];
+		memset(starts, 0, (numBins + 1) * sizeof starts[0]);
+		for (int i = 0; i < n; i++)
+		{
+			const unsigned bin =
+				((unsigned)(items[i]->y - minY) >> shift) % SORT_BINS;
+			starts[bin + 1]++;
+		}
+		for (unsigned i = 1; i <= numBins; i++)
+		{
+			starts[i] += starts[i - 1];
+		}
+		for (int i = 0; i < n; i++)
+		{
+			const unsigned bin =
+				((unsigned)(items[i]->y - minY) >> shift) % SORT_BINS;
+			binned[starts[bin]++] = items[i];
+		}
+		const TTileItem **tmp = items;
+		items = binned;
+		binned = tmp;
+		if ((range >> shift) < SORT_BINS)
+		{
+			break;
+		}
 	}
-	else if ((*t1)->y >(*t2)->y)
+	if (items != dl->Items.data)
 	{
-		return 1;
+		memcpy(dl->Items.data, items, n * sizeof *items);
 	}
-	return 0;
 }
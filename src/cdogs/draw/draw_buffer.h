@@ -51,6 +51,16 @@
 
 #include "map.h"
 
+// Things to draw, put in draw order by DrawBufferSortDisplayList
+typedef struct
+{
+	CArray Items;	// of const TTileItem *
+	CArray Bins;	// scratch for sorting, of const TTileItem *
+} DisplayList;
+void DisplayListInit(DisplayList *dl);
+void DisplayListTerminate(DisplayList *dl);
+void DisplayListReserve(DisplayList *dl, const size_t size);
+
 typedef struct
 {
 	GraphicsDevice *g;
@@ -60,7 +70,10 @@ typedef struct
 	Vec2i OrigSize;
 	Vec2i Size;	// size in tiles
 	Tile **tiles;
-	CArray displaylist;	// of const TTileItem *, to determine draw order
+	DisplayList displaylist;	// to determine draw order
+	size_t MaxRowThings;	// most things in a row; the display list's max
+	// Optional cache of the floor; if set, the floor is copied from it
+	struct MapLayer *Layer;
 } DrawBuffer;
 
 void DrawBufferInit(DrawBuffer *b, Vec2i size, GraphicsDevice *g);
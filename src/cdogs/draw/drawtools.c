@@ -56,18 +56,12 @@
 #include "grafx.h"
 
 
-void Draw_Point(const int x, const int y, color_t c)
+static void DrawPoint(GraphicsDevice *g, const int x, const int y, color_t c)
 {
-	Uint32 *screen = gGraphicsDevice.buf;
-	int idx = PixelIndex(
-		x,
-		y,
-		gGraphicsDevice.cachedConfig.Res.x,
-		gGraphicsDevice.cachedConfig.Res.y);
-	if (x < gGraphicsDevice.clipping.left ||
-		x > gGraphicsDevice.clipping.right ||
-		y < gGraphicsDevice.clipping.top ||
-		y > gGraphicsDevice.clipping.bottom)
+	Uint32 *screen = g->buf;
+	int idx = PixelIndex(x, y, g->cachedConfig.Res.x, g->cachedConfig.Res.y);
+	if (x < g->clipping.left || x > g->clipping.right ||
+		y < g->clipping.top || y > g->clipping.bottom)
 	{
 		return;
 	}
@@ -81,6 +75,10 @@ void Draw_Point(const int x, const int y, color_t c)
 		screen[idx] = COLOR2PIXEL(ColorAlphaBlend(existing, c));
 	}
 }
+void Draw_Point(const int x, const int y, color_t c)
+{
+	DrawPoint(&gGraphicsDevice, x, y, c);
+}
 
 static
 void
@@ -140,18 +138,27 @@ static void Draw_DiagonalLine(const int x1, const int x2, color_t c)
 	return;
 }
 
+typedef struct
+{
+	GraphicsDevice *g;
+	color_t c;
+} DrawLineData;
 static void DrawPointFunc(void *data, const Vec2i pos);
-void DrawLine(const Vec2i from, const Vec2i to, color_t c)
+void DrawLine(
+	GraphicsDevice *g, const Vec2i from, const Vec2i to, color_t c)
 {
+	DrawLineData dl;
+	dl.g = g;
+	dl.c = c;
 	AlgoLineDrawData data;
 	data.Draw = DrawPointFunc;
-	data.data = &c;
+	data.data = &dl;
 	BresenhamLineDraw(from, to, &data);
 }
 static void DrawPointFunc(void *data, const Vec2i pos)
 {
-	const color_t *c = data;
-	Draw_Point(pos.x, pos.y, *c);
+	const DrawLineData *dl = data;
+	DrawPoint(dl->g, pos.x, pos.y, dl->c);
 }
 
 void Draw_Line(
@@ -265,7 +272,7 @@ void DrawShadow(GraphicsDevice *device, Vec2i pos, Vec2i size)
 	Vec2i drawPos;
 	for (drawPos.y = pos.y - size.y; drawPos.y < pos.y + size.y; drawPos.y++)
 	{
-		if (drawPos.y >= device->clipping.bottom)
+		if (drawPos.y > device->clipping.bottom)
 		{
 			break;
 		}
@@ -278,7 +285,7 @@ void DrawShadow(GraphicsDevice *device, Vec2i pos, Vec2i size)
 			// Calculate value tint based on distance from center
 			Vec2i scaledPos;
 			int distance2;
-			if (drawPos.x >= device->clipping.right)
+			if (drawPos.x > device->clipping.right)
 			{
 				break;
 			}
@@ -51,7 +51,8 @@
 void Draw_Point(const int x, const int y, color_t c);
 void Draw_Line(
 	const int x1, const int y1, const int x2, const int y2, color_t c);
-void DrawLine(const Vec2i from, const Vec2i to, color_t c);
+void DrawLine(
+	GraphicsDevice *g, const Vec2i from, const Vec2i to, color_t c);
 
 #define PixelIndex(x, y, w, h)		(y * w + x)
 
@@ -0,0 +1,148 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "draw/map_layer.h"
+
+#include <string.h>
+
+#include "blit.h"
+
+
+void MapLayerInit(MapLayer *l)
+{
+	memset(l, 0, sizeof *l);
+	CArrayInit(&l->Chunks, sizeof(MapLayerChunk));
+}
+static void MapLayerClear(MapLayer *l)
+{
+	CA_FOREACH(MapLayerChunk, c, l->Chunks)
+		CFREE(c->Pixels);
+		CFREE(c->FogPixels);
+	CA_FOREACH_END()
+	CArrayClear(&l->Chunks);
+}
+void MapLayerTerminate(MapLayer *l)
+{
+	MapLayerClear(l);
+	CArrayTerminate(&l->Chunks);
+}
+
+static void RenderChunk(
+	Uint32 *pixels, Map *map, const Vec2i chunk, const bool fog);
+const Uint32 *MapLayerGetChunk(
+	MapLayer *l, Map *map, const Vec2i chunk, const bool fog)
+{
+	if (l->MapLoadId != map->LoadId)
+	{
+		// New map; start over
+		MapLayerClear(l);
+		MapLayerChunk empty;
+		memset(&empty, 0, sizeof empty);
+		empty.Version = -1;
+		empty.FogVersion = -1;
+		CArrayResize(
+			&l->Chunks, map->ChunksSize.x * map->ChunksSize.y, &empty);
+		l->MapLoadId = map->LoadId;
+	}
+	const int idx = chunk.y * map->ChunksSize.x + chunk.x;
+	MapLayerChunk *c = CArrayGet(&l->Chunks, idx);
+	const int version = map->ChunkVersions[idx];
+	int *cVersion = fog ? &c->FogVersion : &c->Version;
+	Uint32 **cPixels = fog ? &c->FogPixels : &c->Pixels;
+	if (*cVersion != version)
+	{
+		if (*cPixels == NULL)
+		{
+			CMALLOC(
+				*cPixels,
+				MAP_LAYER_CHUNK_W * MAP_LAYER_CHUNK_H * sizeof **cPixels);
+		}
+		RenderChunk(*cPixels, map, chunk, fog);
+		*cVersion = version;
+	}
+	return *cPixels;
+}
+// Render the floor as DrawFloor would: normal tiles skip transparent
+// pixels, fogged ones are masked over the whole pic
+static void RenderChunk(
+	Uint32 *pixels, Map *map, const Vec2i chunk, const bool fog)
+{
+	memset(
+		pixels, 0, MAP_LAYER_CHUNK_W * MAP_LAYER_CHUNK_H * sizeof *pixels);
+	const Uint32 amask = gGraphicsDevice.Format->Amask;
+	const Uint32 fogPixel = COLOR2PIXEL(colorFog);
+	Vec2i t;
+	for (t.y = 0; t.y < MAP_CHUNK_SIZE; t.y++)
+	{
+		for (t.x = 0; t.x < MAP_CHUNK_SIZE; t.x++)
+		{
+			const Vec2i v = Vec2iAdd(Vec2iScale(chunk, MAP_CHUNK_SIZE), t);
+			if (!MapIsTileIn(map, v))
+			{
+				continue;
+			}
+			const Tile *tile = MapGetTile(map, v);
+			if (tile->pic == NULL || tile->pic->pic.Data == NULL ||
+				(tile->flags & MAPTILE_IS_WALL))
+			{
+				continue;
+			}
+			// Floor pics are tile-sized; clip anything else to the tile
+			const Pic *pic = &tile->pic->pic;
+			const Uint32 *src = pic->Data;
+			for (int y = 0; y < pic->size.y; y++)
+			{
+				const int py = y + pic->offset.y;
+				if (py < 0 || py >= TILE_HEIGHT)
+				{
+					src += pic->size.x;
+					continue;
+				}
+				Uint32 *dst = pixels +
+					(t.y * TILE_HEIGHT + py) * MAP_LAYER_CHUNK_W +
+					t.x * TILE_WIDTH;
+				for (int x = 0; x < pic->size.x; x++, src++)
+				{
+					const int px = x + pic->offset.x;
+					if (px < 0 || px >= TILE_WIDTH)
+					{
+						continue;
+					}
+					if (fog)
+					{
+						dst[px] = PixelMult(*src, fogPixel) | amask;
+					}
+					else if (*src & amask)
+					{
+						dst[px] = *src;
+					}
+				}
+			}
+		}
+	}
+}
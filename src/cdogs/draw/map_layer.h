@@ -0,0 +1,62 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <SDL_stdinc.h>
+
+#include "c_array.h"
+#include "map.h"
+
+// Pre-rendered floor tiles of the map, cached in chunks of MAP_CHUNK_SIZE
+// tiles so that the floor can be drawn with row copies instead of a blit
+// per tile. Chunks are rendered on first use and re-rendered when the map
+// marks them as changed.
+#define MAP_LAYER_CHUNK_W (MAP_CHUNK_SIZE * TILE_WIDTH)
+#define MAP_LAYER_CHUNK_H (MAP_CHUNK_SIZE * TILE_HEIGHT)
+
+typedef struct
+{
+	int Version;
+	Uint32 *Pixels;
+	int FogVersion;
+	Uint32 *FogPixels;
+} MapLayerChunk;
+typedef struct MapLayer
+{
+	int MapLoadId;
+	CArray Chunks;	// of MapLayerChunk
+} MapLayer;
+
+void MapLayerInit(MapLayer *l);
+void MapLayerTerminate(MapLayer *l);
+
+// Get the pixels of a chunk, MAP_LAYER_CHUNK_W per row, either as drawn
+// normally or darkened by fog. Wall and empty tiles are transparent black.
+const Uint32 *MapLayerGetChunk(
+	MapLayer *l, Map *map, const Vec2i chunk, const bool fog);
@@ -0,0 +1,168 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "draw/render_jobs.h"
+
+#include <string.h>
+
+#include <SDL.h>
+
+#include "log.h"
+#include "utils.h"
+
+#define RENDER_THREADS_MAX 16
+
+typedef struct
+{
+	// Workers, not counting the calling thread
+	int NumWorkers;
+	SDL_Thread *Threads[RENDER_THREADS_MAX - 1];
+	SDL_sem *Start;
+	SDL_sem *Done;
+	bool Quit;
+	// Current run; written before the workers are woken
+	RenderJobFunc Func;
+	void *Data;
+	int N;
+	SDL_atomic_t Next;
+} RenderJobs;
+static RenderJobs sJobs;
+
+static int RenderJobsWorker(void *unused);
+void RenderJobsInit(const int numThreads)
+{
+	RenderJobsTerminate();
+	int n = numThreads > 0 ? numThreads : SDL_GetCPUCount();
+	n = CLAMP(n, 1, RENDER_THREADS_MAX);
+	if (n > 1)
+	{
+		sJobs.Start = SDL_CreateSemaphore(0);
+		sJobs.Done = SDL_CreateSemaphore(0);
+		if (sJobs.Start == NULL || sJobs.Done == NULL)
+		{
+			LOG(LM_GFX, LL_ERROR, "cannot create render semaphores: %s",
+				SDL_GetError());
+			RenderJobsTerminate();
+			return;
+		}
+		for (int i = 0; i < n - 1; i++)
+		{
+			sJobs.Threads[i] =
+				SDL_CreateThread(RenderJobsWorker, "render", NULL);
+			if (sJobs.Threads[i] == NULL)
+			{
+				LOG(LM_GFX, LL_ERROR, "cannot create render thread: %s",
+					SDL_GetError());
+				break;
+			}
+			sJobs.NumWorkers++;
+		}
+	}
+	LOG(LM_GFX, LL_INFO, "render threads: %d", RenderJobsNumThreads());
+}
+void RenderJobsTerminate(void)
+{
+	sJobs.Quit = true;
+	for (int i = 0; i < sJobs.NumWorkers; i++)
+	{
+		SDL_SemPost(sJobs.Start);
+	}
+	for (int i = 0; i < sJobs.NumWorkers; i++)
+	{
+		SDL_WaitThread(sJobs.Threads[i], NULL);
+	}
+	if (sJobs.Start != NULL)
+	{
+		SDL_DestroySemaphore(sJobs.Start);
+	}
+	if (sJobs.Done != NULL)
+	{
+		SDL_DestroySemaphore(sJobs.Done);
+	}
+	memset(&sJobs, 0, sizeof sJobs);
+}
+
+int RenderJobsNumThreads(void)
+{
+	return sJobs.NumWorkers + 1;
+}
+
+static void RunJobs(void)
+{
+	for (;;)
+	{
+		const int i = SDL_AtomicAdd(&sJobs.Next, 1);
+		if (i >= sJobs.N)
+		{
+			break;
+		}
+		sJobs.Func(sJobs.Data, i);
+	}
+}
+static int RenderJobsWorker(void *unused)
+{
+	UNUSED(unused);
+	for (;;)
+	{
+		SDL_SemWait(sJobs.Start);
+		if (sJobs.Quit)
+		{
+			break;
+		}
+		RunJobs();
+		SDL_SemPost(sJobs.Done);
+	}
+	return 0;
+}
+
+void RenderJobsRun(RenderJobFunc func, void *data, const int n)
+{
+	// Only wake as many workers as there are jobs for
+	const int numWorkers = MIN(sJobs.NumWorkers, n - 1);
+	if (numWorkers <= 0)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			func(data, i);
+		}
+		return;
+	}
+	sJobs.Func = func;
+	sJobs.Data = data;
+	sJobs.N = n;
+	SDL_AtomicSet(&sJobs.Next, 0);
+	for (int i = 0; i < numWorkers; i++)
+	{
+		SDL_SemPost(sJobs.Start);
+	}
+	RunJobs();
+	for (int i = 0; i < numWorkers; i++)
+	{
+		SDL_SemWait(sJobs.Done);
+	}
+}
@@ -566,15 +566,18 @@ const char *GetHomeDirectory(void)
  */
 char cfpath[CDOGS_PATH_MAX];
 const char *GetConfigFilePath(const char *name)
+{
+	GetConfigFilePathBuf(cfpath, name);
+	return cfpath;
+}
+void GetConfigFilePathBuf(char *buf, const char *name)
 {
 	const char *homedir = GetHomeDirectory();
 
-	strcpy(cfpath, homedir);
+	strcpy(buf, homedir);
 
-	strcat(cfpath, CDOGS_CFG_DIR);
-	strcat(cfpath, name);
-
-	return cfpath;
+	strcat(buf, CDOGS_CFG_DIR);
+	strcat(buf, name);
 }
 
 static bool doMkdir(const char *path)
@@ -211,6 +211,8 @@ int LoadCampaignOld(const char *filename, CampaignSettingOld *setting);
 
 const char *GetHomeDirectory(void);
 const char *GetConfigFilePath(const char *name);
+// Thread-safe version of the above, for use during startup on other threads
+void GetConfigFilePathBuf(char *buf, const char *name);
 
 void SetupConfigDir(void);
 
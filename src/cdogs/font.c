@@ -41,6 +41,45 @@
 
 Font gFont;
 
+// Strings drawn every frame, such as HUD text, are laid out and rendered
+// once into a run: a pic of their glyphs in white, which is then drawn with
+// one masked blit. Strings are only cached once seen twice recently, so
+// that text which changes every frame doesn't churn the cache.
+// Text is only drawn serially, so the cache needs no locking.
+#define RUN_CACHE_MAX_BYTES (1024 * 1024)
+#define RUN_BUCKETS 256
+#define RUN_SEEN 256
+typedef struct
+{
+	char *Text;
+	int Width;	// wrap width, 0 for none
+	Uint32 Hash;
+	char *Wrapped;	// NULL if not wrapped
+	size_t Bytes;
+	Vec2i Size;
+	Vec2i End;	// cursor position after the text, relative to its start
+	Pic Pic;
+	// LRU list and bucket chain, by run index; -1 for none.
+	// Unused runs are chained from Free by Next.
+	int Prev;
+	int Next;
+	int BucketNext;
+} FontRun;
+typedef struct
+{
+	bool IsInit;
+	CArray Runs;	// of FontRun
+	int Buckets[RUN_BUCKETS];
+	Uint32 Seen[RUN_SEEN];
+	int Head;	// most recently used
+	int Tail;
+	int Free;
+	size_t Bytes;
+} FontRunCache;
+static FontRunCache sRuns;
+static void RunCacheInit(void);
+static void RunCacheTerminate(void);
+
 
 FontOpts FontOptsNew(void)
 {
@@ -86,6 +125,8 @@ void FontLoad(Font *f, const char *imgPath, const bool isProportional)
 	}
 
 	CArrayInit(&f->Chars, sizeof(Pic));
+	// Runs are made of the old glyphs
+	RunCacheTerminate();
 
 	// Check that the image is big enough for the dimensions
 	const Vec2i step = Vec2iNew(
@@ -137,6 +178,7 @@ bail:
 }
 void FontTerminate(Font *f)
 {
+	RunCacheTerminate();
 	CA_FOREACH(Pic, p, f->Chars)
 		PicFree(p);
 	CA_FOREACH_END()
@@ -158,14 +200,10 @@ int FontStrW(const char *s)
 }
 int FontSubstrW(const char *s, int len)
 {
-	if (len > (int)strlen(s))
-	{
-		len = (int)strlen(s);
-	}
 	// Find the width of the longest line, if this is a multi-line
 	int maxWidth = 0;
 	int w = 0;
-	for (int i = 0; i < len; i++, s++)
+	for (int i = 0; i < len && *s; i++, s++)
 	{
 		if (*s == '\n')
 		{
@@ -228,8 +266,7 @@ Vec2i FontChMask(const char c, const Vec2i pos, const color_t mask)
 {
 	return FontChColor(c, pos, mask, false);
 }
-static Vec2i FontChColor(
-	const char c, const Vec2i pos, const color_t color, const bool blend)
+static const Pic *GetCharPic(const char c)
 {
 	int idx = (int)c - FIRST_CHAR;
 	if (idx < 0)
@@ -241,7 +278,12 @@ static Vec2i FontChColor(
 		fprintf(stderr, "invalid char %d\n", idx);
 		idx = FIRST_CHAR;
 	}
-	const Pic *pic = CArrayGet(&gFont.Chars, idx);
+	return CArrayGet(&gFont.Chars, idx);
+}
+static Vec2i FontChColor(
+	const char c, const Vec2i pos, const color_t color, const bool blend)
+{
+	const Pic *pic = GetCharPic(c);
 	if (blend)
 	{
 		BlitBlend(&gGraphicsDevice, pic, pos, color);
@@ -259,8 +301,15 @@ Vec2i FontStr(const char *s, Vec2i pos)
 }
 static Vec2i FontStrColor(
 	const char *s, Vec2i pos, const color_t c, const bool blend);
+static const FontRun *GetRun(const char *s, const int width);
+static Vec2i DrawRun(const FontRun *r, const Vec2i pos, const color_t mask);
 Vec2i FontStrMask(const char *s, Vec2i pos, const color_t mask)
 {
+	const FontRun *r = GetRun(s, 0);
+	if (r != NULL)
+	{
+		return DrawRun(r, pos, mask);
+	}
 	return FontStrColor(s, pos, mask, false);
 }
 static Vec2i FontStrColor(
@@ -284,23 +333,35 @@ static Vec2i FontStrColor(
 }
 Vec2i FontStrMaskWrap(const char *s, Vec2i pos, color_t mask, const int width)
 {
+	const FontRun *r = GetRun(s, width);
+	if (r != NULL)
+	{
+		return DrawRun(r, pos, mask);
+	}
 	char buf[1024];
 	CASSERT(strlen(s) < 1024, "string too long to wrap");
 	FontSplitLines(s, buf, width);
 	return FontStrMask(buf, pos, mask);
 }
-static Vec2i GetStrPos(const char *s, Vec2i pos, const FontOpts opts);
+static Vec2i GetStrPos(
+	const Vec2i textSize, const Vec2i pos, const FontOpts opts);
 void FontStrOpt(const char *s, Vec2i pos, const FontOpts opts)
 {
-	pos = GetStrPos(s, pos, opts);
-	FontStrMask(s, pos, opts.Mask);
+	const FontRun *r = GetRun(s, 0);
+	if (r != NULL)
+	{
+		DrawRun(r, GetStrPos(r->Size, pos, opts), opts.Mask);
+		return;
+	}
+	pos = GetStrPos(FontStrSize(s), pos, opts);
+	FontStrColor(s, pos, opts.Mask, false);
 }
 static int GetAlign(
 	const FontAlign align,
 	const int pos, const int pad, const int area, const int size);
-static Vec2i GetStrPos(const char *s, Vec2i pos, const FontOpts opts)
+static Vec2i GetStrPos(
+	const Vec2i textSize, const Vec2i pos, const FontOpts opts)
 {
-	const Vec2i textSize = FontStrSize(s);
 	return Vec2iNew(
 		GetAlign(opts.HAlign, pos.x, opts.Pad.x, opts.Area.x, textSize.x),
 		GetAlign(opts.VAlign, pos.y, opts.Pad.y, opts.Area.y, textSize.y));
@@ -400,6 +461,271 @@ void FontSplitLines(const char *text, char *buf, const int width)
 	*buf = '\0';
 }
 
+static void RunCacheInit(void)
+{
+	memset(&sRuns, 0, sizeof sRuns);
+	CArrayInit(&sRuns.Runs, sizeof(FontRun));
+	for (int i = 0; i < RUN_BUCKETS; i++)
+	{
+		sRuns.Buckets[i] = -1;
+	}
+	sRuns.Head = sRuns.Tail = sRuns.Free = -1;
+	sRuns.IsInit = true;
+}
+static void RunFree(FontRun *r);
+static void RunCacheTerminate(void)
+{
+	if (!sRuns.IsInit)
+	{
+		return;
+	}
+	for (int i = sRuns.Head; i >= 0;)
+	{
+		FontRun *r = CArrayGet(&sRuns.Runs, i);
+		RunFree(r);
+		i = r->Next;
+	}
+	CArrayTerminate(&sRuns.Runs);
+	memset(&sRuns, 0, sizeof sRuns);
+}
+static void RunFree(FontRun *r)
+{
+	CFREE(r->Text);
+	CFREE(r->Wrapped);
+	PicFree(&r->Pic);
+}
+
+// FNV-1a
+static Uint32 RunHash(const char *s, const int width)
+{
+	Uint32 h = 2166136261u;
+	for (; *s; s++)
+	{
+		h = (h ^ (Uint8)*s) * 16777619u;
+	}
+	return (h ^ (Uint32)width) * 16777619u;
+}
+static int RunFind(const char *s, const int width, const Uint32 hash)
+{
+	for (int i = sRuns.Buckets[hash % RUN_BUCKETS]; i >= 0;)
+	{
+		const FontRun *r = CArrayGet(&sRuns.Runs, i);
+		if (r->Hash == hash && r->Width == width && strcmp(r->Text, s) == 0)
+		{
+			return i;
+		}
+		i = r->BucketNext;
+	}
+	return -1;
+}
+static void RunListRemove(const int i);
+static void RunListPushFront(const int i);
+static void RunEvict(const int i);
+static bool RunMake(FontRun *r, const char *s, const int width);
+// Get the cached run for the string, making it if the string has been seen
+// recently; NULL if the string should be drawn glyph by glyph.
+// The run is valid until the next call.
+static const FontRun *GetRun(const char *s, const int width)
+{
+	if (gGraphicsDevice.Format == NULL)
+	{
+		return NULL;
+	}
+	if (!sRuns.IsInit)
+	{
+		RunCacheInit();
+	}
+	const Uint32 hash = RunHash(s, width);
+	int i = RunFind(s, width, hash);
+	if (i >= 0)
+	{
+		RunListRemove(i);
+		RunListPushFront(i);
+		return CArrayGet(&sRuns.Runs, i);
+	}
+	Uint32 *seen = &sRuns.Seen[hash % RUN_SEEN];
+	if (*seen != hash)
+	{
+		*seen = hash;
+		return NULL;
+	}
+
+	FontRun r;
+	if (!RunMake(&r, s, width))
+	{
+		return NULL;
+	}
+	while (sRuns.Bytes + r.Bytes > RUN_CACHE_MAX_BYTES && sRuns.Tail >= 0)
+	{
+		RunEvict(sRuns.Tail);
+	}
+	if (sRuns.Bytes + r.Bytes > RUN_CACHE_MAX_BYTES)
+	{
+		RunFree(&r);
+		return NULL;
+	}
+	if (sRuns.Free >= 0)
+	{
+		i = sRuns.Free;
+		sRuns.Free = ((const FontRun *)CArrayGet(&sRuns.Runs, i))->Next;
+		memcpy(CArrayGet(&sRuns.Runs, i), &r, sizeof r);
+	}
+	else
+	{
+		CArrayPushBack(&sRuns.Runs, &r);
+		i = (int)sRuns.Runs.size - 1;
+	}
+	FontRun *rNew = CArrayGet(&sRuns.Runs, i);
+	rNew->Hash = hash;
+	rNew->BucketNext = sRuns.Buckets[hash % RUN_BUCKETS];
+	sRuns.Buckets[hash % RUN_BUCKETS] = i;
+	RunListPushFront(i);
+	sRuns.Bytes += rNew->Bytes;
+	return rNew;
+}
+static void RunListRemove(const int i)
+{
+	FontRun *r = CArrayGet(&sRuns.Runs, i);
+	if (r->Prev >= 0)
+	{
+		((FontRun *)CArrayGet(&sRuns.Runs, r->Prev))->Next = r->Next;
+	}
+	else
+	{
+		sRuns.Head = r->Next;
+	}
+	if (r->Next >= 0)
+	{
+		((FontRun *)CArrayGet(&sRuns.Runs, r->Next))->Prev = r->Prev;
+	}
+	else
+	{
+		sRuns.Tail = r->Prev;
+	}
+}
+static void RunListPushFront(const int i)
+{
+	FontRun *r = CArrayGet(&sRuns.Runs, i);
+	r->Prev = -1;
+	r->Next = sRuns.Head;
+	if (sRuns.Head >= 0)
+	{
+		((FontRun *)CArrayGet(&sRuns.Runs, sRuns.Head))->Prev = i;
+	}
+	else
+	{
+		sRuns.Tail = i;
+	}
+	sRuns.Head = i;
+}
+static void RunEvict(const int i)
+{
+	FontRun *r = CArrayGet(&sRuns.Runs, i);
+	int *link = &sRuns.Buckets[r->Hash % RUN_BUCKETS];
+	while (*link != i)
+	{
+		link = &((FontRun *)CArrayGet(&sRuns.Runs, *link))->BucketNext;
+	}
+	*link = r->BucketNext;
+	RunListRemove(i);
+	sRuns.Bytes -= r->Bytes;
+	RunFree(r);
+	r->Next = sRuns.Free;
+	sRuns.Free = i;
+}
+// Lay out the glyphs as FontStrColor would, and draw them in white into
+// the run's pic the way they would be drawn to the screen
+static bool RunMake(FontRun *r, const char *s, const int width)
+{
+	memset(r, 0, sizeof *r);
+	const size_t len = strlen(s);
+	// Wrapping may add a line break after every word
+	if (width != 0 && len >= 512)
+	{
+		return false;
+	}
+	CSTRDUP(r->Text, s);
+	r->Width = width;
+	r->Bytes = sizeof *r + len + 1;
+	const char *text = r->Text;
+	if (width != 0)
+	{
+		CMALLOC(r->Wrapped, len * 2 + 1);
+		FontSplitLines(s, r->Wrapped, width);
+		r->Bytes += len * 2 + 1;
+		text = r->Wrapped;
+	}
+	r->Size = FontStrSize(text);
+
+	// Find the bounds of the glyphs
+	Vec2i cursor = Vec2iZero();
+	Vec2i min = Vec2iZero(), max = Vec2iZero();
+	bool hasGlyphs = false;
+	for (const char *c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			cursor = Vec2iNew(0, cursor.y + FontH());
+			continue;
+		}
+		const Pic *pic = GetCharPic(*c);
+		if (!PicIsNone(pic))
+		{
+			const Vec2i glyphPos = Vec2iAdd(cursor, pic->offset);
+			const Vec2i glyphEnd = Vec2iAdd(glyphPos, pic->size);
+			min = hasGlyphs ? Vec2iMin(min, glyphPos) : glyphPos;
+			max = hasGlyphs ? Vec2iMax(max, glyphEnd) : glyphEnd;
+			hasGlyphs = true;
+		}
+		cursor.x += pic->size.x + gFont.Gap.x;
+	}
+	r->End = cursor;
+	if (!hasGlyphs)
+	{
+		return true;
+	}
+
+	// Drawing glyphs masked with white keeps their colour and makes them
+	// opaque, so masking the run draws the same pixels as masking each glyph
+	const Vec2i size = Vec2iMinus(max, min);
+	r->Pic.size = size;
+	r->Pic.offset = min;
+	CCALLOC(r->Pic.Data, size.x * size.y * sizeof *r->Pic.Data);
+	r->Bytes += size.x * size.y * sizeof *r->Pic.Data;
+	GraphicsDevice g;
+	memset(&g, 0, sizeof g);
+	g.Format = gGraphicsDevice.Format;
+	g.cachedConfig.Res = size;
+	g.buf = r->Pic.Data;
+	g.clipping.right = size.x - 1;
+	g.clipping.bottom = size.y - 1;
+	cursor = Vec2iZero();
+	for (const char *c = text; *c; c++)
+	{
+		if (*c == '\n')
+		{
+			cursor = Vec2iNew(0, cursor.y + FontH());
+			continue;
+		}
+		const Pic *pic = GetCharPic(*c);
+		if (!PicIsNone(pic))
+		{
+			BlitMasked(&g, pic, Vec2iMinus(cursor, min), colorWhite, true);
+		}
+		cursor.x += pic->size.x + gFont.Gap.x;
+	}
+	PicUpdateSpans(&r->Pic);
+	return true;
+}
+static Vec2i DrawRun(const FontRun *r, const Vec2i pos, const color_t mask)
+{
+	if (r->Pic.Data != NULL)
+	{
+		BlitMasked(&gGraphicsDevice, &r->Pic, pos, mask, true);
+	}
+	return Vec2iAdd(pos, r->End);
+}
+
 Vec2i Vec2iAligned(
 	const Vec2i v, const Vec2i size,
 	const FontAlign hAlign, const FontAlign vAlign, const Vec2i area)
@@ -32,6 +32,7 @@
 
 #include "config.h"
 #include "events.h"
+#include "mem_track.h"
 #include "net_client.h"
 #include "net_server.h"
 #include "sounds.h"
@@ -61,6 +62,7 @@ void GameLoop(GameLoopData *data)
 	Uint32 ticksElapsed = 0;
 	int framesSkipped = 0;
 	const int maxFrameskip = data->FPS / 5;
+	MemTrackLoopStart();
 	for (; result != UPDATE_RESULT_EXIT; )
 	{
 		// Frame rate control
@@ -87,6 +89,7 @@ void GameLoop(GameLoopData *data)
 		NetServerPoll(&gNetServer);
 
 		// Update
+		MemTrackFrame();
 		result = data->UpdateFunc(data->UpdateData);
 		NetServerFlush(&gNetServer);
 		NetClientFlush(&gNetClient);
@@ -135,4 +138,5 @@ void GameLoop(GameLoopData *data)
 			data->HasDrawnFirst = true;
 		}
 	}
+	MemTrackLoopEnd();
 }
@@ -58,6 +58,7 @@
 #include <SDL_mouse.h>
 
 #include "blit.h"
+#include "blit_kernels.h"
 #include "config.h"
 #include "defs.h"
 #include "draw/drawtools.h"
@@ -137,11 +138,14 @@ void GraphicsInit(GraphicsDevice *device, Config *c)
 {
 	memset(device, 0, sizeof *device);
 	CArrayInit(&device->validModes, sizeof(Vec2i));
+	CArrayInit(&device->dirtyRects, sizeof(Rect2i));
 	// Add default modes
 	AddGraphicsMode(device, 320, 240);
 	AddGraphicsMode(device, 400, 300);
 	AddGraphicsMode(device, 640, 480);
 	GraphicsConfigSetFromConfig(&device->cachedConfig, c);
+	const BlitKernelsType t = BlitKernelsInit();
+	LOG(LM_GFX, LL_INFO, "blit kernels: %s", BlitKernelsTypeStr(t));
 }
 
 static void AddSupportedGraphicsModes(GraphicsDevice *device)
@@ -301,6 +305,10 @@ void GraphicsInitialize(GraphicsDevice *g)
 
 		CFREE(g->buf);
 		CCALLOC(g->buf, GraphicsGetMemSize(&g->cachedConfig));
+		// New screen texture; upload the whole of the next frame
+		CFREE(g->lastBuf);
+		g->lastBuf = NULL;
+		g->fullUploadFrames = 0;
 		g->bkg = CreateTexture(
 			g->renderer, SDL_TEXTUREACCESS_STATIC, Vec2iNew(w, h),
 			SDL_BLENDMODE_NONE, 255);
@@ -369,6 +377,7 @@ void GraphicsTerminate(GraphicsDevice *g)
 {
 	debug(D_NORMAL, "Shutting down video...\n");
 	CArrayTerminate(&g->validModes);
+	CArrayTerminate(&g->dirtyRects);
 	SDL_FreeSurface(g->icon);
 	SDL_DestroyTexture(g->screen);
 	SDL_DestroyTexture(g->bkg);
@@ -378,6 +387,7 @@ void GraphicsTerminate(GraphicsDevice *g)
 	SDL_DestroyWindow(g->window);
 	SDL_VideoQuit();
 	CFREE(g->buf);
+	CFREE(g->lastBuf);
 }
 
 int GraphicsGetScreenSize(GraphicsConfig *config)
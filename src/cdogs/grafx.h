@@ -96,6 +96,14 @@ typedef struct
 	int modeIndex;
 	BlitClipping clipping;
 	Uint32 *buf;
+	// Copy of what was last uploaded to the screen texture, so that only
+	// the changed regions are uploaded
+	Uint32 *lastBuf;
+	CArray dirtyRects;	// of Rect2i
+	// Frames left to upload in full, without comparing against lastBuf,
+	// after a frame that changed most of the screen; lastBuf is stale
+	// until the last of these
+	int fullUploadFrames;
 	SDL_Texture *bkg;
 	SDL_Texture *brightnessOverlay;
 } GraphicsDevice;
@@ -29,6 +29,7 @@
 
 #include "actors.h"
 #include "ai.h"
+#include "blit.h"
 #include "draw/draw.h"
 #include "draw/drawtools.h"
 #include "game_events.h"
@@ -68,14 +69,7 @@ void GrafxDrawBackground(
 
 	if (!HSVEquals(tint, tintNone))
 	{
-		Vec2i v;
-		for (v.y = 0; v.y < g->cachedConfig.Res.y; v.y++)
-		{
-			for (v.x = 0; v.x < g->cachedConfig.Res.x; v.x++)
-			{
-				DrawPointTint(g, v, tint);
-			}
-		}
+		BlitTintRect(g, Vec2iZero(), g->cachedConfig.Res, tint);
 	}
 	SDL_UpdateTexture(
 		g->bkg, NULL, g->buf, g->cachedConfig.Res.x * sizeof(Uint32));
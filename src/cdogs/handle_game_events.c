@@ -88,12 +88,13 @@ static void HandleGameEvent(
 			Vec2i pos = Net2Vec2i(e.u.TileSet.Pos);
 			for (int i = 0; i <= e.u.TileSet.RunLength; i++)
 			{
+				MapSetTileFlags(&gMap, pos, e.u.TileSet.Flags);
 				Tile *t = MapGetTile(&gMap, pos);
-				t->flags = e.u.TileSet.Flags;
 				t->pic = PicManagerGetNamedPic(
 					&gPicManager, e.u.TileSet.PicName);
 				t->picAlt = PicManagerGetNamedPic(
 					&gPicManager, e.u.TileSet.PicAltName);
+				MapMarkTileChanged(&gMap, pos);
 				pos.x++;
 				if (pos.x == gMap.Size.x)
 				{
@@ -442,7 +443,8 @@ static void HandleGameEvent(
 			// Sound
 			if (e.u.GunFire.Sound && g->Sound)
 			{
-				SoundPlayAt(&gSoundDevice, g->Sound, Vec2iFull2Real(fullPos));
+				SoundPlayAt(
+					&gSoundDevice, StrSound(g->Sound), Vec2iFull2Real(fullPos));
 			}
 			// Screen shake
 			if (g->ShakeAmount > 0)
@@ -467,7 +469,7 @@ static void HandleGameEvent(
 			const Vec2i fullPos = Net2Vec2i(e.u.GunReload.FullPos);
 			SoundPlayAtPlusDistance(
 				&gSoundDevice,
-				g->ReloadSound,
+				StrSound(g->ReloadSound),
 				Vec2iFull2Real(fullPos),
 				RELOAD_DISTANCE_PLUS);
 			// Brass shells
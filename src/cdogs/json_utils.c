@@ -29,7 +29,9 @@
 #include "json_utils.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "config.h"
 #include "log.h"
@@ -67,6 +69,31 @@ void AddColorPair(json_t *parent, const char *name, const color_t c)
 	AddStringPair(parent, name, buf);
 }
 
+// Numbers are converted once by the parser; other values, such as numbers
+// saved as strings, are converted from their text
+static int NodeInt(const json_t *node)
+{
+	// Fractions and exponents are read as atoi always did, e.g. 1e3 as 1
+	if (node->type != JSON_NUMBER || strpbrk(node->text, ".eE") != NULL)
+	{
+		return atoi(node->text);
+	}
+	// Out of range integers would be undefined to convert; clamp them
+	if (node->number <= INT_MIN)
+	{
+		return INT_MIN;
+	}
+	if (node->number >= INT_MAX)
+	{
+		return INT_MAX;
+	}
+	return (int)node->number;
+}
+static double NodeDouble(const json_t *node)
+{
+	return node->type == JSON_NUMBER ? node->number : atof(node->text);
+}
+
 int TryLoadValue(json_t **node, const char *name)
 {
 	if (*node == NULL || (*node)->type != JSON_OBJECT)
@@ -99,7 +126,7 @@ void LoadInt(int *value, json_t *node, const char *name)
 	{
 		return;
 	}
-	*value = atoi(node->text);
+	*value = NodeInt(node);
 }
 void LoadDouble(double *value, json_t *node, const char *name)
 {
@@ -107,7 +134,7 @@ void LoadDouble(double *value, json_t *node, const char *name)
 	{
 		return;
 	}
-	*value = atof(node->text);
+	*value = NodeDouble(node);
 }
 void LoadVec2i(Vec2i *value, json_t *node, const char *name)
 {
@@ -116,9 +143,9 @@ void LoadVec2i(Vec2i *value, json_t *node, const char *name)
 		return;
 	}
 	node = node->child;
-	value->x = atoi(node->text);
+	value->x = NodeInt(node);
 	node = node->next;
-	value->y = atoi(node->text);
+	value->y = NodeInt(node);
 }
 void LoadStr(char **value, json_t *node, const char *name)
 {
@@ -184,9 +211,21 @@ json_t *JSONFindNode(json_t *node, const char *path)
 {
 	char *pathCopy;
 	CSTRDUP(pathCopy, path);
-	char *pch = strtok(pathCopy, "/");
-	while (pch != NULL)
+	// Split by hand rather than with strtok, which isn't thread-safe
+	char *pch = pathCopy;
+	while (*pch == '/') pch++;
+	while (*pch != '\0')
 	{
+		char *next = strchr(pch, '/');
+		if (next != NULL)
+		{
+			*next++ = '\0';
+			while (*next == '/') next++;
+		}
+		else
+		{
+			next = pch + strlen(pch);
+		}
 		node = json_find_first_label(node, pch);
 		if (node == NULL)
 		{
@@ -197,7 +236,7 @@ json_t *JSONFindNode(json_t *node, const char *path)
 		{
 			goto bail;
 		}
-		pch = strtok(NULL, "/");
+		pch = next;
 	}
 bail:
 	CFREE(pathCopy);
@@ -49,6 +49,7 @@ static LogModuleInfo sModuleInfo[] =
 	{ LL_WARN, "MAP" },
 	{ LL_INFO, "EDIT" },
 	{ LL_INFO, "PATH" },
+	{ LL_INFO, "MEM" },
 };
 
 
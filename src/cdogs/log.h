@@ -43,6 +43,7 @@ typedef enum
 	LM_MAP,
 	LM_EDIT,
 	LM_PATH,
+	LM_MEM,
 	LM_COUNT
 } LogModule;
 const char *LogModuleName(const LogModule m);
@@ -150,8 +150,8 @@ void LOSCalcFrom(Map *map, const Vec2i pos, const bool explore)
 	{
 		for (end.x = origin.x; end.x < origin.x + perimSize.x; end.x++)
 		{
-			const Tile *tile = MapGetTile(map, end);
-			if (!tile || !(tile->flags & MAPTILE_NO_SEE))
+			if (!MapIsTileIn(map, end) ||
+				!MapPlaneGet(map, MAP_PLANE_NO_SEE, end))
 			{
 				continue;
 			}
@@ -195,7 +195,7 @@ static void SetLOSVisible(Map *map, const Vec2i pos, const bool explore)
 	const Tile *t = MapGetTile(map, pos);
 	if (t == NULL) return;
 	*((bool *)CArrayGet(&map->LOS.LOS, pos.y * map->Size.x + pos.x)) = true;
-	if (!t->isVisited && explore)
+	if (explore && !MapPlaneGet(map, MAP_PLANE_VISITED, pos))
 	{
 		// Cache the newly explored tile
 		*((bool *)CArrayGet(&map->LOS.Explored, pos.y * map->Size.x + pos.x)) = true;
@@ -217,11 +217,10 @@ static bool IsNextTileBlockedAndSetVisibility(void *data, Vec2i pos)
 	// Check sight range
 	if (DistanceSquared(lData->Center, pos) >= lData->SightRange2) return true;
 	// Check map range
-	const Tile *t = MapGetTile(lData->Map, pos);
-	if (t == NULL) return true;
+	if (!MapIsTileIn(lData->Map, pos)) return true;
 	SetLOSVisible(lData->Map, pos, lData->Explore);
 	// Check if this tile is an obstruction
-	return t->flags & MAPTILE_NO_SEE;
+	return MapPlaneGet(lData->Map, MAP_PLANE_NO_SEE, pos);
 }
 static bool IsTileVisibleNonObstruction(Map *map, const Vec2i pos);
 static void SetObstructionVisible(
@@ -242,9 +241,10 @@ static void SetObstructionVisible(
 }
 static bool IsTileVisibleNonObstruction(Map *map, const Vec2i pos)
 {
-	const Tile *t = MapGetTile(map, pos);
-	if (t == NULL) return false;
-	return !(t->flags & MAPTILE_NO_SEE) && LOSTileIsVisible(map, pos);
+	if (!MapIsTileIn(map, pos)) return false;
+	return
+		!MapPlaneGet(map, MAP_PLANE_NO_SEE, pos) &&
+		*((bool *)CArrayGet(&map->LOS.LOS, pos.y * map->Size.x + pos.x));
 }
 
 bool LOSAddRun(
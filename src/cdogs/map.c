@@ -52,6 +52,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <SDL_timer.h>
+
 #include "algorithms.h"
 #include "ammo.h"
 #include "collision.h"
@@ -59,6 +61,7 @@
 #include "door.h"
 #include "game_events.h"
 #include "gamedata.h"
+#include "log.h"
 #include "los.h"
 #include "map_build.h"
 #include "map_cave.h"
@@ -79,6 +82,7 @@
 #define COLLECTABLE_H 3
 
 Map gMap;
+static int sMapLoadId = 0;
 
 
 const char *IMapTypeStr(IMapType t)
@@ -125,6 +129,46 @@ Tile *MapGetTile(Map *map, Vec2i pos)
 	return CArrayGet(&map->Tiles, pos.y * map->Size.x + pos.x);
 }
 
+static void PlaneSet(
+	Map *map, const MapPlane p, const Vec2i pos, const bool value)
+{
+	uint32_t *w = &map->Planes[p][pos.y * map->PlaneStride + (pos.x >> 5)];
+	const uint32_t bit = 1u << (pos.x & 31);
+	*w = value ? (*w | bit) : (*w & ~bit);
+}
+static void PlanesUpdate(Map *map, const Vec2i pos, const int flags)
+{
+	PlaneSet(map, MAP_PLANE_NO_WALK, pos, flags & MAPTILE_NO_WALK);
+	PlaneSet(map, MAP_PLANE_NO_SEE, pos, flags & MAPTILE_NO_SEE);
+	PlaneSet(map, MAP_PLANE_NO_SHOOT, pos, flags & MAPTILE_NO_SHOOT);
+	PlaneSet(map, MAP_PLANE_WALL, pos, flags & MAPTILE_IS_WALL);
+}
+void MapSetTileFlags(Map *map, const Vec2i pos, const int flags)
+{
+	MapGetTile(map, pos)->flags = flags;
+	PlanesUpdate(map, pos, flags);
+}
+void MapMarkTileChanged(Map *map, const Vec2i pos)
+{
+	map->ChunkVersions[
+		(pos.y / MAP_CHUNK_SIZE) * map->ChunksSize.x +
+		pos.x / MAP_CHUNK_SIZE]++;
+}
+// Sync the planes from the tiles, after the map has been built
+static void MapPlanesRebuild(Map *map)
+{
+	Vec2i v;
+	for (v.y = 0; v.y < map->Size.y; v.y++)
+	{
+		for (v.x = 0; v.x < map->Size.x; v.x++)
+		{
+			const Tile *t = MapGetTile(map, v);
+			PlanesUpdate(map, v, t->flags);
+			PlaneSet(map, MAP_PLANE_VISITED, v, t->isVisited);
+		}
+	}
+}
+
 bool MapIsTileIn(const Map *map, const Vec2i pos)
 {
 	// Check that the tile pos is within the interior of the map
@@ -258,6 +302,7 @@ void MapChangeFloor(
 		{
 			t->pic = normal;
 		}
+		MapMarkTileChanged(map, pos);
 		break;
 	default:
 		// do nothing
@@ -611,21 +656,11 @@ static void MapSetupDoors(Map *map, const Mission *m)
 
 void MapTerminate(Map *map)
 {
-	CA_FOREACH(Trigger *, t, map->triggers)
-		TriggerTerminate(*t);
-	CA_FOREACH_END()
+	// Tiles, triggers and watch data all live in the arena
 	CArrayTerminate(&map->triggers);
-	Vec2i v;
-	for (v.y = 0; v.y < map->Size.y; v.y++)
-	{
-		for (v.x = 0; v.x < map->Size.x; v.x++)
-		{
-			Tile *t = MapGetTile(map, v);
-			TileDestroy(t);
-		}
-	}
 	CArrayTerminate(&map->Tiles);
 	CArrayTerminate(&map->iMap);
+	ArenaTerminate(&map->arena);
 	LOSTerminate(&map->LOS);
 	PathCacheTerminate(&gPathCache);
 }
@@ -633,15 +668,38 @@ void MapLoad(
 	Map *map, const struct MissionOptions *mo, const CampaignOptions *co)
 {
 	MapTerminate(map);
+	const Uint32 ticksStart = SDL_GetTicks();
 
 	// Init map
 	memset(map, 0, sizeof *map);
-	CArrayInit(&map->Tiles, sizeof(Tile));
-	CArrayInit(&map->iMap, sizeof(unsigned short));
+	ArenaInit(&map->arena, ARENA_DEFAULT_CHUNK_SIZE);
 	const Mission *mission = mo->missionData;
 	map->Size = mission->Size;
+	const int numTiles = map->Size.x * map->Size.y;
+	CArrayInitArena(&map->Tiles, sizeof(Tile), &map->arena);
+	CArrayReserve(&map->Tiles, numTiles);
+	CArrayInitArena(&map->iMap, sizeof(unsigned short), &map->arena);
+	CArrayReserve(&map->iMap, numTiles);
+	map->PlaneStride = (map->Size.x + 31) / 32;
+	for (int i = 0; i < (int)MAP_PLANE_COUNT; i++)
+	{
+		map->Planes[i] = ArenaAlloc(
+			&map->arena,
+			map->PlaneStride * map->Size.y * sizeof *map->Planes[i]);
+	}
+	map->LoadId = ++sMapLoadId;
+	map->ChunksSize = Vec2iNew(
+		(map->Size.x + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE,
+		(map->Size.y + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE);
+	map->ChunkVersions = ArenaAlloc(
+		&map->arena,
+		map->ChunksSize.x * map->ChunksSize.y * sizeof *map->ChunkVersions);
+	map->ChunkVisitVersions = ArenaAlloc(
+		&map->arena,
+		map->ChunksSize.x * map->ChunksSize.y *
+		sizeof *map->ChunkVisitVersions);
 	LOSInit(map, map->Size);
-	CArrayInit(&map->triggers, sizeof(Trigger *));
+	CArrayInitArena(&map->triggers, sizeof(Trigger *), &map->arena);
 	PathCacheInit(&gPathCache, map);
 
 	Vec2i v;
@@ -651,7 +709,7 @@ void MapLoad(
 		{
 			Tile t;
 			unsigned short tI = MAP_FLOOR;
-			TileInit(&t);
+			TileInit(&t, &map->arena);
 			CArrayPushBack(&map->Tiles, &t);
 			CArrayPushBack(&map->iMap, &tI);
 		}
@@ -675,6 +733,7 @@ void MapLoad(
 
 	MapSetupTilesAndWalls(map, mission);
 	MapSetupDoors(map, mission);
+	MapPlanesRebuild(map);
 
 	if (mission->Type == MAPTYPE_CLASSIC)
 	{
@@ -707,12 +766,23 @@ void MapLoad(
 	{
 		for (v.x = 0; v.x < map->Size.x; v.x++)
 		{
-			if (!(MapGetTile(map, v)->flags & MAPTILE_NO_WALK))
+			if (!MapPlaneGet(map, MAP_PLANE_NO_WALK, v))
 			{
 				map->NumExplorableTiles++;
 			}
 		}
 	}
+
+	LOG(LM_MAP, LL_DEBUG, "loaded %dx%d map in %dms",
+		map->Size.x, map->Size.y, (int)(SDL_GetTicks() - ticksStart));
+	LOG(LM_MAP, LL_DEBUG,
+		"arena: %d allocs, %d/%d bytes used in %d chunks, "
+		"%d bytes wasted (%d%%)",
+		map->arena.numAllocs, (int)map->arena.used,
+		(int)map->arena.capacity, map->arena.numChunks,
+		(int)map->arena.wasted,
+		map->arena.capacity > 0 ?
+		(int)(map->arena.wasted * 100 / map->arena.capacity) : 0);
 }
 
 static void AddObjectives(Map *map, const struct MissionOptions *mo);
@@ -876,11 +946,19 @@ bool MapIsTileAreaClear(Map *map, const Vec2i fullPos, const Vec2i size)
 
 void MapMarkAsVisited(Map *map, Vec2i pos)
 {
-	Tile *t = MapGetTile(map, pos);
-	if (!t->isVisited && !(t->flags & MAPTILE_NO_WALK))
+	if (!MapPlaneGet(map, MAP_PLANE_VISITED, pos) &&
+		!MapPlaneGet(map, MAP_PLANE_NO_WALK, pos))
 	{
 		map->tilesSeen++;
 	}
+	PlaneSet(map, MAP_PLANE_VISITED, pos, true);
+	Tile *t = MapGetTile(map, pos);
+	if (!t->isVisited)
+	{
+		map->ChunkVisitVersions[
+			(pos.y / MAP_CHUNK_SIZE) * map->ChunksSize.x +
+			pos.x / MAP_CHUNK_SIZE]++;
+	}
 	t->isVisited = true;
 }
 
@@ -944,14 +1022,15 @@ Vec2i MapSearchTileAround(Map *map, Vec2i start, TileSelectFunc func)
 }
 bool MapTileIsUnexplored(Map *map, Vec2i tile)
 {
-	const Tile *t = MapGetTile(map, tile);
-	return !t->isVisited && !(t->flags & MAPTILE_NO_WALK);
+	return
+		!MapPlaneGet(map, MAP_PLANE_VISITED, tile) &&
+		!MapPlaneGet(map, MAP_PLANE_NO_WALK, tile);
 }
 
 // Only creates the trigger, but does not place it
 Trigger *MapNewTrigger(Map *map)
 {
-	Trigger *t = TriggerNew();
+	Trigger *t = TriggerNew(&map->arena);
 	CArrayPushBack(&map->triggers, &t);
 	t->id = map->triggerId++;
 	return t;
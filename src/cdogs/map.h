@@ -49,7 +49,9 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "arena.h"
 #include "campaigns.h"
 #include "map_object.h"
 #include "mission.h"
@@ -91,8 +93,38 @@ typedef struct
 	CArray Explored; // of bool
 } LineOfSight;
 
+// Packed per-tile flags for the hot walk/see/shoot/visited queries, one bit
+// per tile in row-major order. These are authoritative for collision, LOS
+// and pathing; the Tile array holds the cold data (pics, triggers, things)
+// and keeps a mirror of the flags for drawing and serialisation.
+// Change tile flags with MapSetTileFlags so both stay in sync.
+typedef enum
+{
+	MAP_PLANE_NO_WALK,
+	MAP_PLANE_NO_SEE,
+	MAP_PLANE_NO_SHOOT,
+	MAP_PLANE_WALL,
+	MAP_PLANE_VISITED,
+	MAP_PLANE_COUNT
+} MapPlane;
+
+// Size in tiles of the square chunks that static map layers are cached in
+#define MAP_CHUNK_SIZE 16
+
 typedef struct
 {
+	// Owns the tiles and their side arrays, triggers and watches;
+	// released in one go when the map is terminated
+	Arena arena;
+	uint32_t *Planes[MAP_PLANE_COUNT];
+	int PlaneStride;	// 32-bit words per row
+	// Unique per load, plus a change counter per chunk, so that caches of
+	// tile graphics know when they are stale, and one for tiles becoming
+	// visited, for caches of the explored map
+	int LoadId;
+	Vec2i ChunksSize;
+	int *ChunkVersions;
+	int *ChunkVisitVersions;
 	CArray Tiles;	// of Tile
 	Vec2i Size;
 
@@ -101,7 +133,7 @@ typedef struct
 
 	LineOfSight LOS;
 
-	CArray triggers;	// of Trigger *; owner
+	CArray triggers;	// of Trigger *
 	int triggerId;
 
 	int tilesSeen;
@@ -117,8 +149,20 @@ extern Map gMap;
 
 unsigned short GetAccessMask(int k);
 
+// Compatibility accessor for the cold per-tile data
 Tile *MapGetTile(Map *map, Vec2i pos);
 bool MapIsTileIn(const Map *map, const Vec2i pos);
+// Tile must be within the map
+static inline bool MapPlaneGet(
+	const Map *map, const MapPlane p, const Vec2i tile)
+{
+	const uint32_t w =
+		map->Planes[p][tile.y * map->PlaneStride + (tile.x >> 5)];
+	return (w >> (tile.x & 31)) & 1;
+}
+void MapSetTileFlags(Map *map, const Vec2i pos, const int flags);
+// Call after changing a tile's pics, to invalidate cached graphics
+void MapMarkTileChanged(Map *map, const Vec2i pos);
 bool MapIsRealPosIn(const Map *map, const Vec2i realPos);
 bool MapIsTileInExit(const Map *map, const TTileItem *ti);
 
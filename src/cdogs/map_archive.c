@@ -36,17 +36,49 @@
 #include "json_utils.h"
 #include "log.h"
 #include "map_new.h"
+#include "map_pack.h"
+#include "map_tiles.h"
 #include "pickup.h"
 
 
 static char *ReadFileIntoBuf(const char *path, const char *mode, long *len);
 
-static json_t *ReadArchiveJSON(const char *archive, const char *filename);
+// A campaign directory, or a packed campaign file
+typedef struct
+{
+	const char *Path;
+	MapPack *Pack;	// NULL for directories
+} Archive;
+static bool ArchiveOpen(Archive *a, const char *filename)
+{
+	a->Path = filename;
+	a->Pack = NULL;
+	if (MapPackIsPack(filename))
+	{
+		a->Pack = MapPackOpen(filename);
+		return a->Pack != NULL;
+	}
+	return true;
+}
+static void ArchiveClose(Archive *a)
+{
+	// Anything that still uses the pack, like sounds, holds a reference
+	MapPackUnref(a->Pack);
+	a->Pack = NULL;
+}
+
+static json_t *ReadArchiveJSON(const Archive *a, const char *filename);
 int MapNewScanArchive(
 	const char *filename, char **title, int *numMissions)
 {
 	int err = 0;
-	json_t *root = ReadArchiveJSON(filename, "campaign.json");
+	json_t *root = NULL;
+	Archive archive;
+	if (!ArchiveOpen(&archive, filename))
+	{
+		return -1;
+	}
+	root = ReadArchiveJSON(&archive, "campaign.json");
 	if (root == NULL)
 	{
 		err = -1;
@@ -60,17 +92,28 @@ int MapNewScanArchive(
 
 bail:
 	json_free_value(&root);
+	ArchiveClose(&archive);
 	return err;
 }
 
 static void LoadArchiveSounds(
-	SoundDevice *device, const char *archive, const char *dirname);
-static void LoadArchivePics(PicManager *pm, map_t cc, const char *archive);
+	SoundDevice *device, const Archive *a, const char *dirname);
+static void LoadArchivePics(PicManager *pm, map_t cc, const Archive *a);
 int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 {
 	LOG(LM_MAP, LL_DEBUG, "Loading archive map %s", filename);
 	int err = 0;
-	json_t *root = ReadArchiveJSON(filename, "campaign.json");
+	json_t *root = NULL;
+	Archive archive;
+	if (!ArchiveOpen(&archive, filename))
+	{
+		return -1;
+	}
+	if (archive.Pack != NULL)
+	{
+		MapPackWillNeed(archive.Pack);
+	}
+	root = ReadArchiveJSON(&archive, "campaign.json");
 	if (root == NULL)
 	{
 		err = -1;
@@ -87,38 +130,39 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	json_free_value(&root);
 
 	// Load any custom data
-	LoadArchiveSounds(&gSoundDevice, filename, "sounds");
+	LoadArchiveSounds(&gSoundDevice, &archive, "sounds");
 
-	LoadArchivePics(&gPicManager, gCharSpriteClasses.customClasses, filename);
+	LoadArchivePics(
+		&gPicManager, gCharSpriteClasses.customClasses, &archive);
 
-	root = ReadArchiveJSON(filename, "particles.json");
+	root = ReadArchiveJSON(&archive, "particles.json");
 	if (root != NULL)
 	{
 		ParticleClassesLoadJSON(&gParticleClasses.CustomClasses, root);
 	}
 
-	root = ReadArchiveJSON(filename, "character_classes.json");
+	root = ReadArchiveJSON(&archive, "character_classes.json");
 	if (root != NULL)
 	{
 		CharacterClassesLoadJSON(
 			&gCharacterClasses.CustomClasses, root);
 	}
 
-	root = ReadArchiveJSON(filename, "bullets.json");
+	root = ReadArchiveJSON(&archive, "bullets.json");
 	if (root != NULL)
 	{
 		BulletLoadJSON(
 			&gBulletClasses, &gBulletClasses.CustomClasses, root);
 	}
 
-	root = ReadArchiveJSON(filename, "ammo.json");
+	root = ReadArchiveJSON(&archive, "ammo.json");
 	if (root != NULL)
 	{
 		AmmoLoadJSON(&gAmmo.CustomAmmo, root);
 		json_free_value(&root);
 	}
 
-	root = ReadArchiveJSON(filename, "guns.json");
+	root = ReadArchiveJSON(&archive, "guns.json");
 	if (root != NULL)
 	{
 		WeaponLoadJSON(
@@ -128,7 +172,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 
 	BulletLoadWeapons(&gBulletClasses);
 
-	root = ReadArchiveJSON(filename, "pickups.json");
+	root = ReadArchiveJSON(&archive, "pickups.json");
 	if (root != NULL)
 	{
 		PickupClassesLoadJSON(&gPickupClasses.CustomClasses, root);
@@ -140,7 +184,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 
 	// Reset custom map objects
 	MapObjectsClear(&gMapObjects.CustomClasses);
-	root = ReadArchiveJSON(filename, "map_objects.json");
+	root = ReadArchiveJSON(&archive, "map_objects.json");
 	if (root != NULL)
 	{
 		MapObjectsLoadJSON(&gMapObjects.CustomClasses, root);
@@ -149,7 +193,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 		&gMapObjects, &gAmmo, &gGunDescriptions, true);
 
 
-	root = ReadArchiveJSON(filename, "missions.json");
+	root = ReadArchiveJSON(&archive, "missions.json");
 	if (root == NULL)
 	{
 		err = -1;
@@ -160,7 +204,7 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 	json_free_value(&root);
 
 	// Note: some campaigns don't have characters (e.g. dogfights)
-	root = ReadArchiveJSON(filename, "characters.json");
+	root = ReadArchiveJSON(&archive, "characters.json");
 	if (root != NULL)
 	{
 		CharacterLoadJSON(&c->characters, root, version);
@@ -168,19 +212,33 @@ int MapNewLoadArchive(const char *filename, CampaignSetting *c)
 
 bail:
 	json_free_value(&root);
+	ArchiveClose(&archive);
 	return err;
 }
 
-static json_t *ReadArchiveJSON(const char *archive, const char *filename)
+static json_t *ReadArchiveJSON(const Archive *a, const char *filename)
 {
 	json_t *root = NULL;
-	debug(D_VERBOSE, "Loading archive json %s %s\n", archive, filename);
-	char path[CDOGS_PATH_MAX];
-	sprintf(path, "%s/%s", archive, filename);
-	long len;
-	char *buf = ReadFileIntoBuf(path, "rb", &len);
-	if (buf == NULL) goto bail;
-	const enum json_error e = json_parse_document(&root, buf);
+	char *buf = NULL;
+	enum json_error e;
+	debug(D_VERBOSE, "Loading archive json %s %s\n", a->Path, filename);
+	if (a->Pack != NULL)
+	{
+		// Parse straight from the pack
+		size_t size;
+		const char *data = MapPackGet(a->Pack, filename, &size);
+		if (data == NULL) goto bail;
+		e = json_parse_buffer(&root, data, size);
+	}
+	else
+	{
+		char path[CDOGS_PATH_MAX];
+		sprintf(path, "%s/%s", a->Path, filename);
+		long len;
+		buf = ReadFileIntoBuf(path, "rb", &len);
+		if (buf == NULL) goto bail;
+		e = json_parse_document(&root, buf);
+	}
 	if (e != JSON_OK)
 	{
 		LOG(LM_MAP, LL_ERROR, "Invalid syntax in JSON file (%s) error(%d)",
@@ -195,18 +253,33 @@ bail:
 }
 
 static void LoadArchiveSounds(
-	SoundDevice *device, const char *archive, const char *dirname)
+	SoundDevice *device, const Archive *a, const char *dirname)
 {
-	char path[CDOGS_PATH_MAX];
-	sprintf(path, "%s/%s", archive, dirname);
-	SoundLoadDir(device->customSounds, path, NULL);
+	if (a->Pack != NULL)
+	{
+		SoundLoadPack(device->customSounds, a->Pack, dirname);
+	}
+	else
+	{
+		char path[CDOGS_PATH_MAX];
+		sprintf(path, "%s/%s", a->Path, dirname);
+		SoundLoadDir(device->customSounds, path, NULL);
+	}
+	SoundPrefetch(device);
 }
-static void LoadArchivePics(PicManager *pm, map_t cc, const char *archive)
+static void LoadArchivePics(PicManager *pm, map_t cc, const Archive *a)
 {
+	if (a->Pack != NULL)
+	{
+		PicManagerLoadPack(
+			pm, a->Pack, "graphics", pm->customPics, pm->customSprites);
+		CharSpriteClassesLoadPack(cc, a->Pack);
+		return;
+	}
 	char path[CDOGS_PATH_MAX];
-	sprintf(path, "%s/graphics", archive);
+	sprintf(path, "%s/graphics", a->Path);
 	PicManagerLoadDir(pm, path, NULL, pm->customPics, pm->customSprites);
-	CharSpriteClassesLoadDir(cc, archive);
+	CharSpriteClassesLoadDir(cc, a->Path);
 }
 
 static char *ReadFileIntoBuf(const char *path, const char *mode, long *len)
@@ -464,33 +537,9 @@ static json_t *SaveClassicDoors(Mission *m)
 
 static json_t *SaveStaticTiles(Mission *m)
 {
-	// Create a text buffer for CSV
-	// The buffer will contain n*5 chars (tiles, allow 5 chars each),
-	// and n - 1 commas, so 6n total
-	const int size = (int)m->u.Static.Tiles.size;
-	if (size == 0)
-	{
-		return json_new_string("");
-	}
-	char *bigbuf;
-	CCALLOC(bigbuf, size * 6);
-	char *pBuf = bigbuf;
-	CASSERT(pBuf != NULL, "memory error");
-	for (int i = 0; i < size; i++)
-	{
-		char buf[32];
-		sprintf(buf, "%d", *(unsigned short *)CArrayGet(
-			&m->u.Static.Tiles, i));
-		strcpy(pBuf, buf);
-		pBuf += strlen(buf);
-		if (i < size - 1)
-		{
-			*pBuf = ',';
-			pBuf++;
-		}
-	}
-	json_t *node = json_new_string(bigbuf);
-	CFREE(bigbuf);
+	char *tiles = MapTilesEncode(&m->u.Static.Tiles);
+	json_t *node = json_new_string(tiles);
+	CFREE(tiles);
 	return node;
 }
 static json_t *SaveStaticItems(Mission *m)
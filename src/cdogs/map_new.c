@@ -36,6 +36,8 @@
 #include "json_utils.h"
 #include "log.h"
 #include "map_archive.h"
+#include "map_pack.h"
+#include "map_tiles.h"
 
 
 int MapNewScan(const char *filename, char **title, int *numMissions)
@@ -45,7 +47,8 @@ int MapNewScan(const char *filename, char **title, int *numMissions)
 	FILE *f = NULL;
 
 	if (strcmp(StrGetFileExt(filename), "cdogscpn") == 0 ||
-		strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0)
+		strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0 ||
+		MapPackIsPack(filename))
 	{
 		return MapNewScanArchive(filename, title, numMissions);
 	}
@@ -131,7 +134,8 @@ int MapNewLoad(const char *filename, CampaignSetting *c)
 	}
 
 	if (strcmp(StrGetFileExt(filename), "cdogscpn") == 0 ||
-		strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0)
+		strcmp(StrGetFileExt(filename), "CDOGSCPN") == 0 ||
+		MapPackIsPack(filename))
 	{
 		return MapNewLoadArchive(filename, c);
 	}
@@ -365,7 +369,18 @@ static void LoadStaticExit(Mission *m, json_t *node, char *name);
 static bool TryLoadStaticMap(Mission *m, json_t *node, int version)
 {
 	CArrayInit(&m->u.Static.Tiles, sizeof(unsigned short));
-	if (version == 1)
+	if (version >= 14)
+	{
+		// Base64 RLE; the text needs no unescaping
+		json_t *tiles = node;
+		if (!TryLoadValue(&tiles, "Tiles") || tiles->type != JSON_STRING ||
+			!MapTilesDecode(
+				&m->u.Static.Tiles, tiles->text, m->Size.x * m->Size.y))
+		{
+			return false;
+		}
+	}
+	else if (version == 1)
 	{
 		// JSON array
 		json_t *tiles = json_find_first_label(node, "Tiles");
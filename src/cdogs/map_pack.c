@@ -0,0 +1,454 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "map_pack.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <SDL_endian.h>
+#include <tinydir/tinydir.h>
+
+#include "log.h"
+#include "sys_config.h"
+#include "utils.h"
+
+// File layout, little endian:
+// - magic, version, number of members
+// - index: for each member, its offset, size, CRC-32, then its name as a
+//   length and the bytes including the terminator; sorted by name
+// - the members' data, each aligned, in the same order
+#define MAP_PACK_MAGIC "CDOGSPAK"
+#define MAP_PACK_VERSION 1
+#define MAP_PACK_ALIGN 8
+
+
+// CRC-32, a slice of 8 bytes at a time so that checking members costs
+// about as much as reading them
+static Uint32 crcTable[8][256];
+static void CRCInit(void)
+{
+	if (crcTable[0][1] != 0)
+	{
+		return;
+	}
+	for (Uint32 i = 0; i < 256; i++)
+	{
+		Uint32 c = i;
+		for (int j = 0; j < 8; j++)
+		{
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		crcTable[0][i] = c;
+	}
+	for (int i = 0; i < 256; i++)
+	{
+		for (int j = 1; j < 8; j++)
+		{
+			const Uint32 c = crcTable[j - 1][i];
+			crcTable[j][i] = crcTable[0][c & 0xFF] ^ (c >> 8);
+		}
+	}
+}
+static Uint32 CRCUpdate(Uint32 crc, const Uint8 *data, size_t size)
+{
+	crc = ~crc;
+	for (; size >= 8; data += 8, size -= 8)
+	{
+		const Uint32 lo = crc ^
+			(data[0] | (data[1] << 8) | (data[2] << 16) | ((Uint32)data[3] << 24));
+		crc =
+			crcTable[7][lo & 0xFF] ^ crcTable[6][(lo >> 8) & 0xFF] ^
+			crcTable[5][(lo >> 16) & 0xFF] ^ crcTable[4][lo >> 24] ^
+			crcTable[3][data[4]] ^ crcTable[2][data[5]] ^
+			crcTable[1][data[6]] ^ crcTable[0][data[7]];
+	}
+	for (; size > 0; data++, size--)
+	{
+		crc = crcTable[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+
+bool MapPackIsPack(const char *filename)
+{
+	const char *ext = StrGetFileExt(filename);
+	return ext != NULL &&
+		(strcmp(ext, MAP_PACK_EXT) == 0 || strcmp(ext, "CDOGSPAK") == 0);
+}
+
+static bool ReadU32(DataReader *r, Uint32 *value)
+{
+	if (!DataReaderRead(r, value, sizeof *value))
+	{
+		return false;
+	}
+	*value = SDL_SwapLE32(*value);
+	return true;
+}
+static bool ReadU64(DataReader *r, Uint64 *value)
+{
+	if (!DataReaderRead(r, value, sizeof *value))
+	{
+		return false;
+	}
+	*value = SDL_SwapLE64(*value);
+	return true;
+}
+static bool ReadIndex(MapPack *p)
+{
+	DataReader r = { p->File.Data, p->File.Size, 0 };
+	char magic[sizeof MAP_PACK_MAGIC - 1];
+	Uint32 version;
+	Uint32 count;
+	if (!DataReaderRead(&r, magic, sizeof magic) ||
+		memcmp(magic, MAP_PACK_MAGIC, sizeof magic) != 0 ||
+		!ReadU32(&r, &version) || version != MAP_PACK_VERSION ||
+		!ReadU32(&r, &count))
+	{
+		return false;
+	}
+	for (int i = 0; i < (int)count; i++)
+	{
+		Uint64 offset, size;
+		Uint32 checksum, nameLen;
+		if (!ReadU64(&r, &offset) || !ReadU64(&r, &size) ||
+			!ReadU32(&r, &checksum) || !ReadU32(&r, &nameLen) ||
+			nameLen == 0 || nameLen > CDOGS_PATH_MAX ||
+			nameLen > r.Size - r.Pos ||
+			r.Data[r.Pos + nameLen - 1] != '\0' ||
+			offset > p->File.Size || size > p->File.Size - offset)
+		{
+			return false;
+		}
+		MapPackMember m;
+		m.Name = (const char *)r.Data + r.Pos;
+		m.Data = p->File.Data + offset;
+		m.Size = (size_t)size;
+		m.Checksum = checksum;
+		m.IsChecked = false;
+		r.Pos += nameLen;
+		// Must be sorted for lookups
+		if (i > 0 &&
+			strcmp(((const MapPackMember *)CArrayGet(
+				&p->Members, i - 1))->Name, m.Name) >= 0)
+		{
+			return false;
+		}
+		CArrayPushBack(&p->Members, &m);
+	}
+	return true;
+}
+MapPack *MapPackOpen(const char *filename)
+{
+	MapPack *p;
+	CCALLOC(p, sizeof *p);
+	CArrayInit(&p->Members, sizeof(MapPackMember));
+	p->refCount = 1;
+	if (!FileDataLoad(&p->File, filename, false))
+	{
+		LOG(LM_MAP, LL_ERROR, "cannot read pack %s", filename);
+		goto bail;
+	}
+	if (!ReadIndex(p))
+	{
+		LOG(LM_MAP, LL_ERROR, "invalid pack %s", filename);
+		goto bail;
+	}
+	CRCInit();
+	return p;
+
+bail:
+	MapPackUnref(p);
+	return NULL;
+}
+void MapPackWillNeed(MapPack *p)
+{
+	FileDataWillNeed(&p->File);
+}
+
+MapPack *MapPackRef(MapPack *p)
+{
+	p->refCount++;
+	return p;
+}
+void MapPackUnref(MapPack *p)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+	p->refCount--;
+	if (p->refCount > 0)
+	{
+		return;
+	}
+	FileDataTerminate(&p->File);
+	CArrayTerminate(&p->Members);
+	CFREE(p);
+}
+
+static MapPackMember *FindMember(MapPack *p, const char *name)
+{
+	int lo = 0;
+	int hi = (int)p->Members.size - 1;
+	while (lo <= hi)
+	{
+		const int mid = (lo + hi) / 2;
+		MapPackMember *m = CArrayGet(&p->Members, mid);
+		const int cmp = strcmp(m->Name, name);
+		if (cmp < 0)
+		{
+			lo = mid + 1;
+		}
+		else if (cmp > 0)
+		{
+			hi = mid - 1;
+		}
+		else
+		{
+			return m;
+		}
+	}
+	return NULL;
+}
+bool MapPackHas(MapPack *p, const char *name)
+{
+	return FindMember(p, name) != NULL;
+}
+const void *MapPackGet(MapPack *p, const char *name, size_t *size)
+{
+	MapPackMember *m = FindMember(p, name);
+	if (m == NULL)
+	{
+		return NULL;
+	}
+	// Check members the first time they are used
+	if (!m->IsChecked)
+	{
+		if (CRCUpdate(0, m->Data, m->Size) != m->Checksum)
+		{
+			LOG(LM_MAP, LL_ERROR, "corrupt pack member %s", name);
+			return NULL;
+		}
+		m->IsChecked = true;
+	}
+	*size = m->Size;
+	return m->Data;
+}
+
+
+typedef struct
+{
+	char *Name;
+	char *Path;
+	Uint64 Size;
+	Uint32 Checksum;
+} PackFile;
+static void CollectFiles(CArray *files, const char *path, const char *prefix);
+static int ComparePackFiles(const void *v1, const void *v2);
+static bool WriteIndex(FILE *f, const CArray *files);
+static bool WriteFileData(FILE *f, PackFile *pf);
+bool MapPackCreate(const char *filename, const char *dir)
+{
+	bool ok = false;
+	CArray files;
+	CArrayInit(&files, sizeof(PackFile));
+	CollectFiles(&files, dir, NULL);
+	if (files.size == 0)
+	{
+		LOG(LM_MAP, LL_ERROR, "no files to pack in %s", dir);
+		goto bail;
+	}
+	qsort(files.data, files.size, files.elemSize, ComparePackFiles);
+	CRCInit();
+
+	FILE *f = FileReplaceOpen(filename, "wb");
+	if (f == NULL)
+	{
+		LOG(LM_MAP, LL_ERROR, "cannot write pack %s: %s",
+			filename, strerror(errno));
+		goto bail;
+	}
+	// Write the index once the checksums are known; the offsets only
+	// depend on the sizes
+	ok = WriteIndex(f, &files);
+	CA_FOREACH(PackFile, pf, files)
+		ok = ok && WriteFileData(f, pf);
+	CA_FOREACH_END()
+	ok = ok && fseek(f, 0, SEEK_SET) == 0 && WriteIndex(f, &files);
+	ok = FileReplaceClose(f, filename, ok);
+	if (!ok)
+	{
+		LOG(LM_MAP, LL_ERROR, "cannot write pack %s", filename);
+	}
+
+bail:
+	CA_FOREACH(PackFile, pf, files)
+		CFREE(pf->Name);
+		CFREE(pf->Path);
+	CA_FOREACH_END()
+	CArrayTerminate(&files);
+	return ok;
+}
+static void CollectFiles(CArray *files, const char *path, const char *prefix)
+{
+	tinydir_dir dir;
+	if (tinydir_open(&dir, path) == -1)
+	{
+		LOG(LM_MAP, LL_ERROR, "Error opening dir '%s': %s",
+			path, strerror(errno));
+		goto bail;
+	}
+	for (; dir.has_next; tinydir_next(&dir))
+	{
+		tinydir_file file;
+		if (tinydir_readfile(&dir, &file) == -1)
+		{
+			LOG(LM_MAP, LL_ERROR, "Cannot read file '%s': %s",
+				file.path, strerror(errno));
+			goto bail;
+		}
+		if (file.name[0] == '.')
+		{
+			continue;
+		}
+		// Names must fit when the pack is read back
+		char name[CDOGS_PATH_MAX];
+		const int nameLen = prefix != NULL ?
+			snprintf(name, sizeof name, "%s/%s", prefix, file.name) :
+			snprintf(name, sizeof name, "%s", file.name);
+		if (nameLen < 0 || nameLen >= (int)sizeof name)
+		{
+			LOG(LM_MAP, LL_ERROR, "Name too long to pack: '%s'", file.path);
+			continue;
+		}
+		if (file.is_dir)
+		{
+			CollectFiles(files, file.path, name);
+		}
+		else if (file.is_reg)
+		{
+			struct stat st;
+			if (stat(file.path, &st) != 0)
+			{
+				continue;
+			}
+			PackFile pf;
+			CSTRDUP(pf.Name, name);
+			CSTRDUP(pf.Path, file.path);
+			pf.Size = (Uint64)st.st_size;
+			pf.Checksum = 0;
+			CArrayPushBack(files, &pf);
+		}
+	}
+
+bail:
+	tinydir_close(&dir);
+}
+static int ComparePackFiles(const void *v1, const void *v2)
+{
+	const PackFile *pf1 = v1;
+	const PackFile *pf2 = v2;
+	return strcmp(pf1->Name, pf2->Name);
+}
+static bool WriteU32(FILE *f, const Uint32 value)
+{
+	const Uint32 le = SDL_SwapLE32(value);
+	return fwrite(&le, sizeof le, 1, f) == 1;
+}
+static bool WriteU64(FILE *f, const Uint64 value)
+{
+	const Uint64 le = SDL_SwapLE64(value);
+	return fwrite(&le, sizeof le, 1, f) == 1;
+}
+static Uint64 AlignOffset(const Uint64 offset)
+{
+	return (offset + MAP_PACK_ALIGN - 1) / MAP_PACK_ALIGN * MAP_PACK_ALIGN;
+}
+static bool WriteIndex(FILE *f, const CArray *files)
+{
+	Uint64 offset = sizeof MAP_PACK_MAGIC - 1 + 2 * sizeof(Uint32);
+	CA_FOREACH(const PackFile, pf, *files)
+		offset += 2 * sizeof(Uint64) + 2 * sizeof(Uint32) +
+			strlen(pf->Name) + 1;
+	CA_FOREACH_END()
+
+	bool ok =
+		fwrite(MAP_PACK_MAGIC, sizeof MAP_PACK_MAGIC - 1, 1, f) == 1 &&
+		WriteU32(f, MAP_PACK_VERSION) &&
+		WriteU32(f, (Uint32)files->size);
+	CA_FOREACH(const PackFile, pf, *files)
+		offset = AlignOffset(offset);
+		const Uint32 nameLen = (Uint32)strlen(pf->Name) + 1;
+		ok = ok &&
+			WriteU64(f, offset) && WriteU64(f, pf->Size) &&
+			WriteU32(f, pf->Checksum) && WriteU32(f, nameLen) &&
+			fwrite(pf->Name, nameLen, 1, f) == 1;
+		offset += pf->Size;
+	CA_FOREACH_END()
+	return ok;
+}
+static bool WriteFileData(FILE *f, PackFile *pf)
+{
+	static const Uint8 padding[MAP_PACK_ALIGN];
+	const long pos = ftell(f);
+	if (pos < 0 ||
+		fwrite(padding, 1, (size_t)(AlignOffset(pos) - pos), f) !=
+		(size_t)(AlignOffset(pos) - pos))
+	{
+		return false;
+	}
+	FILE *in = fopen(pf->Path, "rb");
+	if (in == NULL)
+	{
+		LOG(LM_MAP, LL_ERROR, "cannot read %s: %s", pf->Path, strerror(errno));
+		return false;
+	}
+	Uint8 buf[64 * 1024];
+	Uint64 size = 0;
+	size_t n;
+	bool ok = true;
+	while ((n = fread(buf, 1, sizeof buf, in)) > 0)
+	{
+		pf->Checksum = CRCUpdate(pf->Checksum, buf, n);
+		size += n;
+		if (fwrite(buf, 1, n, f) != n)
+		{
+			ok = false;
+			break;
+		}
+	}
+	fclose(in);
+	// The index has already been laid out with this size
+	return ok && size == pf->Size;
+}
@@ -0,0 +1,73 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_stdinc.h>
+
+#include "c_array.h"
+#include "utils.h"
+
+// Packed campaigns are a single file holding all the files of a .cdogscpn
+// campaign directory, with an index at the front; members are used in
+// place from the mapped file.
+#define MAP_PACK_EXT "cdogspak"
+
+typedef struct
+{
+	const char *Name;	// path relative to the campaign directory
+	const Uint8 *Data;
+	size_t Size;
+	Uint32 Checksum;
+	bool IsChecked;
+} MapPackMember;
+
+// Shared by whatever uses the members in place, such as sounds that are
+// decoded later; closed when the last reference is released
+typedef struct
+{
+	FileData File;
+	CArray Members;	// of MapPackMember, sorted by name
+	int refCount;
+} MapPack;
+
+bool MapPackIsPack(const char *filename);
+// Returns NULL if the file can't be read or isn't a valid pack
+MapPack *MapPackOpen(const char *filename);
+// Read the whole pack ahead, when it's about to be loaded rather than scanned
+void MapPackWillNeed(MapPack *p);
+MapPack *MapPackRef(MapPack *p);
+void MapPackUnref(MapPack *p);
+bool MapPackHas(MapPack *p, const char *name);
+// Returns the member's data, or NULL if it is missing or corrupt
+const void *MapPackGet(MapPack *p, const char *name, size_t *size);
+
+// Pack all the files in a campaign directory
+bool MapPackCreate(const char *filename, const char *dir);
@@ -0,0 +1,188 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "map_tiles.h"
+
+#include <string.h>
+
+#include <SDL_stdinc.h>
+
+#include "log.h"
+#include "utils.h"
+
+
+static const char base64Chars[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static Uint8 *PutVarint(Uint8 *p, unsigned int n);
+char *MapTilesEncode(const CArray *tiles)
+{
+	// Each run takes at most 3 bytes for the tile and 5 for the length
+	Uint8 *bytes;
+	CMALLOC(bytes, tiles->size * 8 + 1);
+	Uint8 *p = bytes;
+	const unsigned short *t = tiles->data;
+	for (size_t i = 0; i < tiles->size;)
+	{
+		size_t run = 1;
+		while (i + run < tiles->size && t[i + run] == t[i])
+		{
+			run++;
+		}
+		p = PutVarint(p, (unsigned int)run);
+		p = PutVarint(p, t[i]);
+		i += run;
+	}
+
+	const size_t len = p - bytes;
+	char *s;
+	CMALLOC(s, (len + 2) / 3 * 4 + 1);
+	char *out = s;
+	for (size_t i = 0; i < len; i += 3)
+	{
+		const unsigned int b =
+			(bytes[i] << 16) |
+			(i + 1 < len ? bytes[i + 1] << 8 : 0) |
+			(i + 2 < len ? bytes[i + 2] : 0);
+		*out++ = base64Chars[(b >> 18) & 63];
+		*out++ = base64Chars[(b >> 12) & 63];
+		*out++ = i + 1 < len ? base64Chars[(b >> 6) & 63] : '=';
+		*out++ = i + 2 < len ? base64Chars[b & 63] : '=';
+	}
+	*out = '\0';
+	CFREE(bytes);
+	return s;
+}
+static Uint8 *PutVarint(Uint8 *p, unsigned int n)
+{
+	while (n >= 0x80)
+	{
+		*p++ = (Uint8)(n | 0x80);
+		n >>= 7;
+	}
+	*p++ = (Uint8)n;
+	return p;
+}
+
+static int Base64Value(const char c);
+static bool GetVarint(
+	const Uint8 **p, const Uint8 *end, const unsigned int max,
+	unsigned int *n);
+bool MapTilesDecode(CArray *tiles, const char *s, const int count)
+{
+	bool ok = false;
+	const size_t slen = strlen(s);
+	Uint8 *bytes;
+	CMALLOC(bytes, slen / 4 * 3 + 3);
+	size_t len = 0;
+	if (slen % 4 != 0 || count < 0)
+	{
+		goto bail;
+	}
+	for (size_t i = 0; i < slen; i += 4)
+	{
+		int v[4];
+		for (int j = 0; j < 4; j++)
+		{
+			v[j] = Base64Value(s[i + j]);
+		}
+		// Padding is only allowed at the end
+		const bool isLast = i + 4 == slen;
+		if (v[0] < 0 || v[1] < 0 ||
+			(v[2] < 0 && !(isLast && s[i + 2] == '=' && s[i + 3] == '=')) ||
+			(v[3] < 0 && !(isLast && s[i + 3] == '=')))
+		{
+			goto bail;
+		}
+		bytes[len++] = (Uint8)((v[0] << 2) | (v[1] >> 4));
+		if (v[2] >= 0)
+		{
+			bytes[len++] = (Uint8)((v[1] << 4) | (v[2] >> 2));
+		}
+		if (v[3] >= 0)
+		{
+			bytes[len++] = (Uint8)((v[2] << 6) | v[3]);
+		}
+	}
+
+	// Expand the runs straight into the tiles
+	CArrayResize(tiles, count, NULL);
+	unsigned short *t = tiles->data;
+	int n = 0;
+	const Uint8 *p = bytes;
+	const Uint8 *end = bytes + len;
+	while (p < end)
+	{
+		unsigned int run, tile;
+		if (!GetVarint(&p, end, (unsigned int)(count - n), &run) ||
+			run == 0 ||
+			!GetVarint(&p, end, 0xFFFF, &tile))
+		{
+			goto bail;
+		}
+		for (unsigned int i = 0; i < run; i++)
+		{
+			t[n++] = (unsigned short)tile;
+		}
+	}
+	ok = n == count;
+
+bail:
+	if (!ok)
+	{
+		LOG(LM_MAP, LL_ERROR, "invalid map tiles");
+		CArrayClear(tiles);
+	}
+	CFREE(bytes);
+	return ok;
+}
+static int Base64Value(const char c)
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+static bool GetVarint(
+	const Uint8 **p, const Uint8 *end, const unsigned int max,
+	unsigned int *n)
+{
+	*n = 0;
+	for (int shift = 0; *p < end && shift < 28; shift += 7)
+	{
+		const Uint8 b = *(*p)++;
+		*n |= (unsigned int)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+		{
+			return *n <= max;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,455 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "mem_track.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL_atomic.h>
+
+#include "log.h"
+#include "utils.h"
+
+// Note: the tracker's own tables use plain malloc/free,
+// since the C* allocation macros route back into here.
+// Allocations can come from any thread, e.g. loader threads, so the
+// public functions hold sLock around the tables; it is a spin lock so that
+// it needs no setup before the first allocation.
+
+typedef struct
+{
+	char Name[64];
+	size_t Live;
+	size_t Peak;
+	int Count;
+} MemTrackSubsystem;
+typedef struct
+{
+	const char *File;
+	int Line;
+	int Subsystem;
+	size_t Live;
+	size_t Peak;
+	int Count;
+	int LoopCount;
+	bool Flagged;
+} MemTrackSite;
+typedef struct
+{
+	const void *P;
+	size_t Size;
+	int Site;
+} MemTrackEntry;
+
+static MemTrackSubsystem *sSubsystems = NULL;
+static int sNumSubsystems = 0;
+static MemTrackSite *sSites = NULL;
+static int sNumSites = 0;
+static int sSitesCap = 0;
+// Hash index into sSites, -1 for empty; size is a power of 2
+static int *sSiteIndex = NULL;
+static size_t sSiteIndexCap = 0;
+// Live allocations, open addressing by pointer; size is a power of 2
+static MemTrackEntry *sEntries = NULL;
+static size_t sEntriesCap = 0;
+static size_t sNumEntries = 0;
+
+static size_t sLive = 0;
+static size_t sPeak = 0;
+static int sAllocs = 0;
+static int sLoopDepth = 0;
+static int sLoopFrames = 0;
+static int sLoopAllocs = 0;
+static size_t sLoopBytes = 0;
+static SDL_SpinLock sLock = 0;
+
+
+static size_t HashPtr(const void *p)
+{
+	uintptr_t x = (uintptr_t)p;
+	x ^= x >> 17;
+	x *= (uintptr_t)0x9E3779B97F4A7C15ull;
+	return (size_t)(x ^ (x >> 29));
+}
+// Hash the file name's contents, not its address, to agree with the
+// string comparison in FindOrAddSite
+static size_t HashSite(const char *file, const int line)
+{
+	size_t h = 2166136261u;
+	for (const unsigned char *c = (const unsigned char *)file; *c; c++)
+	{
+		h = (h ^ *c) * 16777619u;
+	}
+	return h ^ ((size_t)line * 2654435761u);
+}
+
+static int FindOrAddSubsystem(const char *file)
+{
+	// Tag is the source file base name without extension
+	const char *base = file;
+	for (const char *c = file; *c; c++)
+	{
+		if (*c == '/' || *c == '\\') base = c + 1;
+	}
+	char name[64];
+	size_t len = strcspn(base, ".");
+	len = len < sizeof name - 1 ? len : sizeof name - 1;
+	memcpy(name, base, len);
+	name[len] = '\0';
+	for (int i = 0; i < sNumSubsystems; i++)
+	{
+		if (strcmp(sSubsystems[i].Name, name) == 0) return i;
+	}
+	MemTrackSubsystem *s = realloc(
+		sSubsystems, (sNumSubsystems + 1) * sizeof *sSubsystems);
+	if (s == NULL) abort();
+	sSubsystems = s;
+	MemTrackSubsystem *ss = &sSubsystems[sNumSubsystems];
+	memset(ss, 0, sizeof *ss);
+	strcpy(ss->Name, name);
+	return sNumSubsystems++;
+}
+
+static void SiteIndexInsert(const int site)
+{
+	const MemTrackSite *s = &sSites[site];
+	size_t i = HashSite(s->File, s->Line) & (sSiteIndexCap - 1);
+	while (sSiteIndex[i] != -1) i = (i + 1) & (sSiteIndexCap - 1);
+	sSiteIndex[i] = site;
+}
+static int FindOrAddSite(const char *file, const int line)
+{
+	if (sSiteIndexCap > 0)
+	{
+		size_t i = HashSite(file, line) & (sSiteIndexCap - 1);
+		for (; sSiteIndex[i] != -1; i = (i + 1) & (sSiteIndexCap - 1))
+		{
+			const MemTrackSite *s = &sSites[sSiteIndex[i]];
+			// __FILE__ literals are per translation unit, so compare strings
+			if (s->Line == line &&
+				(s->File == file || strcmp(s->File, file) == 0))
+			{
+				return sSiteIndex[i];
+			}
+		}
+	}
+	if (sNumSites == sSitesCap)
+	{
+		sSitesCap = sSitesCap == 0 ? 256 : sSitesCap * 2;
+		MemTrackSite *sites = realloc(sSites, sSitesCap * sizeof *sSites);
+		if (sites == NULL) abort();
+		sSites = sites;
+	}
+	MemTrackSite *s = &sSites[sNumSites];
+	memset(s, 0, sizeof *s);
+	s->File = file;
+	s->Line = line;
+	s->Subsystem = FindOrAddSubsystem(file);
+	sNumSites++;
+	// Keep the index at most half full
+	if ((size_t)sNumSites * 2 > sSiteIndexCap)
+	{
+		free(sSiteIndex);
+		sSiteIndexCap = sSiteIndexCap == 0 ? 512 : sSiteIndexCap * 2;
+		sSiteIndex = malloc(sSiteIndexCap * sizeof *sSiteIndex);
+		if (sSiteIndex == NULL) abort();
+		memset(sSiteIndex, -1, sSiteIndexCap * sizeof *sSiteIndex);
+		for (int i = 0; i < sNumSites; i++) SiteIndexInsert(i);
+	}
+	else
+	{
+		SiteIndexInsert(sNumSites - 1);
+	}
+	return sNumSites - 1;
+}
+
+static void EntryInsert(MemTrackEntry *entries, const size_t cap, MemTrackEntry e)
+{
+	size_t i = HashPtr(e.P) & (cap - 1);
+	while (entries[i].P != NULL) i = (i + 1) & (cap - 1);
+	entries[i] = e;
+}
+static void EntriesGrow(void)
+{
+	const size_t cap = sEntriesCap == 0 ? 4096 : sEntriesCap * 2;
+	MemTrackEntry *entries = calloc(cap, sizeof *entries);
+	if (entries == NULL) abort();
+	for (size_t i = 0; i < sEntriesCap; i++)
+	{
+		if (sEntries[i].P != NULL) EntryInsert(entries, cap, sEntries[i]);
+	}
+	free(sEntries);
+	sEntries = entries;
+	sEntriesCap = cap;
+}
+static MemTrackEntry *EntryFind(const void *p)
+{
+	if (sEntriesCap == 0) return NULL;
+	size_t i = HashPtr(p) & (sEntriesCap - 1);
+	for (; sEntries[i].P != NULL; i = (i + 1) & (sEntriesCap - 1))
+	{
+		if (sEntries[i].P == p) return &sEntries[i];
+	}
+	return NULL;
+}
+static void EntryRemove(MemTrackEntry *e)
+{
+	// Backward-shift deletion, so no tombstones are needed
+	size_t i = (size_t)(e - sEntries);
+	size_t j = i;
+	for (;;)
+	{
+		j = (j + 1) & (sEntriesCap - 1);
+		if (sEntries[j].P == NULL) break;
+		const size_t home = HashPtr(sEntries[j].P) & (sEntriesCap - 1);
+		// Move j into the hole at i if its home is not in (i, j]
+		const bool inRange =
+			i <= j ? (i < home && home <= j) : (i < home || home <= j);
+		if (!inRange)
+		{
+			sEntries[i] = sEntries[j];
+			i = j;
+		}
+	}
+	sEntries[i].P = NULL;
+	sNumEntries--;
+}
+
+static void Untrack(MemTrackEntry *e)
+{
+	MemTrackSite *s = &sSites[e->Site];
+	s->Live -= e->Size;
+	sSubsystems[s->Subsystem].Live -= e->Size;
+	sLive -= e->Size;
+	EntryRemove(e);
+}
+
+static void TrackAlloc(
+	const void *p, const size_t size, const char *file, const int line)
+{
+	// Pointers released with plain free() leave stale entries behind;
+	// drop them if the allocator hands the address out again
+	MemTrackEntry *old = EntryFind(p);
+	if (old != NULL) Untrack(old);
+
+	if ((sNumEntries + 1) * 2 > sEntriesCap) EntriesGrow();
+	const int site = FindOrAddSite(file, line);
+	MemTrackEntry e;
+	e.P = p;
+	e.Size = size;
+	e.Site = site;
+	EntryInsert(sEntries, sEntriesCap, e);
+	sNumEntries++;
+
+	MemTrackSite *s = &sSites[site];
+	MemTrackSubsystem *ss = &sSubsystems[s->Subsystem];
+	s->Live += size;
+	s->Peak = s->Live > s->Peak ? s->Live : s->Peak;
+	s->Count++;
+	ss->Live += size;
+	ss->Peak = ss->Live > ss->Peak ? ss->Live : ss->Peak;
+	ss->Count++;
+	sLive += size;
+	sPeak = sLive > sPeak ? sLive : sPeak;
+	sAllocs++;
+
+	if (sLoopDepth > 0)
+	{
+		s->LoopCount++;
+		sLoopAllocs++;
+		sLoopBytes += size;
+		if (!s->Flagged)
+		{
+			s->Flagged = true;
+			LOG(LM_MEM, LL_DEBUG, "per-frame allocation at %s:%d (%d bytes)",
+				file, line, (int)size);
+		}
+	}
+}
+static void TrackFree(const void *p)
+{
+	MemTrackEntry *e = EntryFind(p);
+	// Untracked pointers (e.g. from a library) are ignored
+	if (e == NULL) return;
+	Untrack(e);
+}
+void MemTrackAlloc(
+	const void *p, const size_t size, const char *file, const int line)
+{
+	if (p == NULL) return;
+	SDL_AtomicLock(&sLock);
+	TrackAlloc(p, size, file, line);
+	SDL_AtomicUnlock(&sLock);
+}
+void MemTrackRealloc(
+	const void *old, const void *p, const size_t size,
+	const char *file, const int line)
+{
+	SDL_AtomicLock(&sLock);
+	if (old != NULL)
+	{
+		TrackFree(old);
+	}
+	if (p != NULL)
+	{
+		TrackAlloc(p, size, file, line);
+	}
+	SDL_AtomicUnlock(&sLock);
+}
+void MemTrackFree(const void *p)
+{
+	if (p == NULL) return;
+	SDL_AtomicLock(&sLock);
+	TrackFree(p);
+	SDL_AtomicUnlock(&sLock);
+}
+
+void MemTrackLoopStart(void)
+{
+	SDL_AtomicLock(&sLock);
+	sLoopDepth++;
+	SDL_AtomicUnlock(&sLock);
+}
+void MemTrackFrame(void)
+{
+	SDL_AtomicLock(&sLock);
+	if (sLoopDepth > 0) sLoopFrames++;
+	SDL_AtomicUnlock(&sLock);
+}
+void MemTrackLoopEnd(void)
+{
+	SDL_AtomicLock(&sLock);
+	const int depth = sLoopDepth;
+	if (depth > 0) sLoopDepth--;
+	SDL_AtomicUnlock(&sLock);
+	CASSERT(depth > 0, "unbalanced MemTrackLoopEnd");
+}
+
+static int CompareSiteLive(const void *v1, const void *v2)
+{
+	const MemTrackSite *s1 = *(const MemTrackSite * const *)v1;
+	const MemTrackSite *s2 = *(const MemTrackSite * const *)v2;
+	if (s1->Live != s2->Live) return s1->Live < s2->Live ? 1 : -1;
+	return s2->Count - s1->Count;
+}
+static int CompareSubsystemLive(const void *v1, const void *v2)
+{
+	const MemTrackSubsystem *s1 = v1;
+	const MemTrackSubsystem *s2 = v2;
+	if (s1->Live != s2->Live) return s1->Live < s2->Live ? 1 : -1;
+	return s1->Peak < s2->Peak ? 1 : (s1->Peak > s2->Peak ? -1 : 0);
+}
+#define DUMP_MAX_SITES 20
+static void Dump(const char *label);
+void MemTrackDump(const char *label)
+{
+	SDL_AtomicLock(&sLock);
+	Dump(label);
+	SDL_AtomicUnlock(&sLock);
+}
+static void Dump(const char *label)
+{
+	if (sAllocs == 0)
+	{
+		// Not built with MEM_TRACK
+		return;
+	}
+	LOG(LM_MEM, LL_INFO,
+		"%s: live %d bytes in %d blocks, peak %d bytes, %d allocations",
+		label, (int)sLive, (int)sNumEntries, (int)sPeak, sAllocs);
+	if (sLoopFrames > 0)
+	{
+		LOG(LM_MEM, LL_INFO,
+			"%s: %d allocations (%d bytes) over %d frames, %.2f per frame",
+			label, sLoopAllocs, (int)sLoopBytes, sLoopFrames,
+			(double)sLoopAllocs / sLoopFrames);
+	}
+
+	// Per subsystem; sort a copy so indices held by sites stay valid
+	MemTrackSubsystem *subsystems =
+		malloc((sNumSubsystems + 1) * sizeof *subsystems);
+	if (subsystems == NULL) abort();
+	memcpy(subsystems, sSubsystems, sNumSubsystems * sizeof *subsystems);
+	qsort(subsystems, sNumSubsystems, sizeof *subsystems, CompareSubsystemLive);
+	for (int i = 0; i < sNumSubsystems; i++)
+	{
+		const MemTrackSubsystem *ss = &subsystems[i];
+		LOG(LM_MEM, LL_INFO, "  %-20s live %10d peak %10d allocs %8d",
+			ss->Name, (int)ss->Live, (int)ss->Peak, ss->Count);
+	}
+	free(subsystems);
+
+	// Top call sites by live bytes, plus any that allocate per frame
+	const MemTrackSite **sites = malloc((sNumSites + 1) * sizeof *sites);
+	if (sites == NULL) abort();
+	for (int i = 0; i < sNumSites; i++) sites[i] = &sSites[i];
+	qsort(sites, sNumSites, sizeof *sites, CompareSiteLive);
+	for (int i = 0; i < sNumSites; i++)
+	{
+		const MemTrackSite *s = sites[i];
+		if (i >= DUMP_MAX_SITES && s->LoopCount == 0) continue;
+		LOG(LM_MEM, LL_INFO,
+			"  %s:%d live %d peak %d allocs %d per-frame %d",
+			s->File, s->Line, (int)s->Live, (int)s->Peak, s->Count,
+			s->LoopCount);
+	}
+	free(sites);
+
+	// Reset the per-frame counters so each dump covers one mission
+	for (int i = 0; i < sNumSites; i++)
+	{
+		sSites[i].LoopCount = 0;
+		sSites[i].Flagged = false;
+	}
+	sLoopFrames = 0;
+	sLoopAllocs = 0;
+	sLoopBytes = 0;
+}
+
+void MemTrackTerminate(void)
+{
+	SDL_AtomicLock(&sLock);
+	free(sSubsystems);
+	sSubsystems = NULL;
+	sNumSubsystems = 0;
+	free(sSites);
+	sSites = NULL;
+	sNumSites = sSitesCap = 0;
+	free(sSiteIndex);
+	sSiteIndex = NULL;
+	sSiteIndexCap = 0;
+	free(sEntries);
+	sEntries = NULL;
+	sEntriesCap = sNumEntries = 0;
+	sLive = sPeak = 0;
+	sAllocs = 0;
+	SDL_AtomicUnlock(&sLock);
+}
+
@@ -0,0 +1,58 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Optional allocation tracker, fed by the CMALLOC/CCALLOC/CREALLOC/CFREE
+// macros when built with MEM_TRACK defined (cmake -DMEM_TRACK=ON).
+// Allocations are keyed by call site (file:line); the subsystem tag of a
+// call site is its source file name without extension, e.g. "map_build".
+// Without MEM_TRACK nothing is recorded and the loop/dump hooks are no-ops.
+// All functions are safe to call from any thread.
+void MemTrackAlloc(
+	const void *p, const size_t size, const char *file, const int line);
+void MemTrackRealloc(
+	const void *old, const void *p, const size_t size,
+	const char *file, const int line);
+void MemTrackFree(const void *p);
+
+// Call once per game loop frame; allocations made while a game loop is
+// running count towards the per-frame allocation rate.
+// Each call site that allocates inside the loop is flagged (logged once) so
+// the steady-state allocation count can be driven to zero.
+void MemTrackLoopStart(void);
+void MemTrackFrame(void);
+void MemTrackLoopEnd(void);
+
+// Log live/peak bytes per call site and per subsystem, and the
+// per-frame allocation rate since the last dump
+void MemTrackDump(const char *label);
+void MemTrackTerminate(void);
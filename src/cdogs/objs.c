@@ -79,6 +79,8 @@ CArray gObjs;
 CArray gMobObjs;
 static unsigned int sObjUIDs = 0;
 static unsigned int sMobObjUIDs = 0;
+// Update order of mobile objects, reused each frame
+static CArray sMobObjOrder;	// of int (index into gMobObjs)
 
 
 // Draw functions
@@ -90,7 +92,6 @@ static CPicDrawContext GetMapObjectDrawContext(const int id)
 	CPicDrawContext c;
 	c.Dir = DIRECTION_UP;
 	c.Offset = obj->Class->Offset;
-	CPicCopyPic(&obj->tileItem.CPic, &obj->Class->Pic);
 	return c;
 }
 
@@ -391,9 +392,38 @@ static void DoDamageCharacter(
 }
 
 
+static int CompareMobObjOrder(const void *v1, const void *v2)
+{
+	const TMobileObject *o1 = CArrayGet(&gMobObjs, *(const int *)v1);
+	const TMobileObject *o2 = CArrayGet(&gMobObjs, *(const int *)v2);
+	// Order classes by name rather than address, so that the update order
+	// is the same on every machine
+	if (o1->bulletClass != o2->bulletClass)
+	{
+		const int c = strcmp(o1->bulletClass->Name, o2->bulletClass->Name);
+		if (c != 0)
+		{
+			return c;
+		}
+	}
+	return o1->UID - o2->UID;
+}
 void UpdateMobileObjects(int ticks)
 {
-	CA_FOREACH(TMobileObject, obj, gMobObjs)
+	// Update in batches of the same bullet class, in UID order within each,
+	// so class data stays hot and hits are reported in a stable order
+	CArrayClear(&sMobObjOrder);
+	CA_FOREACH(const TMobileObject, obj, gMobObjs)
+		if (obj->isInUse)
+		{
+			CArrayPushBack(&sMobObjOrder, &_ca_index);
+		}
+	CA_FOREACH_END()
+	qsort(
+		sMobObjOrder.data, sMobObjOrder.size, sMobObjOrder.elemSize,
+		CompareMobObjOrder);
+	CA_FOREACH(const int, idx, sMobObjOrder)
+		TMobileObject *obj = CArrayGet(&gMobObjs, *idx);
 		if (!obj->isInUse)
 		{
 			continue;
@@ -553,6 +583,8 @@ void MobObjsInit(void)
 {
 	CArrayInit(&gMobObjs, sizeof(TMobileObject));
 	CArrayReserve(&gMobObjs, 1024);
+	CArrayInit(&sMobObjOrder, sizeof(int));
+	CArrayReserve(&sMobObjOrder, 1024);
 	sMobObjUIDs = 0;
 }
 void MobObjsTerminate(void)
@@ -564,6 +596,7 @@ void MobObjsTerminate(void)
 		}
 	CA_FOREACH_END()
 	CArrayTerminate(&gMobObjs);
+	CArrayTerminate(&sMobObjOrder);
 }
 int MobObjsObjsGetNextUID(void)
 {
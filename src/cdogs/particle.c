@@ -281,7 +281,8 @@ static bool ParticleUpdate(Particle *p, const int ticks)
 	return p->Count <= p->Range;
 }
 
-static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data);
+static void DrawParticle(
+	GraphicsDevice *g, const Vec2i pos, const TileItemDrawFuncData *data);
 int ParticleAdd(CArray *particles, const AddParticle add)
 {
 	// Find an empty slot in list
@@ -331,7 +332,8 @@ void ParticleDestroy(CArray *particles, const int id)
 	p->isInUse = false;
 }
 
-static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data)
+static void DrawParticle(
+	GraphicsDevice *g, const Vec2i pos, const TileItemDrawFuncData *data)
 {
 	const Particle *p = CArrayGet(&gParticles, data->MobObjId);
 	CASSERT(p->isInUse, "Cannot draw non-existent particle");
@@ -354,5 +356,5 @@ static void DrawParticle(const Vec2i pos, const TileItemDrawFuncData *data)
 	CASSERT(pic != NULL, "particle picture not found");
 	Vec2i picPos = Vec2iMinus(pos, Vec2iScaleDiv(pic->size, 2));
 	picPos.y -= p->Z / Z_FACTOR;
-	BlitMasked(&gGraphicsDevice, pic, picPos, p->Class->Mask, true);
+	BlitMasked(g, pic, picPos, p->Class->Mask, true);
 }
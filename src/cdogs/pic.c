@@ -32,7 +32,7 @@
 #include "grafx.h"
 #include "utils.h"
 
-Pic picNone = { { 0, 0 }, { 0, 0 }, NULL };
+Pic picNone = { { 0, 0 }, { 0, 0 }, NULL, NULL, NULL };
 
 
 color_t PixelToColor(
@@ -58,6 +58,8 @@ void PicLoad(
 {
 	p->size = size;
 	p->offset = Vec2iZero();
+	p->SpanRows = NULL;
+	p->Spans = NULL;
 	CMALLOC(p->Data, size.x * size.y * sizeof *((Pic *)0)->Data);
 	// Manually copy the pixels and replace the alpha component,
 	// since our gfx device format has no alpha
@@ -82,6 +84,7 @@ void PicLoad(
 			srcI += image->w - size.x;
 		}
 	}
+	PicUpdateSpans(p);
 }
 
 Pic PicCopy(const Pic *src)
@@ -90,12 +93,42 @@ Pic PicCopy(const Pic *src)
 	const size_t size = p.size.x * p.size.y * sizeof *p.Data;
 	CMALLOC(p.Data, size);
 	memcpy(p.Data, src->Data, size);
+	if (src->Spans != NULL)
+	{
+		const size_t rowsSize = (p.size.y + 1) * sizeof *p.SpanRows;
+		CMALLOC(p.SpanRows, rowsSize);
+		memcpy(p.SpanRows, src->SpanRows, rowsSize);
+		const size_t spansSize =
+			MAX(src->SpanRows[p.size.y], 1) * sizeof *p.Spans;
+		CMALLOC(p.Spans, spansSize);
+		memcpy(p.Spans, src->Spans, spansSize);
+	}
 	return p;
 }
 
+static const Uint8 *sSharedStart = NULL;
+static size_t sSharedSize = 0;
+void PicSetSharedMemory(const void *start, const size_t size)
+{
+	sSharedStart = start;
+	sSharedSize = size;
+}
+// Free pic memory unless it is in the shared memory
+static void PicMemFree(void *p)
+{
+	const Uint8 *b = p;
+	if (b >= sSharedStart && b < sSharedStart + sSharedSize)
+	{
+		return;
+	}
+	CFREE(p);
+}
+
 void PicFree(Pic *pic)
 {
-	CFREE(pic->Data);
+	PicMemFree(pic->Data);
+	PicMemFree(pic->SpanRows);
+	PicMemFree(pic->Spans);
 }
 
 bool PicIsNone(const Pic *pic)
@@ -103,6 +136,55 @@ bool PicIsNone(const Pic *pic)
 	return pic->size.x == 0 || pic->size.y == 0 || pic->Data == NULL;
 }
 
+void PicUpdateSpans(Pic *pic)
+{
+	PicMemFree(pic->SpanRows);
+	PicMemFree(pic->Spans);
+	pic->SpanRows = NULL;
+	pic->Spans = NULL;
+	if (PicIsNone(pic) || pic->size.x > 0xFFFF)
+	{
+		return;
+	}
+	// Count the runs first so they can be allocated in one go
+	int count = 0;
+	const Uint32 *px = pic->Data;
+	for (int y = 0; y < pic->size.y; y++)
+	{
+		for (int x = 0; x < pic->size.x; x++, px++)
+		{
+			if (*px != 0 && (x == 0 || *(px - 1) == 0))
+			{
+				count++;
+			}
+		}
+	}
+	CMALLOC(pic->SpanRows, (pic->size.y + 1) * sizeof *pic->SpanRows);
+	CMALLOC(pic->Spans, MAX(count, 1) * sizeof *pic->Spans);
+	PicSpan *span = pic->Spans;
+	px = pic->Data;
+	for (int y = 0; y < pic->size.y; y++)
+	{
+		pic->SpanRows[y] = (int)(span - pic->Spans);
+		for (int x = 0; x < pic->size.x; x++)
+		{
+			if (px[x] == 0)
+			{
+				continue;
+			}
+			span->Start = (Uint16)x;
+			while (x < pic->size.x && px[x] != 0)
+			{
+				x++;
+			}
+			span->Len = (Uint16)(x - span->Start);
+			span++;
+		}
+		px += pic->size.x;
+	}
+	pic->SpanRows[pic->size.y] = count;
+}
+
 void PicTrim(Pic *pic, const bool xTrim, const bool yTrim)
 {
 	// Scan all pixels looking for the min/max of x and y
@@ -152,10 +234,11 @@ void PicTrim(Pic *pic, const bool xTrim, const bool yTrim)
 		}
 	}
 	// Replace the old data
-	CFREE(pic->Data);
+	PicMemFree(pic->Data);
 	pic->Data = newData;
 	pic->size = newSize;
 	pic->offset = Vec2iZero();
+	PicUpdateSpans(pic);
 }
 
 bool PicPxIsEdge(const Pic *pic, const Vec2i pos, const bool isPixel)
@@ -29,11 +29,23 @@
 
 #include "vector.h"
 
+// Run of non-empty pixels in a pic row
+typedef struct
+{
+	Uint16 Start;
+	Uint16 Len;
+} PicSpan;
+
 typedef struct
 {
 	Vec2i size;
 	Vec2i offset;
 	Uint32 *Data;
+	// Runs of non-empty pixels so blitters can skip the empty ones;
+	// row y's runs are Spans[SpanRows[y]] to Spans[SpanRows[y + 1] - 1].
+	// NULL if not built, in which case whole rows are drawn
+	int *SpanRows;
+	PicSpan *Spans;
 } Pic;
 
 extern Pic picNone;
@@ -51,8 +63,14 @@ void PicLoad(
 	Pic *p, const Vec2i size, const Vec2i offset, const SDL_Surface *image);
 Pic PicCopy(const Pic *src);
 void PicFree(Pic *pic);
+// Pics may point into this memory without owning it, such as baked pics
+// mapped from a file; it is left alone when they are freed
+void PicSetSharedMemory(const void *start, const size_t size);
 bool PicIsNone(const Pic *pic);
 
+// Rebuild the runs of non-empty pixels; call after changing the pixels
+void PicUpdateSpans(Pic *pic);
+
 // Detect unused edges and update size and offset to fit
 void PicTrim(Pic *pic, const bool xTrim, const bool yTrim);
 
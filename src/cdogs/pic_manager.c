@@ -31,6 +31,7 @@
 
 #include <tinydir/tinydir.h>
 
+#include "draw/render_jobs.h"
 #include "files.h"
 #include "log.h"
 
@@ -54,8 +55,9 @@ void PicManagerInit(PicManager *pm)
 static NamedPic *AddNamedPic(map_t pics, const char *name, const Pic *p);
 static NamedSprites *AddNamedSprites(map_t sprites, const char *name);
 static void AfterAdd(PicManager *pm);
+static void AddStyleNames(PicManager *pm, const NamedPic *p);
 static void PicManagerAdd(
-	map_t pics, map_t sprites, const char *name, SDL_Surface *imageIn)
+	map_t pics, map_t sprites, const char *name, SDL_Surface *image)
 {
 	char buf[CDOGS_FILENAME_MAX];
 	const char *dot = strrchr(name, '.');
@@ -73,7 +75,7 @@ static void PicManagerAdd(
 	// Special case: if the file name is in the form foobar_WxH.ext,
 	// this is a spritesheet where each sprite is W wide by H high
 	// Load multiple images from this single sheet
-	Vec2i size = Vec2iNew(imageIn->w, imageIn->h);
+	Vec2i size = Vec2iNew(image->w, image->h);
 	bool isSpritesheet = false;
 	char *underscore = strrchr(buf, '_');
 	const char *x = strrchr(buf, 'x');
@@ -82,7 +84,7 @@ static void PicManagerAdd(
 	{
 		if (sscanf(underscore, "_%dx%d", &size.x, &size.y) != 2)
 		{
-			size = Vec2iNew(imageIn->w, imageIn->h);
+			size = Vec2iNew(image->w, image->h);
 		}
 		else
 		{
@@ -100,10 +102,6 @@ static void PicManagerAdd(
 	{
 		np = AddNamedPic(pics, buf, NULL);
 	}
-	// Use 32-bit image
-	SDL_Surface *image = SDL_ConvertSurfaceFormat(
-		imageIn, SDL_PIXELFORMAT_RGBA8888, 0);
-	SDL_FreeSurface(imageIn);
 	SDL_LockSurface(image);
 	Vec2i offset;
 	for (offset.y = 0; offset.y < image->h; offset.y += size.y)
@@ -122,71 +120,101 @@ static void PicManagerAdd(
 				pic = &np->pic;
 			}
 			PicLoad(pic, size, offset, image);
-
-			if (strncmp("chars/", buf, strlen("chars/")) == 0)
-			{
-				// Convert char pics to multichannel version
-				for (int i = 0; i < pic->size.x * pic->size.y; i++)
-				{
-					color_t c = PIXEL2COLOR(pic->Data[i]);
-					// Don't bother if the alpha has already been modified; it
-					// means we have already processed this pixel
-					if (c.a != 255)
-					{
-						continue;
-					}
-					const uint8_t value = MAX(MAX(c.r, c.g), c.b);
-					if (abs((int)c.r - c.g) < 5 && abs((int)c.g - c.b) < 5)
-					{
-						// don't convert greyscale colours
-					}
-					else if ((c.g < 5 && c.b < 5) ||
-						(abs((int)c.g - c.b) < 5 && c.r > 250))
-					{
-						// Skin
-						c.r = c.g = c.b = value;
-						c.a = 254;
-					}
-					else if ((c.r < 5 && c.b < 5) ||
-						(abs((int)c.r - c.b) < 5 && c.g > 250))
-					{
-						// Hair
-						c.r = c.g = c.b = value;
-						c.a = 250;
-					}
-					else if ((c.r < 5 && c.g < 5) ||
-						(abs((int)c.r - c.g) < 5 && c.b > 250))
-					{
-						// Arms
-						c.r = c.g = c.b = value;
-						c.a = 253;
-					}
-					else if (c.b < 5 || (c.r > 250 && c.g > 250))
-					{
-						// Body
-						c.r = c.g = c.b = value;
-						c.a = 252;
-					}
-					else if (c.r < 5 || (c.g > 250 && c.b > 250))
-					{
-						// Legs
-						c.r = c.g = c.b = value;
-						c.a = 251;
-					}
-					pic->Data[i] = COLOR2PIXEL(c);
-				}
-			}
 		}
 	}
 	SDL_UnlockSurface(image);
 	SDL_FreeSurface(image);
-
-	AfterAdd(&gPicManager);
 }
 
+// Images are decoded and converted in parallel on the render job threads,
+// a batch at a time, then added to the pic maps in directory order.
+// The jobs only use SDL, since the C* allocators are not thread-safe.
+#define LOAD_BATCH 64
+typedef struct
+{
+	char *Path;
+	char *Name;
+	const void *Data;	// if loading from a pack
+	size_t Size;
+	SDL_Surface *Image;
+	char Error[256];
+} PicLoadJob;
+static void CollectFiles(CArray *jobs, const char *path, const char *prefix);
+static void LoadImages(CArray *jobs, map_t pics, map_t sprites);
+static void JobsTerminate(CArray *jobs);
 void PicManagerLoadDir(
 	PicManager *pm, const char *path, const char *prefix,
 	map_t pics, map_t sprites)
+{
+	CArray jobs;
+	CArrayInit(&jobs, sizeof(PicLoadJob));
+	CollectFiles(&jobs, path, prefix);
+	LoadImages(&jobs, pics, sprites);
+	JobsTerminate(&jobs);
+	// Index the styles once all the pics are loaded
+	AfterAdd(pm);
+}
+void PicManagerLoadPack(
+	PicManager *pm, MapPack *pack, const char *dir, map_t pics, map_t sprites)
+{
+	CArray jobs;
+	CArrayInit(&jobs, sizeof(PicLoadJob));
+	const size_t dirLen = strlen(dir);
+	CA_FOREACH(const MapPackMember, m, pack->Members)
+		// Name pics by their path under the directory, like PicManagerLoadDir
+		if (strncmp(m->Name, dir, dirLen) != 0 || m->Name[dirLen] != '/')
+		{
+			continue;
+		}
+		PicLoadJob job;
+		memset(&job, 0, sizeof job);
+		// Get the data here, as the jobs can't log checksum errors
+		job.Data = MapPackGet(pack, m->Name, &job.Size);
+		if (job.Data == NULL)
+		{
+			continue;
+		}
+		char buf[CDOGS_PATH_MAX];
+		PathGetWithoutExtension(buf, m->Name + dirLen + 1);
+		CSTRDUP(job.Path, m->Name);
+		CSTRDUP(job.Name, buf);
+		CArrayPushBack(&jobs, &job);
+	CA_FOREACH_END()
+	LoadImages(&jobs, pics, sprites);
+	JobsTerminate(&jobs);
+	AfterAdd(pm);
+}
+static void LoadImageJob(void *data, const int index);
+static void LoadImages(CArray *jobs, map_t pics, map_t sprites)
+{
+	for (int i = 0; i < (int)jobs->size; i += LOAD_BATCH)
+	{
+		const int n = MIN(LOAD_BATCH, (int)jobs->size - i);
+		RenderJobsRun(LoadImageJob, CArrayGet(jobs, i), n);
+		for (int j = i; j < i + n; j++)
+		{
+			PicLoadJob *job = CArrayGet(jobs, j);
+			if (job->Image != NULL)
+			{
+				PicManagerAdd(pics, sprites, job->Name, job->Image);
+			}
+			else if (job->Error[0] != '\0')
+			{
+				LOG(LM_MAIN, LL_ERROR, "Cannot load image IMG_Load: %s",
+					job->Error);
+			}
+		}
+	}
+}
+static void JobsTerminate(CArray *jobs)
+{
+	CA_FOREACH(PicLoadJob, job, *jobs)
+		CFREE(job->Path);
+		CFREE(job->Name);
+	CA_FOREACH_END()
+	CArrayTerminate(jobs);
+}
+static void CollectFiles(CArray *jobs, const char *path, const char *prefix)
 {
 	tinydir_dir dir;
 	if (tinydir_open(&dir, path) == -1)
@@ -207,33 +235,22 @@ void PicManagerLoadDir(
 		}
 		if (file.is_reg)
 		{
-			SDL_RWops *rwops = SDL_RWFromFile(file.path, "rb");
-			const bool isPng = IMG_isPNG(rwops);
-			if (isPng)
+			char buf[CDOGS_PATH_MAX];
+			if (prefix)
+			{
+				char buf1[CDOGS_PATH_MAX];
+				sprintf(buf1, "%s/%s", prefix, file.name);
+				PathGetWithoutExtension(buf, buf1);
+			}
+			else
 			{
-				SDL_Surface *data = IMG_Load_RW(rwops, 0);
-				if (!data)
-				{
-					LOG(LM_MAIN, LL_ERROR, "Cannot load image IMG_Load: %s",
-						IMG_GetError());
-				}
-				else
-				{
-					char buf[CDOGS_PATH_MAX];
-					if (prefix)
-					{
-						char buf1[CDOGS_PATH_MAX];
-						sprintf(buf1, "%s/%s", prefix, file.name);
-						PathGetWithoutExtension(buf, buf1);
-					}
-					else
-					{
-						PathGetBasenameWithoutExtension(buf, file.name);
-					}
-					PicManagerAdd(pics, sprites, buf, data);
-				}
+				PathGetBasenameWithoutExtension(buf, file.name);
 			}
-			rwops->close(rwops);
+			PicLoadJob job;
+			memset(&job, 0, sizeof job);
+			CSTRDUP(job.Path, file.path);
+			CSTRDUP(job.Name, buf);
+			CArrayPushBack(jobs, &job);
 		}
 		else if (file.is_dir && file.name[0] != '.')
 		{
@@ -241,12 +258,11 @@ void PicManagerLoadDir(
 			{
 				char buf[CDOGS_PATH_MAX];
 				sprintf(buf, "%s/%s", prefix, file.name);
-				PicManagerLoadDir(pm, file.path, buf, pics, sprites);
+				CollectFiles(jobs, file.path, buf);
 			}
 			else
 			{
-				PicManagerLoadDir(
-					pm, file.path, file.name, pics, sprites);
+				CollectFiles(jobs, file.path, file.name);
 			}
 		}
 	}
@@ -254,6 +270,103 @@ void PicManagerLoadDir(
 bail:
 	tinydir_close(&dir);
 }
+static void ConvertCharColors(SDL_Surface *image);
+// Decode a PNG into a 32-bit surface; other files are skipped
+static void LoadImageJob(void *data, const int index)
+{
+	PicLoadJob *job = (PicLoadJob *)data + index;
+	SDL_RWops *rwops = job->Data != NULL ?
+		SDL_RWFromConstMem(job->Data, (int)job->Size) :
+		SDL_RWFromFile(job->Path, "rb");
+	if (rwops == NULL)
+	{
+		return;
+	}
+	if (IMG_isPNG(rwops))
+	{
+		SDL_Surface *imageIn = IMG_Load_RW(rwops, 0);
+		if (imageIn == NULL)
+		{
+			strncpy(job->Error, IMG_GetError(), sizeof job->Error - 1);
+		}
+		else
+		{
+			// Use 32-bit image
+			job->Image = SDL_ConvertSurfaceFormat(
+				imageIn, SDL_PIXELFORMAT_RGBA8888, 0);
+			SDL_FreeSurface(imageIn);
+			if (job->Image == NULL)
+			{
+				strncpy(job->Error, SDL_GetError(), sizeof job->Error - 1);
+			}
+			else if (strncmp("chars/", job->Name, strlen("chars/")) == 0)
+			{
+				ConvertCharColors(job->Image);
+			}
+		}
+	}
+	rwops->close(rwops);
+}
+// Convert char pics to multichannel version
+static void ConvertCharColors(SDL_Surface *image)
+{
+	SDL_LockSurface(image);
+	for (int y = 0; y < image->h; y++)
+	{
+		Uint32 *row = (Uint32 *)((Uint8 *)image->pixels + y * image->pitch);
+		for (int x = 0; x < image->w; x++)
+		{
+			color_t c;
+			SDL_GetRGBA(row[x], image->format, &c.r, &c.g, &c.b, &c.a);
+			// Don't bother if the alpha has already been modified; it
+			// means we have already processed this pixel
+			if (c.a != 255)
+			{
+				continue;
+			}
+			const uint8_t value = MAX(MAX(c.r, c.g), c.b);
+			if (abs((int)c.r - c.g) < 5 && abs((int)c.g - c.b) < 5)
+			{
+				// don't convert greyscale colours
+			}
+			else if ((c.g < 5 && c.b < 5) ||
+				(abs((int)c.g - c.b) < 5 && c.r > 250))
+			{
+				// Skin
+				c.r = c.g = c.b = value;
+				c.a = 254;
+			}
+			else if ((c.r < 5 && c.b < 5) ||
+				(abs((int)c.r - c.b) < 5 && c.g > 250))
+			{
+				// Hair
+				c.r = c.g = c.b = value;
+				c.a = 250;
+			}
+			else if ((c.r < 5 && c.g < 5) ||
+				(abs((int)c.r - c.g) < 5 && c.b > 250))
+			{
+				// Arms
+				c.r = c.g = c.b = value;
+				c.a = 253;
+			}
+			else if (c.b < 5 || (c.r > 250 && c.g > 250))
+			{
+				// Body
+				c.r = c.g = c.b = value;
+				c.a = 252;
+			}
+			else if (c.r < 5 || (c.g > 250 && c.b > 250))
+			{
+				// Legs
+				c.r = c.g = c.b = value;
+				c.a = 251;
+			}
+			row[x] = SDL_MapRGBA(image->format, c.r, c.g, c.b, c.a);
+		}
+	}
+	SDL_UnlockSurface(image);
+}
 void PicManagerLoad(PicManager *pm, const char *path)
 {
 	if (!IMG_Init(IMG_INIT_PNG))
@@ -263,126 +376,128 @@ void PicManagerLoad(PicManager *pm, const char *path)
 	}
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
-	PicManagerLoadDir(pm, buf, NULL, pm->pics, pm->sprites);
+	CArray jobs;
+	CArrayInit(&jobs, sizeof(PicLoadJob));
+	CollectFiles(&jobs, buf, NULL);
+	CArray sources;
+	CArrayInit(&sources, sizeof(char *));
+	CA_FOREACH(PicLoadJob, job, jobs)
+		CArrayPushBack(&sources, &job->Path);
+	CA_FOREACH_END()
+	// Use the baked pics if the images haven't changed since they were
+	// baked; otherwise decode the images and bake them for next time
+	char bakedPath[CDOGS_PATH_MAX];
+	strcpy(bakedPath, GetConfigFilePath(BAKED_PICS_FILE));
+	if (!BakedPicsLoad(
+		&pm->baked, bakedPath, &sources, pm->pics, pm->sprites))
+	{
+		LoadImages(&jobs, pm->pics, pm->sprites);
+		BakedPicsSave(bakedPath, &sources, pm->pics, pm->sprites);
+	}
+	CArrayTerminate(&sources);
+	JobsTerminate(&jobs);
+	AfterAdd(pm);
 }
 
 
-static void FindStylePics(
-	PicManager *pm, CArray *styleNames, PFany hashmapFunc);
-static int MaybeAddWallPicName(any_t data, any_t item);
-static int MaybeAddTilePicName(any_t data, any_t item);
-static int MaybeAddExitPicName(any_t data, any_t item);
-static int MaybeAddKeyPicName(any_t data, any_t item);
-static int MaybeAddDoorPicName(any_t data, any_t item);
+// Style pics are named like prefix/style/suffix, such as:
+// - exits/style/shadow, where shadow is normal/shadow
+// - door/style/type
+// - keys/style/colour, where colour is yellow/green/blue/red
+// - wall/style/type
+// - tile/style/type, where type is normal/shadow/alt1/alt2
+// The style names are kept sorted, so that the lists don't reorder
+// unpredictably when the editor is used and masked pics get added
+static CArray *GetStyleNames(PicManager *pm, const char *name, size_t *len);
+static void AddStyleName(CArray *styleNames, const char *style);
+static int AddStyleNamesFromHashmap(any_t data, any_t item);
+static void StylesClear(CArray *styles);
 static void AfterAdd(PicManager *pm)
 {
-	FindStylePics(pm, &pm->wallStyleNames, MaybeAddWallPicName);
-	FindStylePics(pm, &pm->tileStyleNames, MaybeAddTilePicName);
-	FindStylePics(pm, &pm->exitStyleNames, MaybeAddExitPicName);
-	FindStylePics(pm, &pm->doorStyleNames, MaybeAddDoorPicName);
-	FindStylePics(pm, &pm->keyStyleNames, MaybeAddKeyPicName);
+	StylesClear(&pm->wallStyleNames);
+	StylesClear(&pm->tileStyleNames);
+	StylesClear(&pm->exitStyleNames);
+	StylesClear(&pm->doorStyleNames);
+	StylesClear(&pm->keyStyleNames);
+	hashmap_iterate(pm->customPics, AddStyleNamesFromHashmap, pm);
+	hashmap_iterate(pm->pics, AddStyleNamesFromHashmap, pm);
 }
-static int CompareStyleNames(const void *v1, const void *v2);
-static void FindStylePics(
-	PicManager *pm, CArray *styleNames, PFany hashmapFunc)
+static int AddStyleNamesFromHashmap(any_t data, any_t item)
 {
-	// Scan all pics for style pics
-	CA_FOREACH(char *, styleName, *styleNames)
-		CFREE(*styleName);
-	CA_FOREACH_END()
-	CArrayClear(styleNames);
-	hashmap_iterate(pm->customPics, hashmapFunc, pm);
-	hashmap_iterate(pm->pics, hashmapFunc, pm);
-	// Sort the style names alphabetically
-	// This prevents the list from reordering unpredictably, when the editor
-	// is used and masked pics get added
-	qsort(
-		styleNames->data, styleNames->size, styleNames->elemSize,
-		CompareStyleNames);
-}
-static int CompareStyleNames(const void *v1, const void *v2)
-{
-	const char * const *s1 = v1;
-	const char * const *s2 = v2;
-	return strcmp(*s1, *s2);
-}
-static void MaybeAddStyleName(
-	const NamedPic *p, const char *prefix, CArray *styleNames)
-{
-	// Look for style names within a full name of the form:
-	// prefix/style/suffix
-	// NOTE: prefix should include slash
-	const char *picName = p->name;
-	if (strncmp(picName, prefix, strlen(prefix)) != 0)
+	AddStyleNames(data, item);
+	return MAP_OK;
+}
+static void AddStyleNames(PicManager *pm, const NamedPic *p)
+{
+	size_t prefixLen;
+	CArray *styleNames = GetStyleNames(pm, p->name, &prefixLen);
+	if (styleNames == NULL)
+	{
+		return;
+	}
+	const char *style = p->name + prefixLen;
+	const char *nextSlash = strchr(style, '/');
+	if (nextSlash == NULL)
 	{
 		return;
 	}
-	const char *nextSlash = strchr(picName + strlen(prefix), '/');
 	char buf[CDOGS_PATH_MAX];
-	const size_t len = nextSlash - picName - strlen(prefix);
-	strncpy(buf, picName + strlen(prefix), len);
+	const size_t len = nextSlash - style;
+	strncpy(buf, style, len);
 	buf[len] = '\0';
-	// Check if we already have the style name
-	// This can happen if a custom pic uses the same name as a built in one
-	CA_FOREACH(char *, styleName, *styleNames)
-		if (strcmp(*styleName, buf) == 0)
-		{
-			return;
-		}
-	CA_FOREACH_END()
-
-	char *s;
-	CSTRDUP(s, buf);
-	CArrayPushBack(styleNames, &s);
-}
-static int MaybeAddExitPicName(any_t data, any_t item)
-{
-	// Exit pics should be like:
-	// exits/style/shadow
-	// where style is the style name to be stored, and
-	// shadow is normal/shadow
-	PicManager *pm = data;
-	MaybeAddStyleName(item, "exits/", &pm->exitStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddDoorPicName(any_t data, any_t item)
-{
-	// Door pics should be like:
-	// door/style/type
-	// where style is the style name to be stored
-	PicManager *pm = data;
-	MaybeAddStyleName(item, "door/", &pm->doorStyleNames);
-	return MAP_OK;
+	AddStyleName(styleNames, buf);
 }
-static int MaybeAddKeyPicName(any_t data, any_t item)
+static CArray *GetStyleNames(PicManager *pm, const char *name, size_t *len)
 {
-	// Key pics should be like:
-	// keys/style/colour
-	// where style is the style name to be stored, and
-	// colour is yellow/green/blue/red
-	// TODO: more colours
-	PicManager *pm = data;
-	MaybeAddStyleName(item, "keys/", &pm->keyStyleNames);
-	return MAP_OK;
-}
-static int MaybeAddWallPicName(any_t data, any_t item)
-{
-	// Wall pics should be like:
-	// wall/style/type
-	// where style is the style name to be stored
-	PicManager *pm = data;
-	MaybeAddStyleName(item, "wall/", &pm->wallStyleNames);
-	return MAP_OK;
+	const struct
+	{
+		const char *Prefix;
+		CArray *StyleNames;
+	} styles[] =
+	{
+		{ "wall/", &pm->wallStyleNames },
+		{ "tile/", &pm->tileStyleNames },
+		{ "exits/", &pm->exitStyleNames },
+		{ "door/", &pm->doorStyleNames },
+		{ "keys/", &pm->keyStyleNames }
+	};
+	for (int i = 0; i < (int)(sizeof styles / sizeof styles[0]); i++)
+	{
+		*len = strlen(styles[i].Prefix);
+		if (strncmp(name, styles[i].Prefix, *len) == 0)
+		{
+			return styles[i].StyleNames;
+		}
+	}
+	return NULL;
 }
-static int MaybeAddTilePicName(any_t data, any_t item)
+static void AddStyleName(CArray *styleNames, const char *style)
 {
-	// Tile pics should be like:
-	// tile/style/type
-	// where style is the style name to be stored, and
-	// type is normal/shadow/alt1/alt2
-	PicManager *pm = data;
-	MaybeAddStyleName(item, "tile/", &pm->tileStyleNames);
-	return MAP_OK;
+	// Binary search for the sorted position; the name may already be there
+	// if a custom pic uses the same name as a built in one
+	int lo = 0;
+	int hi = (int)styleNames->size;
+	while (lo < hi)
+	{
+		const int mid = (lo + hi) / 2;
+		const int cmp =
+			strcmp(*(char **)CArrayGet(styleNames, mid), style);
+		if (cmp == 0)
+		{
+			return;
+		}
+		if (cmp < 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	char *s;
+	CSTRDUP(s, style);
+	CArrayInsert(styleNames, lo, &s);
 }
 
 // Need to free the pics and the memory since hashmap stores on heap
@@ -408,14 +523,21 @@ void PicManagerTerminate(PicManager *pm)
 	StylesTerminate(&pm->exitStyleNames);
 	StylesTerminate(&pm->doorStyleNames);
 	StylesTerminate(&pm->keyStyleNames);
+	// The pics have been freed, so it is safe to unmap them now
+	BakedPicsTerminate(&pm->baked);
 	IMG_Quit();
 }
 static void StylesTerminate(CArray *styles)
+{
+	StylesClear(styles);
+	CArrayTerminate(styles);
+}
+static void StylesClear(CArray *styles)
 {
 	CA_FOREACH(char *, styleName, *styles)
 		CFREE(*styleName);
 	CA_FOREACH_END()
-	CArrayTerminate(styles);
+	CArrayClear(styles);
 }
 static void NamedPicDestroy(any_t data)
 {
@@ -433,12 +555,14 @@ static void NamedSpritesDestroy(any_t data)
 NamedPic *PicManagerGetNamedPic(const PicManager *pm, const char *name)
 {
 	NamedPic *n;
-	int error = hashmap_get(pm->customPics, name, (any_t *)&n);
+	// Custom pics override the builtin ones; hash the name once for both
+	const unsigned int hash = hashmap_hash_key(name);
+	int error = hashmap_get_hashed(pm->customPics, name, hash, (any_t *)&n);
 	if (error == MAP_OK)
 	{
 		return n;
 	}
-	error = hashmap_get(pm->pics, name, (any_t *)&n);
+	error = hashmap_get_hashed(pm->pics, name, hash, (any_t *)&n);
 	if (error == MAP_OK)
 	{
 		return n;
@@ -455,12 +579,14 @@ const NamedSprites *PicManagerGetSprites(
 	const PicManager *pm, const char *name)
 {
 	NamedSprites *n;
-	int error = hashmap_get(pm->customSprites, name, (any_t *)&n);
+	const unsigned int hash = hashmap_hash_key(name);
+	int error =
+		hashmap_get_hashed(pm->customSprites, name, hash, (any_t *)&n);
 	if (error == MAP_OK)
 	{
 		return n;
 	}
-	error = hashmap_get(pm->sprites, name, (any_t *)&n);
+	error = hashmap_get_hashed(pm->sprites, name, hash, (any_t *)&n);
 	if (error == MAP_OK)
 	{
 		return n;
@@ -528,9 +654,12 @@ void PicManagerGenerateMaskedPic(
 		p.Data[i] = COLOR2PIXEL(c);
 		// TODO: more channels
 	}
-	AddNamedPic(pm->customPics, maskedName, &p);
-
-	AfterAdd(pm);
+	PicUpdateSpans(&p);
+	const NamedPic *np = AddNamedPic(pm->customPics, maskedName, &p);
+	if (np != NULL)
+	{
+		AddStyleNames(pm, np);
+	}
 }
 void PicManagerGenerateMaskedStylePic(
 	PicManager *pm, const char *name, const char *style, const char *type,
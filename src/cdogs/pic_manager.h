@@ -27,8 +27,10 @@
 */
 #pragma once
 
+#include "baked_pics.h"
 #include "c_hashmap/hashmap.h"
 #include "cpic.h"
+#include "map_pack.h"
 #include "pics.h"
 
 typedef struct
@@ -43,8 +45,13 @@ typedef struct
 	CArray exitStyleNames;	// of char *
 	CArray doorStyleNames;	// of char *
 	CArray keyStyleNames;	// of char *
+
+	// The builtin pics, if loaded from the baked file, point into this
+	BakedPics baked;
 } PicManager;
 
+#define BAKED_PICS_FILE "pics.baked"
+
 extern PicManager gPicManager;
 
 void PicManagerInit(PicManager *pm);
@@ -52,6 +59,9 @@ void PicManagerLoad(PicManager *pm, const char *path);
 void PicManagerLoadDir(
 	PicManager *pm, const char *path, const char *prefix,
 	map_t pics, map_t sprites);
+// Load the pics under a directory in a pack
+void PicManagerLoadPack(
+	PicManager *pm, MapPack *pack, const char *dir, map_t pics, map_t sprites);
 void PicManagerClearCustom(PicManager *pm);
 void PicManagerTerminate(PicManager *pm);
 
@@ -93,9 +93,10 @@ int OpenAudio(int frequency, Uint16 format, int channels, int chunkSize)
 	return 0;
 }
 
-static Mix_Chunk *LoadSound(const char *path);
+static void SoundFileInit(SoundFile *f, const char *path, MapPack *pack);
 static void AddSound(map_t sounds, const char *name, SoundData *sound);
-static void SoundLoad(map_t sounds, const char *name, const char *path)
+static void SoundLoad(
+	map_t sounds, const char *name, const char *path, MapPack *pack)
 {
 	// If the sound basename is a number, it is part of a group of random sounds
 	char basename[CDOGS_FILENAME_MAX];
@@ -123,7 +124,7 @@ static void SoundLoad(map_t sounds, const char *name, const char *path)
 		SoundData *sound;
 		CCALLOC(sound, sizeof *sound);
 		sound->Type = SOUND_RANDOM;
-		CArrayInit(&sound->u.random.sounds, sizeof(Mix_Chunk *));
+		CArrayInit(&sound->u.random.sounds, sizeof(SoundFile));
 		// Remove "0.<ext>" from path
 		const char *ext = StrGetFileExt(path);
 		const int len = ext - path - 2;
@@ -135,9 +136,19 @@ static void SoundLoad(map_t sounds, const char *name, const char *path)
 		{
 			char buf[CDOGS_PATH_MAX];
 			sprintf(buf, fmt, i);
-			Mix_Chunk *data = LoadSound(buf);
-			if (data == NULL) break;
-			CArrayPushBack(&sound->u.random.sounds, &data);
+			// Only check that the file is there; it is decoded when played
+			if (pack != NULL)
+			{
+				if (!MapPackHas(pack, buf)) break;
+			}
+			else
+			{
+				struct stat st;
+				if (stat(buf, &st) != 0) break;
+			}
+			SoundFile f;
+			SoundFileInit(&f, buf, pack);
+			CArrayPushBack(&sound->u.random.sounds, &f);
 		}
 		// Remove "/0" from name and add
 		*strrchr(nameNoExt, '/') = '\0';
@@ -145,20 +156,20 @@ static void SoundLoad(map_t sounds, const char *name, const char *path)
 	}
 	else
 	{
-		Mix_Chunk *data = LoadSound(path);
-		if (data != NULL)
-		{
-			SoundData *sound;
-			CMALLOC(sound, sizeof *sound);
-			sound->Type = SOUND_NORMAL;
-			sound->u.normal = data;
-			AddSound(sounds, nameNoExt, sound);
-		}
+		SoundData *sound;
+		CMALLOC(sound, sizeof *sound);
+		sound->Type = SOUND_NORMAL;
+		SoundFileInit(&sound->u.normal, path, pack);
+		AddSound(sounds, nameNoExt, sound);
 	}
 }
-static Mix_Chunk *LoadSound(const char *path)
+static void SoundFileInit(SoundFile *f, const char *path, MapPack *pack)
 {
-	return Mix_LoadWAV(path);
+	CSTRDUP(f->Path, path);
+	// Keep the pack open until the sound is freed, as it is decoded later
+	f->Pack = pack != NULL ? MapPackRef(pack) : NULL;
+	f->Chunk = NULL;
+	SDL_AtomicSet(&f->IsLoaded, 0);
 }
 static void SoundDataTerminate(any_t data);
 static void AddSound(map_t sounds, const char *name, SoundData *sound)
@@ -168,7 +179,6 @@ static void AddSound(map_t sounds, const char *name, SoundData *sound)
 	{
 		LOG(LM_MAIN, LL_ERROR, "failed to add sound %s: %d", name, error);
 		SoundDataTerminate((any_t)sound);
-		CFREE(sound);
 	}
 }
 
@@ -185,10 +195,14 @@ void SoundInitialize(SoundDevice *device, const char *path)
 
 	device->sounds = hashmap_new();
 	device->customSounds = hashmap_new();
+	device->loadLock = SDL_CreateMutex();
+	CArrayInit(&device->prefetchFiles, sizeof(SoundFile *));
 	char buf[CDOGS_PATH_MAX];
 	GetDataFilePath(buf, path);
 	SoundLoadDir(device->sounds, buf, NULL);
+	SoundPrefetch(device);
 }
+static bool IsSoundFile(const char *filename);
 void SoundLoadDir(map_t sounds, const char *path, const char *prefix)
 {
 	tinydir_dir dir;
@@ -218,9 +232,9 @@ void SoundLoadDir(map_t sounds, const char *path, const char *prefix)
 		{
 			strcpy(buf, file.name);
 		}
-		if (file.is_reg)
+		if (file.is_reg && IsSoundFile(file.name))
 		{
-			SoundLoad(sounds, buf, file.path);
+			SoundLoad(sounds, buf, file.path, NULL);
 		}
 		else if (file.is_dir)
 		{
@@ -231,6 +245,167 @@ void SoundLoadDir(map_t sounds, const char *path, const char *prefix)
 bail:
 	tinydir_close(&dir);
 }
+void SoundLoadPack(map_t sounds, MapPack *pack, const char *dir)
+{
+	const size_t dirLen = strlen(dir);
+	CA_FOREACH(const MapPackMember, m, pack->Members)
+		// Members are named like "sounds/path/to/sound.wav"
+		if (strncmp(m->Name, dir, dirLen) != 0 || m->Name[dirLen] != '/')
+		{
+			continue;
+		}
+		const char *name = m->Name + dirLen + 1;
+		const char *basename = strrchr(name, '/');
+		basename = basename != NULL ? basename + 1 : name;
+		if (basename[0] == '.' || !IsSoundFile(basename))
+		{
+			continue;
+		}
+		// Pack names are not limited like file names; skip ones too long
+		// for SoundLoad's buffers
+		if (strlen(m->Name) >= CDOGS_FILENAME_MAX)
+		{
+			LOG(LM_MAIN, LL_WARN, "Sound name too long: '%s'", m->Name);
+			continue;
+		}
+		SoundLoad(sounds, name, m->Name, pack);
+	CA_FOREACH_END()
+}
+// Sounds sit alongside other files such as licenses, which could have the
+// same names; only look at the formats that can be decoded
+static bool IsSoundFile(const char *filename)
+{
+	static const char *exts[] = { "wav", "ogg", "flac", "mp3", "voc", "aiff" };
+	const char *ext = StrGetFileExt(filename);
+	if (ext == NULL)
+	{
+		return false;
+	}
+	for (int i = 0; i < (int)(sizeof exts / sizeof exts[0]); i++)
+	{
+		const char *e = exts[i];
+		const char *c = ext;
+		while (*e != '\0' && tolower(*c) == *e)
+		{
+			c++;
+			e++;
+		}
+		if (*e == '\0' && *c == '\0')
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void PrefetchStop(SoundDevice *device);
+static int AddPrefetchFiles(any_t data, any_t item);
+static int PrefetchThread(void *data);
+void SoundPrefetch(SoundDevice *device)
+{
+	if (!device->isInitialised)
+	{
+		return;
+	}
+	PrefetchStop(device);
+	// Custom sounds first, as they are for the campaign about to be played
+	hashmap_iterate(device->customSounds, AddPrefetchFiles, device);
+	hashmap_iterate(device->sounds, AddPrefetchFiles, device);
+	if (device->prefetchFiles.size == 0)
+	{
+		return;
+	}
+	device->prefetchThread =
+		SDL_CreateThread(PrefetchThread, "sound prefetch", device);
+	if (device->prefetchThread == NULL)
+	{
+		// Not fatal; the sounds are decoded when they are first played
+		LOG(LM_SOUND, LL_ERROR, "cannot create sound prefetch thread: %s",
+			SDL_GetError());
+	}
+}
+static void PrefetchStop(SoundDevice *device)
+{
+	if (device->prefetchThread != NULL)
+	{
+		SDL_AtomicSet(&device->prefetchStop, 1);
+		SDL_WaitThread(device->prefetchThread, NULL);
+		device->prefetchThread = NULL;
+		SDL_AtomicSet(&device->prefetchStop, 0);
+	}
+	CArrayClear(&device->prefetchFiles);
+}
+static void AddPrefetchFile(SoundDevice *device, SoundFile *f);
+static int AddPrefetchFiles(any_t data, any_t item)
+{
+	SoundDevice *device = data;
+	SoundData *s = item;
+	switch (s->Type)
+	{
+		case SOUND_NORMAL:
+			AddPrefetchFile(device, &s->u.normal);
+			break;
+		case SOUND_RANDOM:
+			CA_FOREACH(SoundFile, f, s->u.random.sounds)
+				AddPrefetchFile(device, f);
+			CA_FOREACH_END()
+			break;
+		default:
+			CASSERT(false, "Unknown sound data type");
+			break;
+	}
+	return MAP_OK;
+}
+static void AddPrefetchFile(SoundDevice *device, SoundFile *f)
+{
+	if (!SDL_AtomicGet(&f->IsLoaded))
+	{
+		CArrayPushBack(&device->prefetchFiles, &f);
+	}
+}
+static Mix_Chunk *SoundFileGet(SoundDevice *device, SoundFile *f);
+static int PrefetchThread(void *data)
+{
+	SoundDevice *device = data;
+	CA_FOREACH(SoundFile *, f, device->prefetchFiles)
+		if (SDL_AtomicGet(&device->prefetchStop))
+		{
+			break;
+		}
+		SoundFileGet(device, *f);
+	CA_FOREACH_END()
+	return 0;
+}
+static Mix_Chunk *SoundFileGet(SoundDevice *device, SoundFile *f)
+{
+	if (!SDL_AtomicGet(&f->IsLoaded))
+	{
+		SDL_LockMutex(device->loadLock);
+		// Check again in case the other thread loaded it in the meantime
+		if (!SDL_AtomicGet(&f->IsLoaded))
+		{
+			if (f->Pack != NULL)
+			{
+				size_t size;
+				const void *data = MapPackGet(f->Pack, f->Path, &size);
+				f->Chunk = data == NULL ? NULL : Mix_LoadWAV_RW(
+					SDL_RWFromConstMem(data, (int)size), 1);
+			}
+			else
+			{
+				f->Chunk = Mix_LoadWAV(f->Path);
+			}
+			if (f->Chunk == NULL)
+			{
+				LOG(LM_SOUND, LL_ERROR, "cannot load sound %s: %s",
+					f->Path, Mix_GetError());
+			}
+			SDL_AtomicSet(&f->IsLoaded, 1);
+		}
+		SDL_UnlockMutex(device->loadLock);
+	}
+	return f->Chunk;
+}
 
 void SoundReconfigure(SoundDevice *s)
 {
@@ -258,7 +433,11 @@ void SoundReconfigure(SoundDevice *s)
 
 void SoundClear(map_t sounds)
 {
+	// The prefetch thread may be decoding these sounds; stop it first and
+	// restart it for those that are left
+	PrefetchStop(&gSoundDevice);
 	hashmap_clear(sounds, SoundDataTerminate);
+	SoundPrefetch(&gSoundDevice);
 }
 void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete)
 {
@@ -268,6 +447,7 @@ void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete)
 	}
 
 	debug(D_NORMAL, "shutting down sound\n");
+	PrefetchStop(device);
 	if (waitForSoundsComplete)
 	{
 		Uint32 waitStart = SDL_GetTicks();
@@ -283,18 +463,21 @@ void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete)
 
 	hashmap_destroy(device->sounds, SoundDataTerminate);
 	hashmap_destroy(device->customSounds, SoundDataTerminate);
+	CArrayTerminate(&device->prefetchFiles);
+	SDL_DestroyMutex(device->loadLock);
 }
+static void SoundFileTerminate(SoundFile *f);
 static void SoundDataTerminate(any_t data)
 {
 	SoundData *s = data;
 	switch (s->Type)
 	{
 		case SOUND_NORMAL:
-			Mix_FreeChunk(s->u.normal);
+			SoundFileTerminate(&s->u.normal);
 			break;
 		case SOUND_RANDOM:
-			CA_FOREACH(Mix_Chunk *, chunk, s->u.random.sounds)
-				Mix_FreeChunk(*chunk);
+			CA_FOREACH(SoundFile, f, s->u.random.sounds)
+				SoundFileTerminate(f);
 			CA_FOREACH_END()
 			CArrayTerminate(&s->u.random.sounds);
 			break;
@@ -304,6 +487,15 @@ static void SoundDataTerminate(any_t data)
 	}
 	CFREE(s);
 }
+static void SoundFileTerminate(SoundFile *f)
+{
+	CFREE(f->Path);
+	MapPackUnref(f->Pack);
+	if (f->Chunk != NULL)
+	{
+		Mix_FreeChunk(f->Chunk);
+	}
+}
 
 #define OUT_OF_SIGHT_DISTANCE_PLUS 200
 static void MuffleEffect(int chan, void *stream, int len, void *udata)
@@ -433,8 +625,9 @@ void SoundPlayAt(SoundDevice *device, Mix_Chunk *data, const Vec2i pos)
 
 static bool IsPosNoSee(void *data, Vec2i pos)
 {
-	const Tile *t = MapGetTile(data, Vec2iToTile(pos));
-	return t != NULL && (t->flags & MAPTILE_NO_SEE);
+	const Vec2i tile = Vec2iToTile(pos);
+	return
+		MapIsTileIn(data, tile) && MapPlaneGet(data, MAP_PLANE_NO_SEE, tile);
 }
 void SoundPlayAtPlusDistance(
 	SoundDevice *device, Mix_Chunk *data,
@@ -483,7 +676,7 @@ void SoundPlayAtPlusDistance(
 		&gSoundDevice, data, distance + plusDistance, bearing, isMuffled);
 }
 
-static Mix_Chunk *SoundDataGet(SoundData *s);
+static Mix_Chunk *SoundDataGet(SoundDevice *device, SoundData *s);
 Mix_Chunk *StrSound(const char *s)
 {
 	if (s == NULL || strlen(s) == 0)
@@ -491,24 +684,26 @@ Mix_Chunk *StrSound(const char *s)
 		return NULL;
 	}
 	SoundData *sound;
-	int error = hashmap_get(gSoundDevice.customSounds, s, (any_t *)&sound);
+	const unsigned int hash = hashmap_hash_key(s);
+	int error = hashmap_get_hashed(
+		gSoundDevice.customSounds, s, hash, (any_t *)&sound);
 	if (error == MAP_OK)
 	{
-		return SoundDataGet(sound);
+		return SoundDataGet(&gSoundDevice, sound);
 	}
-	error = hashmap_get(gSoundDevice.sounds, s, (any_t *)&sound);
+	error = hashmap_get_hashed(gSoundDevice.sounds, s, hash, (any_t *)&sound);
 	if (error == MAP_OK)
 	{
-		return SoundDataGet(sound);
+		return SoundDataGet(&gSoundDevice, sound);
 	}
 	return NULL;
 }
-static Mix_Chunk *SoundDataGet(SoundData *s)
+static Mix_Chunk *SoundDataGet(SoundDevice *device, SoundData *s)
 {
 	switch (s->Type)
 	{
 		case SOUND_NORMAL:
-			return s->u.normal;
+			return SoundFileGet(device, &s->u.normal);
 		case SOUND_RANDOM:
 			{
 				// Don't get the last sound used
@@ -518,9 +713,9 @@ static Mix_Chunk *SoundDataGet(SoundData *s)
 				{
 					idx = rand() % s->u.random.sounds.size;
 				}
-				Mix_Chunk **sound = CArrayGet(&s->u.random.sounds, idx);
+				SoundFile *f = CArrayGet(&s->u.random.sounds, idx);
 				s->u.random.lastPlayed = idx;
-				return *sound;
+				return SoundFileGet(device, f);
 			}
 		default:
 			CASSERT(false, "Unknown sound data type");
@@ -50,11 +50,15 @@
 
 #include <stdbool.h>
 
+#include <SDL_atomic.h>
 #include <SDL_mixer.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
 
 #include "c_array.h"
 #include "c_hashmap/hashmap.h"
 #include "defs.h"
+#include "map_pack.h"
 #include "sys_config.h"
 #include "utils.h"
 #include "vector.h"
@@ -65,15 +69,24 @@ typedef enum
 	SOUND_RANDOM
 } SoundType;
 
+// A sound file, decoded on first use or by the prefetch thread
+typedef struct
+{
+	char *Path;	// member name if in a pack
+	MapPack *Pack;
+	Mix_Chunk *Chunk;
+	SDL_atomic_t IsLoaded;
+} SoundFile;
+
 typedef struct
 {
 	SoundType Type;
 	union
 	{
-		Mix_Chunk *normal;
+		SoundFile normal;
 		struct
 		{
-			CArray sounds;	// of Mix_Chunk *
+			CArray sounds;	// of SoundFile
 			int lastPlayed;
 		} random;
 	} u;
@@ -103,6 +116,12 @@ typedef struct
 
 	map_t sounds;		// of SoundData
 	map_t customSounds;	// of SoundData
+
+	// Sounds are decoded one at a time, by whichever thread needs them first
+	SDL_mutex *loadLock;
+	SDL_Thread *prefetchThread;
+	SDL_atomic_t prefetchStop;
+	CArray prefetchFiles;	// of SoundFile *
 } SoundDevice;
 
 extern SoundDevice gSoundDevice;
@@ -126,7 +145,13 @@ typedef struct
 } HitSounds;
 
 void SoundInitialize(SoundDevice *device, const char *path);
+// Sounds are only found here; they are decoded when they are first played
 void SoundLoadDir(map_t sounds, const char *path, const char *prefix);
+// Like SoundLoadDir, for the sounds in a pack's directory
+void SoundLoadPack(map_t sounds, MapPack *pack, const char *dir);
+// Decode the sounds that haven't been played yet on a background thread,
+// so that they are ready before they are needed
+void SoundPrefetch(SoundDevice *device);
 void SoundReconfigure(SoundDevice *s);
 void SoundClear(map_t sounds);
 void SoundTerminate(SoundDevice *device, const bool waitForSoundsComplete);
@@ -0,0 +1,135 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "startup.h"
+
+#include <stdio.h>
+
+#include <SDL_timer.h>
+
+#include "log.h"
+#include "utils.h"
+
+Startup gStartup;
+
+
+void StartupInit(Startup *s)
+{
+	memset(s, 0, sizeof *s);
+	s->Start = SDL_GetPerformanceCounter();
+	s->MainThread = SDL_ThreadID();
+	s->lock = SDL_CreateMutex();
+	CArrayInit(&s->Phases, sizeof(StartupPhase));
+}
+void StartupTerminate(Startup *s)
+{
+	CArrayTerminate(&s->Phases);
+	SDL_DestroyMutex(s->lock);
+	s->lock = NULL;
+}
+
+int StartupPhaseBegin(Startup *s, const char *name)
+{
+	StartupPhase p;
+	p.Name = name;
+	p.Start = SDL_GetPerformanceCounter();
+	p.End = 0;
+	p.IsMainThread = SDL_ThreadID() == s->MainThread;
+	SDL_LockMutex(s->lock);
+	const int phase = (int)s->Phases.size;
+	CArrayPushBack(&s->Phases, &p);
+	SDL_UnlockMutex(s->lock);
+	return phase;
+}
+void StartupPhaseEnd(Startup *s, const int phase)
+{
+	const Uint64 end = SDL_GetPerformanceCounter();
+	// Lock as the array may be moved by another thread's phase
+	SDL_LockMutex(s->lock);
+	StartupPhase *p = CArrayGet(&s->Phases, phase);
+	p->End = end;
+	SDL_UnlockMutex(s->lock);
+}
+
+static int RunTask(void *data);
+void StartupTaskStart(
+	Startup *s, StartupTask *t, const char *name,
+	StartupFunc run, void *data)
+{
+	t->Name = name;
+	t->Run = run;
+	t->Data = data;
+	t->thread = NULL;
+	if (s->Fast)
+	{
+		t->thread = SDL_CreateThread(RunTask, name, t);
+		if (t->thread != NULL)
+		{
+			return;
+		}
+		LOG(LM_MAIN, LL_ERROR, "cannot create startup thread %s: %s",
+			name, SDL_GetError());
+	}
+	run(data);
+}
+static int RunTask(void *data)
+{
+	StartupTask *t = data;
+	t->Run(t->Data);
+	return 0;
+}
+void StartupTaskWait(StartupTask *t)
+{
+	if (t->thread != NULL)
+	{
+		SDL_WaitThread(t->thread, NULL);
+		t->thread = NULL;
+	}
+}
+
+static double ToMs(const Uint64 ticks)
+{
+	return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+void StartupReport(const Startup *s)
+{
+	if (!s->Profile)
+	{
+		return;
+	}
+	const Uint64 now = SDL_GetPerformanceCounter();
+	printf("Startup profile (fast start %s):\n", s->Fast ? "on" : "off");
+	printf("    %-24s %-7s %10s %10s\n", "phase", "thread", "start ms", "ms");
+	CA_FOREACH(const StartupPhase, p, s->Phases)
+		printf("    %-24s %-7s %10.1f %10.1f\n",
+			p->Name, p->IsMainThread ? "main" : "worker",
+			ToMs(p->Start - s->Start),
+			p->End != 0 ? ToMs(p->End - p->Start) : -1.0);
+	CA_FOREACH_END()
+	printf("    time to menu: %.1f ms\n", ToMs(now - s->Start));
+}
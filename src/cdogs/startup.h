@@ -0,0 +1,86 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#include "c_array.h"
+
+// Startup is split into phases, which are timed for --startup-profile.
+// With --fast-start, phases that don't depend on each other are run as
+// tasks on worker threads; the main thread waits for a task before
+// starting the phases that need its results.
+typedef struct
+{
+	const char *Name;
+	Uint64 Start;
+	Uint64 End;
+	bool IsMainThread;
+} StartupPhase;
+
+typedef struct
+{
+	bool Profile;
+	bool Fast;
+	Uint64 Start;
+	SDL_threadID MainThread;
+	SDL_mutex *lock;
+	CArray Phases;	// of StartupPhase
+} Startup;
+extern Startup gStartup;
+
+typedef void (*StartupFunc)(void *data);
+typedef struct
+{
+	const char *Name;
+	StartupFunc Run;
+	void *Data;
+	SDL_Thread *thread;
+} StartupTask;
+
+void StartupInit(Startup *s);
+void StartupTerminate(Startup *s);
+
+// Time a phase; phases can be nested and run on any thread
+int StartupPhaseBegin(Startup *s, const char *name);
+void StartupPhaseEnd(Startup *s, const int phase);
+
+// Run a task, which times its own phases, on a worker thread in fast start
+// mode, otherwise right away
+void StartupTaskStart(
+	Startup *s, StartupTask *t, const char *name,
+	StartupFunc run, void *data);
+// Wait for a task to finish; call before anything that depends on it
+void StartupTaskWait(StartupTask *t);
+
+// Print the phases and the time so far, if profiling
+void StartupReport(const Startup *s);
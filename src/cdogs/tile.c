@@ -57,23 +57,18 @@
 Tile TileNone(void)
 {
 	Tile t;
-	TileInit(&t);
+	TileInit(&t, NULL);
 	t.flags = MAPTILE_NO_WALK | MAPTILE_IS_NOTHING;
 	return t;
 }
-void TileInit(Tile *t)
+void TileInit(Tile *t, struct Arena *arena)
 {
 	memset(t, 0, sizeof *t);
-	CArrayInit(&t->triggers, sizeof(Trigger *));
-	CArrayInit(&t->things, sizeof(ThingId));
+	CArrayInitArena(&t->triggers, sizeof(Trigger *), arena);
+	CArrayInitArena(&t->things, sizeof(ThingId), arena);
 	t->pic = NULL;
 	t->picAlt = NULL;
 }
-void TileDestroy(Tile *t)
-{
-	CArrayTerminate(&t->triggers);
-	CArrayTerminate(&t->things);
-}
 
 bool IsTileItemInsideTile(TTileItem *i, Vec2i tilePos)
 {
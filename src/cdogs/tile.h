@@ -112,7 +112,8 @@ typedef struct
 		} MuzzleFlash;
 	} u;
 } TileItemDrawFuncData;
-typedef void (*TileItemDrawFunc)(const Vec2i, const TileItemDrawFuncData *);
+typedef void (*TileItemDrawFunc)(
+	GraphicsDevice *, const Vec2i, const TileItemDrawFuncData *);
 typedef struct TileItem
 {
 	int x, y;
@@ -149,8 +150,8 @@ typedef struct
 
 
 Tile TileNone(void);
-void TileInit(Tile *t);
-void TileDestroy(Tile *t);
+// Side arrays are allocated from the arena if set
+void TileInit(Tile *t, struct Arena *arena);
 bool IsTileItemInsideTile(TTileItem *i, Vec2i tilePos);
 bool TileCanSee(Tile *t);
 bool TileCanWalk(const Tile *t);
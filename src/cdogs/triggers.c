@@ -50,6 +50,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "triggers.h"
+#include "arena.h"
 #include "map.h"
 #include "objs.h"
 #include "sounds.h"
@@ -59,19 +60,13 @@ CArray gWatches;	// of TWatch
 static int watchIndex = 1;
 
 
-Trigger *TriggerNew(void)
+Trigger *TriggerNew(Arena *arena)
 {
-	Trigger *t;
-	CCALLOC(t, sizeof *t);
+	Trigger *t = ArenaAlloc(arena, sizeof *t);
 	t->isActive = 1;
-	CArrayInit(&t->actions, sizeof(Action));
+	CArrayInitArena(&t->actions, sizeof(Action), arena);
 	return t;
 }
-void TriggerTerminate(Trigger *t)
-{
-	CArrayTerminate(&t->actions);
-	CFREE(t);
-}
 Action *TriggerAddAction(Trigger *t)
 {
 	Action a;
@@ -80,13 +75,13 @@ Action *TriggerAddAction(Trigger *t)
 	return CArrayGet(&t->actions, t->actions.size - 1);
 }
 
-TWatch *WatchNew(void)
+TWatch *WatchNew(Arena *arena)
 {
 	TWatch t;
 	memset(&t, 0, sizeof(TWatch));
 	t.index = watchIndex++;
-	CArrayInit(&t.actions, sizeof(Action));
-	CArrayInit(&t.conditions, sizeof(Condition));
+	CArrayInitArena(&t.actions, sizeof(Action), arena);
+	CArrayInitArena(&t.conditions, sizeof(Condition), arena);
 	t.active = false;
 	CArrayPushBack(&gWatches, &t);
 	return CArrayGet(&gWatches, gWatches.size - 1);
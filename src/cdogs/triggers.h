@@ -120,14 +120,14 @@ typedef struct
 bool TriggerCanActivate(const Trigger *t, const int flags);
 void TriggerActivate(Trigger *t, CArray *mapTriggers);
 void UpdateWatches(CArray *mapTriggers, const int ticks);
-Trigger *TriggerNew(void);
-void TriggerTerminate(Trigger *t);
+// Triggers and watches are owned by the map's arena
+Trigger *TriggerNew(struct Arena *arena);
 Action *TriggerAddAction(Trigger *t);
 
 void WatchesInit(void);
 void WatchesTerminate(void);
 
-TWatch *WatchNew(void);
+TWatch *WatchNew(struct Arena *arena);
 Condition *WatchAddCondition(
 	TWatch *w, const ConditionType type, const int counterMax,
 	const Vec2i pos);
@@ -54,6 +54,11 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include <tinydir/tinydir.h>
 
@@ -480,3 +485,125 @@ bool StrEndsWith(const char *str, const char *suffix)
 	}
 	return strncmp(str + lenStr - lenSuffix, suffix, lenSuffix) == 0;
 }
+
+bool FileDataLoad(FileData *f, const char *filename, const bool writable)
+{
+	memset(f, 0, sizeof *f);
+#ifdef _WIN32
+	// No mapping; read the whole file in one go
+	UNUSED(writable);
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL)
+	{
+		return false;
+	}
+	bool ok = false;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		const long size = ftell(file);
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			f->Size = (size_t)size;
+			CMALLOC(f->Data, f->Size);
+			ok = fread(f->Data, f->Size, 1, file) == 1;
+			if (!ok)
+			{
+				CFREE(f->Data);
+				memset(f, 0, sizeof *f);
+			}
+		}
+	}
+	fclose(file);
+	return ok;
+#else
+	const int fd = open(filename, O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+	struct stat st;
+	void *data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+		data = mmap(NULL, (size_t)st.st_size, prot, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	f->Data = data;
+	f->Size = (size_t)st.st_size;
+	f->IsMapped = true;
+	return true;
+#endif
+}
+void FileDataWillNeed(const FileData *f)
+{
+#ifndef _WIN32
+	if (f->IsMapped)
+	{
+		madvise(f->Data, f->Size, MADV_WILLNEED);
+	}
+#else
+	UNUSED(f);
+#endif
+}
+void FileDataTerminate(FileData *f)
+{
+#ifndef _WIN32
+	if (f->IsMapped)
+	{
+		munmap(f->Data, f->Size);
+	}
+#endif
+	if (!f->IsMapped)
+	{
+		CFREE(f->Data);
+	}
+	memset(f, 0, sizeof *f);
+}
+
+bool DataReaderRead(DataReader *r, void *out, const size_t size)
+{
+	if (size > r->Size - r->Pos)
+	{
+		return false;
+	}
+	memcpy(out, r->Data + r->Pos, size);
+	r->Pos += size;
+	return true;
+}
+
+static bool GetReplaceTmpPath(char *buf, const char *filename)
+{
+	const int len = snprintf(buf, CDOGS_PATH_MAX, "%s.tmp", filename);
+	return len >= 0 && len < CDOGS_PATH_MAX;
+}
+FILE *FileReplaceOpen(const char *filename, const char *mode)
+{
+	char tmpPath[CDOGS_PATH_MAX];
+	if (!GetReplaceTmpPath(tmpPath, filename))
+	{
+		errno = ENAMETOOLONG;
+		return NULL;
+	}
+	return fopen(tmpPath, mode);
+}
+bool FileReplaceClose(FILE *f, const char *filename, const bool ok)
+{
+	char tmpPath[CDOGS_PATH_MAX];
+	GetReplaceTmpPath(tmpPath, filename);
+	bool written = fclose(f) == 0 && ok;
+	// Rename won't replace an existing file on some platforms
+	if (written && rename(tmpPath, filename) != 0)
+	{
+		written = remove(filename) == 0 && rename(tmpPath, filename) == 0;
+	}
+	if (!written)
+	{
+		remove(tmpPath);
+	}
+	return written;
+}
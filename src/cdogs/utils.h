@@ -50,6 +50,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h> /* for stderr */
 #include <stdlib.h>
 #include <string.h>
@@ -109,20 +110,39 @@ extern bool gFalse;
 		(int)_size, _var);\
 }
 
+#ifdef MEM_TRACK
+#include "mem_track.h"
+#define _CMEMTRACK_ALLOC(_var, _size)\
+	MemTrackAlloc(_var, _size, __FILE__, __LINE__);
+#define _CMEMTRACK_KEEP_OLD(_var) const void *_cmemtrackOld = _var;
+#define _CMEMTRACK_REALLOC(_old, _var, _size)\
+	MemTrackRealloc(_old, _var, _size, __FILE__, __LINE__);
+#define _CMEMTRACK_FREE(_var) MemTrackFree(_var);
+#else
+#define _CMEMTRACK_ALLOC(_var, _size)
+#define _CMEMTRACK_KEEP_OLD(_var)
+#define _CMEMTRACK_REALLOC(_old, _var, _size)
+#define _CMEMTRACK_FREE(_var)
+#endif
+
 #define CMALLOC(_var, _size)\
 {\
 	_var = malloc(_size);\
 	_CCHECKALLOC("CMALLOC", _var, (_size))\
+	_CMEMTRACK_ALLOC(_var, (_size))\
 }
 #define CCALLOC(_var, _size)\
 {\
 	_var = calloc(1, _size);\
 	_CCHECKALLOC("CCALLOC", _var, (_size))\
+	_CMEMTRACK_ALLOC(_var, (_size))\
 }
 #define CREALLOC(_var, _size)\
 {\
+	_CMEMTRACK_KEEP_OLD(_var)\
 	_var = realloc(_var, _size);\
 	_CCHECKALLOC("CREALLOC", _var, (_size))\
+	_CMEMTRACK_REALLOC(_cmemtrackOld, _var, (_size))\
 }
 #define CSTRDUP(_var, _str)\
 {\
@@ -135,6 +155,7 @@ extern bool gFalse;
 	debug(D_MAX,\
 		"CFREE(" #_var ") at 0x%p\n",\
 		_var);\
+	_CMEMTRACK_FREE(_var)\
 	free(_var);\
 }
 
@@ -198,6 +219,35 @@ char *Div8Str(int i);
 void CamelToTitle(char *buf, const char *src);
 bool StrEndsWith(const char *str, const char *suffix);
 
+// A whole file in memory; mapped where possible, otherwise read in.
+// Writable data is private, so changes are never written to the file.
+typedef struct
+{
+	uint8_t *Data;
+	size_t Size;
+	bool IsMapped;
+} FileData;
+bool FileDataLoad(FileData *f, const char *filename, const bool writable);
+// Read the whole file ahead, when it is about to be used rather than scanned
+void FileDataWillNeed(const FileData *f);
+void FileDataTerminate(FileData *f);
+
+// Bounds-checked reads from a block of memory, such as a FileData
+typedef struct
+{
+	uint8_t *Data;
+	size_t Size;
+	size_t Pos;
+} DataReader;
+bool DataReaderRead(DataReader *r, void *out, const size_t size);
+
+// Write a file by writing to the FILE from FileReplaceOpen, a temporary
+// file; FileReplaceClose then puts it in place of filename if ok and
+// everything was written, so that a partly written file is never read.
+// FileReplaceOpen returns NULL if the file can't be created.
+FILE *FileReplaceOpen(const char *filename, const char *mode);
+bool FileReplaceClose(FILE *f, const char *filename, const bool ok);
+
 // Helper macros for defining type/str conversion funcs
 #define T2S(_type, _str) case _type: return _str;
 #define S2T(_type, _str) if (strcmp(s, _str) == 0) { return _type; }
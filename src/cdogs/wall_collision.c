@@ -0,0 +1,296 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "wall_collision.h"
+
+#include <stdlib.h>
+
+#include "tile.h"
+#include "utils.h"
+
+// Diamond outlines are walked as a start offset plus unit steps, so the
+// tile coordinates can be tracked incrementally without a division per
+// pixel, and each tile is only tested when the outline enters it.
+// Outlines are cached per size; there are only a handful of actor sizes.
+#define DIAMOND_MAX_HALF_WIDTH 64
+#define DIAMOND_CACHE_SIZE 8
+typedef struct
+{
+	Vec2i Size;	// half size
+	Vec2i Start;
+	int NumSteps;
+	int8_t StepX[DIAMOND_MAX_HALF_WIDTH * 4];
+	int8_t StepY[DIAMOND_MAX_HALF_WIDTH * 4];
+} DiamondOutline;
+static DiamondOutline sDiamondCache[DIAMOND_CACHE_SIZE];
+static int sDiamondCacheCount = 0;
+static int sDiamondCacheNext = 0;
+
+static bool WallPlaneGet(const WallPlane *w, const Vec2i tile)
+{
+	return (w->Bits[tile.y * w->Stride + (tile.x >> 5)] >> (tile.x & 31)) & 1;
+}
+
+bool WallPlaneCollideBox(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize)
+{
+	const Vec2i size = Vec2iScaleDiv(fullSize, 2);
+	if (pos.x - size.x < 0 ||
+		pos.y - size.y < 0 ||
+		pos.x + size.x >= w->Size.x * TILE_WIDTH ||
+		pos.y + size.y >= w->Size.y * TILE_HEIGHT)
+	{
+		return true;
+	}
+	// Corners and edge midpoints fall on at most 3 rows and 3 columns of
+	// tiles; small boxes collapse these, so skip the repeats
+	const int x[3] =
+	{
+		(pos.x - size.x) / TILE_WIDTH,
+		pos.x / TILE_WIDTH,
+		(pos.x + size.x) / TILE_WIDTH
+	};
+	const int y[3] =
+	{
+		(pos.y - size.y) / TILE_HEIGHT,
+		pos.y / TILE_HEIGHT,
+		(pos.y + size.y) / TILE_HEIGHT
+	};
+	for (int j = 0; j < 3; j++)
+	{
+		// The middle row only has the left and right midpoints, and is
+		// covered entirely if it shares a tile row with the top or bottom
+		const bool isMiddle = j == 1;
+		if (isMiddle && (y[1] == y[0] || y[1] == y[2])) continue;
+		if (j == 2 && y[2] == y[0]) continue;
+		for (int i = 0; i < 3; i++)
+		{
+			if (isMiddle && i == 1) continue;
+			const int prev = isMiddle && i == 2 ? 0 : i - 1;
+			if (i > 0 && x[i] == x[prev]) continue;
+			if (WallPlaneGet(w, Vec2iNew(x[i], y[j])))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Build the outline with the same rounding as the original per-pixel walk,
+// so results are identical: top -> right -> bottom -> left
+static void DiamondOutlineInit(DiamondOutline *d, const Vec2i size)
+{
+	d->Size = size;
+	const double gradient = (double)size.y / size.x;
+	Vec2i prev = Vec2iZero();
+	int n = 0;
+	for (int edge = 0; edge < 4; edge++)
+	{
+		for (int i = 0; i < size.x; i++)
+		{
+			Vec2i p;
+			switch (edge)
+			{
+			case 0:
+				p = Vec2iNew(i, (int)Round((-size.x + i) * gradient));
+				break;
+			case 1:
+				p = Vec2iNew(size.x - i, (int)Round(i * gradient));
+				break;
+			case 2:
+				p = Vec2iNew(-i, (int)Round((size.x - i) * gradient));
+				break;
+			default:
+				p = Vec2iNew(-size.x + i, (int)Round(-i * gradient));
+				break;
+			}
+			if (n == 0)
+			{
+				d->Start = p;
+			}
+			else
+			{
+				// Gradient is at most 1 so the outline is 8-connected
+				d->StepX[n - 1] = (int8_t)(p.x - prev.x);
+				d->StepY[n - 1] = (int8_t)(p.y - prev.y);
+			}
+			prev = p;
+			n++;
+		}
+	}
+	d->NumSteps = n - 1;
+}
+static const DiamondOutline *DiamondOutlineGet(const Vec2i size)
+{
+	for (int i = 0; i < sDiamondCacheCount; i++)
+	{
+		if (Vec2iEqual(sDiamondCache[i].Size, size))
+		{
+			return &sDiamondCache[i];
+		}
+	}
+	DiamondOutline *d = &sDiamondCache[sDiamondCacheNext];
+	sDiamondCacheNext = (sDiamondCacheNext + 1) % DIAMOND_CACHE_SIZE;
+	sDiamondCacheCount = MIN(sDiamondCacheCount + 1, DIAMOND_CACHE_SIZE);
+	DiamondOutlineInit(d, size);
+	return d;
+}
+
+bool WallPlaneCollideDiamond(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize)
+{
+	const Vec2i size = Vec2iScaleDiv(fullSize, 2);
+	if (pos.x - size.x < 0 || pos.x + size.x >= w->Size.x * TILE_WIDTH ||
+		pos.y - size.y < 0 || pos.y + size.y >= w->Size.y * TILE_HEIGHT)
+	{
+		return true;
+	}
+
+	// Only support wider-than-taller collision diamonds for now
+	CASSERT(size.x >= size.y, "not implemented, taller than wider diamond");
+	CASSERT(size.x <= DIAMOND_MAX_HALF_WIDTH, "diamond too large");
+	if (size.x == 0)
+	{
+		return false;
+	}
+	const DiamondOutline *d = DiamondOutlineGet(size);
+
+	// Track tile and offset within tile as we step along the outline
+	const Vec2i start = Vec2iAdd(pos, d->Start);
+	Vec2i tile = Vec2iNew(start.x / TILE_WIDTH, start.y / TILE_HEIGHT);
+	Vec2i r = Vec2iNew(
+		start.x - tile.x * TILE_WIDTH, start.y - tile.y * TILE_HEIGHT);
+	if (WallPlaneGet(w, tile))
+	{
+		return true;
+	}
+	for (int i = 0; i < d->NumSteps; i++)
+	{
+		bool entered = false;
+		r.x += d->StepX[i];
+		if (r.x == TILE_WIDTH)
+		{
+			r.x = 0;
+			tile.x++;
+			entered = true;
+		}
+		else if (r.x < 0)
+		{
+			r.x = TILE_WIDTH - 1;
+			tile.x--;
+			entered = true;
+		}
+		r.y += d->StepY[i];
+		if (r.y == TILE_HEIGHT)
+		{
+			r.y = 0;
+			tile.y++;
+			entered = true;
+		}
+		else if (r.y < 0)
+		{
+			r.y = TILE_HEIGHT - 1;
+			tile.y--;
+			entered = true;
+		}
+		if (entered && WallPlaneGet(w, tile))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool WallPlaneRaycast(
+	const WallPlane *w, const Vec2i from, const Vec2i to, Vec2i *hit)
+{
+	// Amanatides-Woo grid traversal, treating pixels by their centres
+	Vec2i tile = Vec2iNew(from.x / TILE_WIDTH, from.y / TILE_HEIGHT);
+	if (from.x < 0 || from.y < 0 ||
+		tile.x >= w->Size.x || tile.y >= w->Size.y)
+	{
+		return false;
+	}
+	const Vec2i d = Vec2iMinus(to, from);
+	const Vec2i step = Vec2iNew(
+		d.x > 0 ? 1 : (d.x < 0 ? -1 : 0), d.y > 0 ? 1 : (d.y < 0 ? -1 : 0));
+	// Parametric distance along the segment to the next tile boundary, and
+	// between boundaries
+	double tMaxX = 2, tMaxY = 2;
+	double tDeltaX = 0, tDeltaY = 0;
+	if (step.x != 0)
+	{
+		const int boundary = (tile.x + (step.x > 0 ? 1 : 0)) * TILE_WIDTH;
+		tMaxX = (boundary - (from.x + 0.5)) / d.x;
+		tDeltaX = (double)TILE_WIDTH / abs(d.x);
+	}
+	if (step.y != 0)
+	{
+		const int boundary = (tile.y + (step.y > 0 ? 1 : 0)) * TILE_HEIGHT;
+		tMaxY = (boundary - (from.y + 0.5)) / d.y;
+		tDeltaY = (double)TILE_HEIGHT / abs(d.y);
+	}
+	for (;;)
+	{
+		// Step diagonally through exact corners; the segment only touches
+		// the tiles either side at a point
+		const double t = MIN(tMaxX, tMaxY);
+		const bool stepX = tMaxX - t < 1e-9;
+		const bool stepY = tMaxY - t < 1e-9;
+		if (stepX)
+		{
+			tMaxX += tDeltaX;
+			tile.x += step.x;
+		}
+		if (stepY)
+		{
+			tMaxY += tDeltaY;
+			tile.y += step.y;
+		}
+		if (t > 1)
+		{
+			return false;
+		}
+		if (tile.x < 0 || tile.x >= w->Size.x ||
+			tile.y < 0 || tile.y >= w->Size.y)
+		{
+			return false;
+		}
+		if (WallPlaneGet(w, tile))
+		{
+			// Entry point, clamped so that it lies within the tile
+			const int x = from.x + (int)Round(t * d.x);
+			const int y = from.y + (int)Round(t * d.y);
+			*hit = Vec2iNew(
+				CLAMP(x, tile.x * TILE_WIDTH, (tile.x + 1) * TILE_WIDTH - 1),
+				CLAMP(y, tile.y * TILE_HEIGHT, (tile.y + 1) * TILE_HEIGHT - 1));
+			return true;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "vector.h"
+
+// Read-only view of a one-bit-per-tile blocking plane, laid out as the
+// planes in Map (row-major, Stride 32-bit words per row)
+typedef struct
+{
+	const uint32_t *Bits;
+	int Stride;
+	Vec2i Size;	// in tiles
+} WallPlane;
+
+// Whether a box centred at pos (pixels) extends outside the plane, or has a
+// corner or edge midpoint on a blocking tile
+bool WallPlaneCollideBox(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize);
+// Whether the bounding diamond of fullSize centred at pos (pixels) extends
+// outside the plane or crosses a blocking tile; see IsCollisionDiamond
+bool WallPlaneCollideDiamond(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize);
+// Walk the tiles crossed by the segment from -> to (pixels), not counting
+// the starting tile, and stop at the first blocking tile or at the edge of
+// the plane. If a blocking tile was found, returns true and sets hit to the
+// point (pixels) where the segment enters it.
+bool WallPlaneRaycast(
+	const WallPlane *w, const Vec2i from, const Vec2i to, Vec2i *hit);
@@ -150,6 +150,7 @@ void WeaponLoadJSON(GunClasses *g, CArray *classes, json_t *root)
 		}
 	}
 }
+static void LoadSoundName(char **value, json_t *node, const char *name);
 static void LoadGunDescription(
 	GunDescription *g, json_t *node, const GunDescription *defaultGun)
 {
@@ -166,6 +167,18 @@ static void LoadGunDescription(
 		{
 			CSTRDUP(g->Description, defaultGun->Description);
 		}
+		if (defaultGun->Sound)
+		{
+			CSTRDUP(g->Sound, defaultGun->Sound);
+		}
+		if (defaultGun->ReloadSound)
+		{
+			CSTRDUP(g->ReloadSound, defaultGun->ReloadSound);
+		}
+		if (defaultGun->SwitchSound)
+		{
+			CSTRDUP(g->SwitchSound, defaultGun->SwitchSound);
+		}
 		g->MuzzleHeight /= Z_FACTOR;
 	}
 	char *tmp;
@@ -225,9 +238,9 @@ static void LoadGunDescription(
 
 	LoadInt(&g->ReloadLead, node, "ReloadLead");
 
-	LoadSoundFromNode(&g->Sound, node, "Sound");
-	LoadSoundFromNode(&g->ReloadSound, node, "ReloadSound");
-	LoadSoundFromNode(&g->SwitchSound, node, "SwitchSound");
+	LoadSoundName(&g->Sound, node, "Sound");
+	LoadSoundName(&g->ReloadSound, node, "ReloadSound");
+	LoadSoundName(&g->SwitchSound, node, "SwitchSound");
 
 	LoadInt(&g->SoundLockLength, node, "SoundLockLength");
 
@@ -292,6 +305,16 @@ static void LoadGunDescription(
 		"...canDrop(%s) shakeAmount(%d)",
 		g->CanDrop ? "true" : "false", g->ShakeAmount);
 }
+static void LoadSoundName(char **value, json_t *node, const char *name)
+{
+	char *tmp = NULL;
+	LoadStr(&tmp, node, name);
+	if (tmp != NULL)
+	{
+		CFREE(*value);
+		*value = tmp;
+	}
+}
 void WeaponTerminate(GunClasses *g)
 {
 	WeaponClassesClear(&g->Guns);
@@ -311,6 +334,9 @@ static void GunDescriptionTerminate(GunDescription *g)
 {
 	CFREE(g->name);
 	CFREE(g->Description);
+	CFREE(g->Sound);
+	CFREE(g->ReloadSound);
+	CFREE(g->SwitchSound);
 	memset(g, 0, sizeof *g);
 }
 
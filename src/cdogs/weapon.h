@@ -99,9 +99,11 @@ typedef struct
 	int Cost;			// Cost in score to fire weapon
 	int Lock;
 	int ReloadLead;
-	Mix_Chunk *Sound;
-	Mix_Chunk *ReloadSound;
-	Mix_Chunk *SwitchSound;
+	// Sounds are names, looked up when played so that they are decoded
+	// on first use rather than when the guns are loaded
+	char *Sound;
+	char *ReloadSound;
+	char *SwitchSound;
 	int SoundLockLength;
 	double Recoil;		// Random recoil for inaccurate weapons, in radians
 	struct
@@ -64,6 +64,7 @@
 #include <cdogs/character_class.h>
 #include <cdogs/collision.h>
 #include <cdogs/config_io.h>
+#include <cdogs/draw/actor_pic_cache.h>
 #include <cdogs/draw/draw.h>
 #include <cdogs/draw/drawtools.h>
 #include <cdogs/events.h>
@@ -75,6 +76,7 @@
 #include <cdogs/mission.h>
 #include <cdogs/mission_convert.h>
 #include <cdogs/log.h>
+#include <cdogs/mem_track.h>
 #include <cdogs/objs.h>
 #include <cdogs/palette.h>
 #include <cdogs/particle.h>
@@ -1338,6 +1340,7 @@ int main(int argc, char *argv[])
 
 	gConfig = ConfigLoad(GetConfigFilePath(CONFIG_FILE));
 	PicManagerInit(&gPicManager);
+	ActorPicCacheInit(&gActorPicCache, ACTOR_PIC_CACHE_MAX_BYTES);
 	// Hardcode config settings
 	ConfigGet(&gConfig, "Graphics.ScaleFactor")->u.Int.Value = 2;
 	ConfigGet(&gConfig, "Graphics.ScaleMode")->u.Enum.Value = SCALE_MODE_NN;
@@ -1428,6 +1431,8 @@ int main(int argc, char *argv[])
 	DrawBufferTerminate(&sDrawBuffer);
 	GraphicsTerminate(&gGraphicsDevice);
 	CharSpriteClassesTerminate(&gCharSpriteClasses);
+	ActorPicCacheTerminate(&gActorPicCache);
+	AutomapTerminate();
 	PicManagerTerminate(&gPicManager);
 	FontTerminate(&gFont);
 
@@ -1436,6 +1441,8 @@ int main(int argc, char *argv[])
 	EditorBrushTerminate(&brush);
 
 	ConfigDestroy(&gConfig);
+	MemTrackDump("shutdown");
+	MemTrackTerminate();
 	LogTerminate();
 
 	SDL_Quit();
@@ -0,0 +1,91 @@
+/*
+    C-Dogs SDL
+    A port of the legendary (and fun) action/arcade cdogs.
+
+    Copyright (c) 2016, Cong Xu
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+    Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <string.h>
+
+#include <cdogs/map_pack.h>
+#include <cdogs/sys_config.h>
+#include <cdogs/utils.h>
+
+static void PrintUsage(void)
+{
+	printf("Usage: cdogs-pack <campaign.cdogscpn> [out.%s]\n", MAP_PACK_EXT);
+}
+// Pack a campaign directory into a single file, for distributing and
+// loading large campaigns
+int main(int argc, char *argv[])
+{
+	if (argc < 2 || argc > 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+	const char *dir = argv[1];
+	// Leave room for the temporary file's extension too
+	const size_t maxLen = CDOGS_PATH_MAX - sizeof ".tmp";
+	if (strlen(dir) > maxLen || (argc == 3 && strlen(argv[2]) > maxLen))
+	{
+		fprintf(stderr, "Path too long\n");
+		PrintUsage();
+		return 1;
+	}
+	char out[CDOGS_PATH_MAX];
+	if (argc == 3)
+	{
+		strcpy(out, argv[2]);
+	}
+	else
+	{
+		// Put the pack beside the campaign, with the same name
+		char buf[CDOGS_PATH_MAX];
+		strcpy(buf, dir);
+		const size_t len = strlen(buf);
+		if (len > 1 && (buf[len - 1] == '/' || buf[len - 1] == '\\'))
+		{
+			buf[len - 1] = '\0';
+		}
+		char base[CDOGS_PATH_MAX];
+		PathGetWithoutExtension(base, buf);
+		const int outLen =
+			snprintf(out, sizeof out, "%s.%s", base, MAP_PACK_EXT);
+		if (outLen < 0 || (size_t)outLen > maxLen)
+		{
+			fprintf(stderr, "Path too long\n");
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!MapPackCreate(out, dir))
+	{
+		fprintf(stderr, "Cannot pack %s into %s\n", dir, out);
+		return 1;
+	}
+	printf("Packed %s into %s\n", dir, out);
+	return 0;
+}
@@ -31,6 +31,7 @@
 
 #include <cdogs/config.h>
 #include <cdogs/log.h>
+#include <cdogs/startup.h>
 #include <cdogs/sys_config.h>
 #include <cdogs/utils.h>
 
@@ -93,6 +94,8 @@ void PrintHelp(void)
 	printf("%s\n",
 		"Other:\n"
 		"    --connect=host   (Experimental) connect to a game server\n"
+		"    --startup-profile  Print how long each part of startup takes\n"
+		"    --fast-start     Load sounds and campaigns on other threads\n"
 		);
 
 	printf("%s\n",
@@ -136,6 +139,8 @@ bool ParseArgs(
 		{ "config",		optional_argument,	NULL,	'C' },
 		{ "log",		required_argument,	NULL,	1000 },
 		{ "logfile",	required_argument,	NULL,	1001 },
+		{ "startup-profile",	no_argument,	NULL,	1002 },
+		{ "fast-start",	no_argument,		NULL,	1003 },
 		{ "help",		no_argument,		NULL,	'h' },
 		{ 0,			0,					NULL,	0 }
 	};
@@ -202,6 +207,12 @@ bool ParseArgs(
 		case 1001:
 			LogOpenFile(optarg);
 			break;
+		case 1002:
+			gStartup.Profile = true;
+			break;
+		case 1003:
+			gStartup.Fast = true;
+			break;
 		case 'x':
 			if (enet_address_set_host(connectAddr, optarg) != 0)
 			{
@@ -72,6 +72,7 @@
 #include <cdogs/joystick.h>
 #include <cdogs/log.h>
 #include <cdogs/los.h>
+#include <cdogs/mem_track.h>
 #include <cdogs/mission.h>
 #include <cdogs/music.h>
 #include <cdogs/net_client.h>
@@ -275,6 +276,7 @@ bool RunGame(const CampaignOptions *co, struct MissionOptions *m, Map *map)
 	data.loop.InputEverySecondFrame = true;
 	GameLoop(&data.loop);
 	LOG(LM_MAIN, LL_INFO, "Game finished");
+	MemTrackDump("mission");
 
 	// Flush events
 	HandleGameEvents(&gGameEvents, NULL, NULL, NULL);
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <assert.h>
 #include <memory.h>
+#include <stddef.h>
 #include <sys/types.h>
 
 
@@ -185,54 +186,610 @@ rcs_length (rcstring * rcs)
 /* end of rc_string part */
 
 
-enum json_error
-json_stream_parse (FILE * file, json_t ** document)
+/* arena part */
+
+#define JSON_ARENA_BLOCK_SIZE (64 * 1024)
+
+struct json_arena_block
 {
-	char buffer[1024];	/* hard-coded value */
-	unsigned int error = JSON_INCOMPLETE_DOCUMENT;
+	struct json_arena_block *next;
+	size_t size;
+	size_t used;
+	union
+	{
+		double d;
+		void *p;
+	} data[];	/* aligned for any node member */
+};
 
-	struct json_parsing_info state;
+struct json_arena
+{
+	struct json_arena_block *blocks;	/* head is the block being filled */
+	size_t block_size;
+	json_t root;
+};
 
-	assert (file != NULL);	/* must be an open stream */
-	assert (document != NULL);	/* must be a valid pointer reference */
-	assert (*document == NULL);	/* only accepts a null json_t pointer, to avoid memory leaks */
 
-	json_jpi_init (&state);	/* initializes the json_parsing_info object */
+static struct json_arena *
+json_arena_new (const size_t block_size)
+{
+	struct json_arena *arena = malloc (sizeof (struct json_arena));
+	if (arena == NULL)
+		return NULL;
+	arena->blocks = NULL;
+	arena->block_size = block_size > JSON_ARENA_BLOCK_SIZE ? block_size : JSON_ARENA_BLOCK_SIZE;
+	memset (&arena->root, 0, sizeof (json_t));
+	arena->root.type = JSON_OBJECT;
+	arena->root.flags = JSON_FLAG_ARENA | JSON_FLAG_ARENA_ROOT;
+	return arena;
+}
 
-	while ((error == JSON_WAITING_FOR_EOF) || (error == JSON_INCOMPLETE_DOCUMENT))
+
+static void
+json_arena_free (struct json_arena *arena)
+{
+	while (arena->blocks != NULL)
 	{
-		if (fgets (buffer, 1024, file) != NULL)
-		{
-			switch (error = json_parse_fragment (&state, buffer))
-			{
-			case JSON_OK:
-			case JSON_WAITING_FOR_EOF:
-			case JSON_INCOMPLETE_DOCUMENT:
-				break;
+		struct json_arena_block *next = arena->blocks->next;
+		free (arena->blocks);
+		arena->blocks = next;
+	}
+	free (arena);
+}
 
-			default:
-				json_free_value (&state.cursor);
-				return error;
-				break;
-			}
+
+static void *
+json_arena_alloc (struct json_arena *arena, size_t size)
+{
+	struct json_arena_block *block = arena->blocks;
+	const size_t align = sizeof (block->data[0]);
+	void *p;
+
+	size = (size + align - 1) / align * align;
+	if (block == NULL || block->used + size > block->size)
+	{
+		const size_t block_size = size > arena->block_size ? size : arena->block_size;
+		block = malloc (sizeof (struct json_arena_block) + block_size);
+		if (block == NULL)
+			return NULL;
+		block->size = block_size;
+		block->used = 0;
+		if (arena->blocks != NULL && block_size > arena->block_size)
+		{
+			/* keep filling the current block; this one is already full */
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
 		}
 		else
 		{
-			if (error == JSON_WAITING_FOR_EOF)
-				error = JSON_OK;
-			else
+			block->next = arena->blocks;
+			arena->blocks = block;
+		}
+	}
+	p = (char *) block->data + block->used;
+	block->used += size;
+	return p;
+}
+
+
+/* end of arena part */
+
+
+/* label index part */
+
+/* objects with fewer members are searched linearly */
+#define JSON_INDEX_MIN_LABELS 8
+
+struct json_index
+{
+	size_t mask;	/* number of slots minus one; a power of two */
+	json_t *slots[];	/* open addressing with linear probing; NULL if empty */
+};
+
+
+static size_t
+json_index_hash (const char *text)
+{
+	/* FNV-1a */
+	size_t hash = 2166136261u;
+	for (; *text != '\0'; text++)
+	{
+		hash = (hash ^ (unsigned char) *text) * 16777619u;
+	}
+	return hash;
+}
+
+
+static struct json_index *
+json_index_new (struct json_arena *arena, const json_t * object, const size_t count)
+{
+	struct json_index *index;
+	size_t slots = 1;
+	json_t *cursor;
+
+	/* keep the table at most half full */
+	while (slots < count * 2)
+		slots *= 2;
+	index = json_arena_alloc (arena, sizeof (struct json_index) + slots * sizeof (json_t *));
+	if (index == NULL)
+		return NULL;
+	index->mask = slots - 1;
+	memset (index->slots, 0, slots * sizeof (json_t *));
+
+	/* insert in order so that, for duplicate labels, the first one is found first */
+	for (cursor = object->child; cursor != NULL; cursor = cursor->next)
+	{
+		size_t i = json_index_hash (cursor->text) & index->mask;
+		while (index->slots[i] != NULL)
+			i = (i + 1) & index->mask;
+		index->slots[i] = cursor;
+	}
+	return index;
+}
+
+
+static json_t *
+json_index_find (const struct json_index *index, const char *text_label)
+{
+	size_t i = json_index_hash (text_label) & index->mask;
+	for (; index->slots[i] != NULL; i = (i + 1) & index->mask)
+	{
+		if (strcmp (index->slots[i]->text, text_label) == 0)
+			return index->slots[i];
+	}
+	return NULL;
+}
+
+
+/* end of label index part */
+
+
+/* DOM parser part */
+
+/* deeper documents are rejected rather than overflowing the stack */
+#define JSON_MAX_DEPTH 512
+
+struct json_dom_parser
+{
+	struct json_arena *arena;
+	char *p;	/* the document is parsed in place; strings are terminated where their closing quote was */
+	size_t line;
+	int depth;
+};
+
+
+static enum json_error json_dom_parse_value (struct json_dom_parser *parser, json_t * parent);
+
+
+static void
+json_dom_skip_white_spaces (struct json_dom_parser *parser)
+{
+	for (;;)
+	{
+		switch (*parser->p)
+		{
+		case '\x0A':	/* line feed or new line */
+			parser->line++;
+			/* fall through */
+		case '\x20':	/* space */
+		case '\x09':	/* horizontal tab */
+		case '\x0D':	/* Carriage return */
+			parser->p++;
+			break;
+
+		default:
+			return;
+		}
+	}
+}
+
+
+static enum json_error
+json_dom_error (const struct json_dom_parser *parser, const enum json_error error)
+{
+	if (*parser->p == '\0' && error == JSON_MALFORMED_DOCUMENT)
+		return JSON_INCOMPLETE_DOCUMENT;
+	fprintf (stderr, "JSON: unexpected character at line %ld\n", (long) parser->line);
+	return error;
+}
+
+
+static json_t *
+json_dom_new_value (struct json_dom_parser *parser, json_t * parent, const enum json_value_type type)
+{
+	json_t *value = json_arena_alloc (parser->arena, sizeof (json_t));
+	if (value == NULL)
+		return NULL;
+
+	memset (value, 0, sizeof (json_t));
+	value->type = type;
+	value->flags = JSON_FLAG_ARENA;
+
+	/* append to the parent, as json_insert_child would without the checks */
+	value->parent = parent;
+	if (parent->child_end != NULL)
+	{
+		value->previous = parent->child_end;
+		parent->child_end->next = value;
+	}
+	else
+	{
+		parent->child = value;
+	}
+	parent->child_end = value;
+	return value;
+}
+
+
+static enum json_error
+json_dom_parse_string (struct json_dom_parser *parser, json_t * value)
+{
+	char *p = parser->p + 1;	/* skip the opening quote */
+	int i;
+
+	value->text = p;
+	for (;;)
+	{
+		const unsigned char c = (unsigned char) *p;
+		if (c == '\"')
+			break;
+		if (c == '\0')
+		{
+			parser->p = p;
+			return JSON_INCOMPLETE_DOCUMENT;
+		}
+		if (c < 0x20)
+		{
+			/* ASCII control characters can only be present in a JSON string if they are escaped */
+			parser->p = p;
+			return json_dom_error (parser, JSON_ILLEGAL_CHARACTER);
+		}
+		p++;
+		if (c != '\\')
+			continue;
+
+		/* escape sequences are validated but kept, like the lexer does */
+		switch (*p)
+		{
+		case '\\':
+		case '\"':
+		case '/':
+		case 'b':
+		case 'f':
+		case 'n':
+		case 'r':
+		case 't':
+			p++;
+			break;
+
+		case 'u':
+			p++;
+			for (i = 0; i < 4; i++, p++)
 			{
-				/*TODO refine this error code */
-				error = JSON_UNKNOWN_PROBLEM;
+				if (!((*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'f') || (*p >= 'A' && *p <= 'F')))
+				{
+					parser->p = p;
+					return json_dom_error (parser, JSON_ILLEGAL_CHARACTER);
+				}
 			}
+			break;
+
+		default:
+			parser->p = p;
+			return json_dom_error (parser, JSON_ILLEGAL_CHARACTER);
+		}
+	}
+	*p = '\0';
+	parser->p = p + 1;
+	return JSON_OK;
+}
+
+
+static enum json_error
+json_dom_parse_number (struct json_dom_parser *parser, json_t * value)
+{
+	char *start = parser->p;
+	char *p = start;
+	int is_integer = 1;
+	double number = 0;
+	size_t length;
+
+	if (*p == '-')
+		p++;
+	if (*p == '0')
+		p++;
+	else if (*p >= '1' && *p <= '9')
+	{
+		for (; *p >= '0' && *p <= '9'; p++)
+			number = number * 10 + (*p - '0');
+	}
+	else
+	{
+		parser->p = p;
+		return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+	}
+	if (*p == '.')
+	{
+		is_integer = 0;
+		p++;
+		if (!(*p >= '0' && *p <= '9'))
+		{
+			parser->p = p;
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
 		}
+		for (; *p >= '0' && *p <= '9'; p++);
+	}
+	if (*p == 'e' || *p == 'E')
+	{
+		is_integer = 0;
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!(*p >= '0' && *p <= '9'))
+		{
+			parser->p = p;
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		}
+		for (; *p >= '0' && *p <= '9'; p++);
+	}
+
+	/* the text can't be terminated in place as the next character is still to be parsed */
+	length = (size_t) (p - start);
+	value->text = json_arena_alloc (parser->arena, length + 1);
+	if (value->text == NULL)
+		return JSON_MEMORY;
+	memcpy (value->text, start, length);
+	value->text[length] = '\0';
+	if (is_integer)
+		value->number = *start == '-' ? -number : number;
+	else
+		value->number = strtod (value->text, NULL);
+	parser->p = p;
+	return JSON_OK;
+}
+
+
+static enum json_error
+json_dom_parse_object (struct json_dom_parser *parser, json_t * object)
+{
+	enum json_error error;
+	size_t count = 0;
+
+	parser->p++;	/* skip the opening brace */
+	json_dom_skip_white_spaces (parser);
+	if (*parser->p == '}')
+	{
+		parser->p++;
+		return JSON_OK;
+	}
+	for (;;)
+	{
+		json_t *label;
+
+		if (*parser->p != '\"')
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		if ((label = json_dom_new_value (parser, object, JSON_STRING)) == NULL)
+			return JSON_MEMORY;
+		if ((error = json_dom_parse_string (parser, label)) != JSON_OK)
+			return error;
+		count++;
+
+		json_dom_skip_white_spaces (parser);
+		if (*parser->p != ':')
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		parser->p++;
+		json_dom_skip_white_spaces (parser);
+		if ((error = json_dom_parse_value (parser, label)) != JSON_OK)
+			return error;
+
+		json_dom_skip_white_spaces (parser);
+		if (*parser->p == '}')
+			break;
+		if (*parser->p != ',')
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		parser->p++;
+		json_dom_skip_white_spaces (parser);
 	}
+	parser->p++;
+
+	if (count >= JSON_INDEX_MIN_LABELS)
+	{
+		if ((object->index = json_index_new (parser->arena, object, count)) == NULL)
+			return JSON_MEMORY;
+	}
+	return JSON_OK;
+}
+
+
+static enum json_error
+json_dom_parse_array (struct json_dom_parser *parser, json_t * array)
+{
+	enum json_error error;
+
+	parser->p++;	/* skip the opening bracket */
+	json_dom_skip_white_spaces (parser);
+	if (*parser->p == ']')
+	{
+		parser->p++;
+		return JSON_OK;
+	}
+	for (;;)
+	{
+		if ((error = json_dom_parse_value (parser, array)) != JSON_OK)
+			return error;
+
+		json_dom_skip_white_spaces (parser);
+		if (*parser->p == ']')
+			break;
+		if (*parser->p != ',')
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		parser->p++;
+		json_dom_skip_white_spaces (parser);
+	}
+	parser->p++;
+	return JSON_OK;
+}
+
+
+static enum json_error
+json_dom_parse_literal (struct json_dom_parser *parser, json_t * parent, const char *literal, const enum json_value_type type)
+{
+	const size_t length = strlen (literal);
+	if (strncmp (parser->p, literal, length) != 0)
+		return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+	if (json_dom_new_value (parser, parent, type) == NULL)
+		return JSON_MEMORY;
+	parser->p += length;
+	return JSON_OK;
+}
+
+
+static enum json_error
+json_dom_parse_value (struct json_dom_parser *parser, json_t * parent)
+{
+	enum json_error error;
+	json_t *value;
+
+	switch (*parser->p)
+	{
+	case '{':
+	case '[':
+		if (parser->depth >= JSON_MAX_DEPTH)
+			return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+		value = json_dom_new_value (parser, parent, *parser->p == '{' ? JSON_OBJECT : JSON_ARRAY);
+		if (value == NULL)
+			return JSON_MEMORY;
+		parser->depth++;
+		if (value->type == JSON_OBJECT)
+			error = json_dom_parse_object (parser, value);
+		else
+			error = json_dom_parse_array (parser, value);
+		parser->depth--;
+		return error;
+
+	case '\"':
+		if ((value = json_dom_new_value (parser, parent, JSON_STRING)) == NULL)
+			return JSON_MEMORY;
+		return json_dom_parse_string (parser, value);
+
+	case '-':
+	case '0':
+	case '1':
+	case '2':
+	case '3':
+	case '4':
+	case '5':
+	case '6':
+	case '7':
+	case '8':
+	case '9':
+		if ((value = json_dom_new_value (parser, parent, JSON_NUMBER)) == NULL)
+			return JSON_MEMORY;
+		return json_dom_parse_number (parser, value);
+
+	case 't':
+		return json_dom_parse_literal (parser, parent, "true", JSON_TRUE);
+
+	case 'f':
+		return json_dom_parse_literal (parser, parent, "false", JSON_FALSE);
+
+	case 'n':
+		return json_dom_parse_literal (parser, parent, "null", JSON_NULL);
+
+	default:
+		return json_dom_error (parser, JSON_MALFORMED_DOCUMENT);
+	}
+}
+
 
+/* Parses a complete document, which must be an object, into a tree whose
+   nodes and strings are all allocated from one arena, together with a copy
+   of the text */
+static enum json_error
+json_dom_parse (json_t ** root, const char *text, const size_t length)
+{
+	struct json_dom_parser parser;
+	enum json_error error;
+
+	/* nodes take up about as much memory as the text */
+	if ((parser.arena = json_arena_new (length)) == NULL)
+		return JSON_MEMORY;
+	if ((parser.p = json_arena_alloc (parser.arena, length + 1)) == NULL)
+	{
+		json_arena_free (parser.arena);
+		return JSON_MEMORY;
+	}
+	memcpy (parser.p, text, length);
+	parser.p[length] = '\0';
+	parser.line = 1;
+	parser.depth = 0;
+
+	json_dom_skip_white_spaces (&parser);
+	if (*parser.p != '{')
+		error = json_dom_error (&parser, JSON_MALFORMED_DOCUMENT);
+	else
+	{
+		parser.depth++;
+		error = json_dom_parse_object (&parser, &parser.arena->root);
+	}
 	if (error == JSON_OK)
 	{
-		*document = state.cursor;
+		/* finished document. only accept whitespaces until EOF */
+		json_dom_skip_white_spaces (&parser);
+		if (*parser.p != '\0')
+			error = json_dom_error (&parser, JSON_MALFORMED_DOCUMENT);
+	}
+
+	if (error != JSON_OK)
+	{
+		json_arena_free (parser.arena);
+		return error;
+	}
+	*root = &parser.arena->root;
+	return JSON_OK;
+}
+
+
+/* end of DOM parser part */
+
+
+enum json_error
+json_stream_parse (FILE * file, json_t ** document)
+{
+	char *text = NULL;
+	size_t length = 0;
+	size_t max = 0;
+	enum json_error error;
+
+	assert (file != NULL);	/* must be an open stream */
+	assert (document != NULL);	/* must be a valid pointer reference */
+	assert (*document == NULL);	/* only accepts a null json_t pointer, to avoid memory leaks */
+
+	/* read the whole document to parse it in one go */
+	do
+	{
+		if (length == max)
+		{
+			char *temp;
+			max = max == 0 ? 4096 : max * 2;
+			if ((temp = realloc (text, max)) == NULL)
+			{
+				free (text);
+				return JSON_MEMORY;
+			}
+			text = temp;
+		}
+		length += fread (text + length, 1, max - length, file);
+	}
+	while (length == max);
+	if (ferror (file))
+	{
+		free (text);
+		return JSON_UNKNOWN_PROBLEM;
 	}
 
+	error = json_dom_parse (document, text, length);
+	free (text);
 	return error;
 }
 
@@ -248,6 +805,9 @@ json_new_value (const enum json_value_type type)
 
 	/* initialize members */
 	new_object->text = NULL;
+	new_object->flags = 0;
+	new_object->number = 0;
+	new_object->index = NULL;
 	new_object->parent = NULL;
 	new_object->child = NULL;
 	new_object->child_end = NULL;
@@ -283,6 +843,9 @@ json_new_string (const char *text)
 		return NULL;
 	}
 	strncpy (new_object->text, text, length);
+	new_object->flags = 0;
+	new_object->number = 0;
+	new_object->index = NULL;
 	new_object->parent = NULL;
 	new_object->child = NULL;
 	new_object->child_end = NULL;
@@ -315,6 +878,9 @@ json_new_number (const char *text)
 		return NULL;
 	}
 	strncpy (new_object->text, text, length);
+	new_object->flags = 0;
+	new_object->number = strtod (text, NULL);
+	new_object->index = NULL;
 	new_object->parent = NULL;
 	new_object->child = NULL;
 	new_object->child_end = NULL;
@@ -423,11 +989,19 @@ intern_json_free_value (json_t ** value)
 	}
 
 	/*finally, freeing the memory allocated for this value */
-	if ((*value)->text != NULL)
+	if ((*value)->flags & JSON_FLAG_ARENA_ROOT)
 	{
-		free ((*value)->text);
+		/* releases the whole document, including this value */
+		json_arena_free ((struct json_arena *) ((char *) (*value) - offsetof (struct json_arena, root)));
+	}
+	else if (!((*value)->flags & JSON_FLAG_ARENA))
+	{
+		if ((*value)->text != NULL)
+		{
+			free ((*value)->text);
+		}
+		free (*value);		/* the json value */
 	}
-	free (*value);		/* the json value */
 	(*value) = NULL;
 }
 
@@ -442,6 +1016,12 @@ json_free_value (json_t ** value)
 		return;
 	}
 
+	/* the parent's members are changing */
+	if ((*value)->parent)
+	{
+		(*value)->parent->index = NULL;
+	}
+
 	while (*value)
 	{
 		json_t *parent;
@@ -530,6 +1110,7 @@ json_insert_child (json_t * parent, json_t * child)
 	}
 
 	child->parent = parent;
+	parent->index = NULL;
 	if (parent->child)
 	{
 		child->previous = parent->child_end;
@@ -2431,6 +3012,7 @@ json_parse_fragment (struct json_parsing_info *info, const char *buffer)
 					if ((temp = json_new_value (JSON_NUMBER)) == NULL)
 						return JSON_MEMORY;
 					temp->text = rcs_unwrap (info->lex_text), info->lex_text = NULL;
+					temp->number = strtod (temp->text, NULL);
 					if (json_insert_child (info->cursor, temp) != JSON_OK)
 					{
 						/*TODO specify the exact error message */
@@ -2589,6 +3171,7 @@ json_parse_fragment (struct json_parsing_info *info, const char *buffer)
 					if ((temp = json_new_value (JSON_NUMBER)) == NULL)
 						return JSON_MEMORY;
 					temp->text = rcs_unwrap (info->lex_text), info->lex_text = NULL;
+					temp->number = strtod (temp->text, NULL);
 					if (json_insert_child (info->cursor, temp) != JSON_OK)
 					{
 						return JSON_UNKNOWN_PROBLEM;
@@ -2786,33 +3369,22 @@ json_parse_fragment (struct json_parsing_info *info, const char *buffer)
 enum json_error
 json_parse_document (json_t ** root, const char *text)
 {
-	enum json_error error;
-	struct json_parsing_info *jpi;
-
 	assert (root != NULL);
 	assert (*root == NULL);
 	assert (text != NULL);
 
-	/* initialize the parsing structure */
-	jpi = malloc (sizeof (struct json_parsing_info));
-	if (jpi == NULL)
-	{
-		return JSON_MEMORY;
-	}
-	json_jpi_init (jpi);
+	return json_dom_parse (root, text, strlen (text));
+}
 
-	error = json_parse_fragment (jpi, text);
-	if ((error == JSON_WAITING_FOR_EOF) || (error == JSON_OK))
-	{
-		*root = jpi->cursor;
-		free (jpi);
-		return JSON_OK;
-	}
-	else
-	{
-		free (jpi);
-		return error;
-	}
+
+enum json_error
+json_parse_buffer (json_t ** root, const char *text, size_t length)
+{
+	assert (root != NULL);
+	assert (*root == NULL);
+	assert (text != NULL);
+
+	return json_dom_parse (root, text, length);
 }
 
 
@@ -4218,6 +4790,10 @@ json_find_first_label (const json_t * object, const char *text_label)
 	assert (text_label != NULL);
 	assert (object->type == JSON_OBJECT);
 
+	if (object->index != NULL)
+	{
+		return json_index_find (object->index, text_label);
+	}
 	for (cursor = object->child; cursor != NULL; cursor = cursor->next)
 	{
 		if (strcmp (cursor->text, text_label) == 0)
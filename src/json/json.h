@@ -84,13 +84,32 @@ The error messages produced by the JSON parsers
 	};
 
 
+/**
+How the memory of a node is owned
+**/
+	enum json_value_flags
+	{
+		JSON_FLAG_ARENA = 1,	/*!< the node and its text were allocated from a parsed document's arena, and are released along with the document */
+		JSON_FLAG_ARENA_ROOT = 2	/*!< the node is the root of a parsed document, and owns the arena */
+	};
+
+
+/**
+Hash table of the labels of an object, for fast lookup of members
+**/
+	struct json_index;
+
+
 /**
 The JSON document tree node, which is a basic JSON type
 **/
 	typedef struct json_value
 	{
 		enum json_value_type type;	/*!< the type of node */
+		unsigned int flags;	/*!< json_value_flags */
 		char *text;	/*!< The text stored by the node. It stores UTF-8 strings and is used exclusively by the JSON_STRING and JSON_NUMBER node types */
+		double number;	/*!< The value of JSON_NUMBER nodes, converted from text once when the node is created */
+		struct json_index *index;	/*!< Label lookup table of wide JSON_OBJECT nodes created by the parser, or NULL; dropped when the object changes */
 
 		/* FIFO queue data */
 		struct json_value *next;	/*!< The pointer pointing to the next element in the FIFO sibling list */
@@ -148,6 +167,7 @@ The structure holding the information needed for json_saxy_parse to resume parsi
 
 /** 
 Buils a json_t document by parsing an open file stream
+The document's nodes and strings are allocated from a single arena owned by the root node, which is released by calling json_free_value on the root. Nodes created by json_new_* functions may be inserted into the document, but nodes of the document must not be kept after it has been freed.
 @param file a pointer to an object controlling a stream, returned by fopen()
 @param document a reference to a json_t pointer, set to NULL, which will store the parsed document
 @return a json_error error code according to how the parsing operation went.
@@ -316,6 +336,7 @@ Produces a document tree sequentially from a JSON markup text fragment
 
 /**
 Produces a document tree from a JSON markup text string that contains a complete document
+The tree is allocated from an arena, as with json_stream_parse
 @param root a reference to a pointer to a json_t type. The function allocates memory to the passed pointer and sets up the value
 @param text a c-string containing a complete JSON text document
 @return a pointer to the new document tree or NULL if some error occurred
@@ -323,6 +344,16 @@ Produces a document tree from a JSON markup text string that contains a complete
 	enum json_error json_parse_document (json_t ** root, const char *text);
 
 
+/**
+Produces a document tree from a buffer holding a complete document, which need not be null-terminated
+@param root a reference to a pointer to a json_t type, as with json_parse_document
+@param text the JSON text document
+@param length the length of the document in bytes
+@return a json_error code describing how the operation went
+**/
+	enum json_error json_parse_buffer (json_t ** root, const char *text, size_t length);
+
+
 /**
 Function to perform a SAX-like parsing of any JSON document or document fragment that is passed to it
 @param jsps a structure holding the status information of the current parser
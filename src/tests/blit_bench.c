@@ -0,0 +1,374 @@
+// Microbenchmark for the blitters, drawing a crowded scene of real sprites
+// Usage: blit_bench [graphics dir], defaulting to ../../graphics
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <blit.h>
+#include <blit_kernels.h>
+#include <draw/render_jobs.h>
+#include <grafx.h>
+#include <pic.h>
+
+// Stubs
+GraphicsDevice gGraphicsDevice;
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+#define SCREEN_W 320
+#define SCREEN_H 240
+// Sprites drawn per frame, roughly a busy multiplayer fight
+#define SCENE_SPRITES 400
+#define FRAMES 200
+
+// Sprite files and the size of their first frame
+typedef struct
+{
+	const char *Name;
+	int W, H;
+} SpriteFile;
+static const SpriteFile sSprites[] =
+{
+	{ "barrel.png", 16, 22 },
+	{ "crate.png", 16, 22 },
+	{ "chars/death_16x22.png", 16, 22 },
+	{ "chars/bodies/base/legs_run_24x24.png", 24, 24 },
+	{ "chars/bodies/base/upper_run_handgun_24x24.png", 24, 24 },
+	{ "chars/heads/ogre_10x10.png", 10, 10 },
+	{ NULL, 0, 0 }
+};
+
+static bool LoadSprite(Pic *p, const char *dir, const SpriteFile *s)
+{
+	char path[1024];
+	sprintf(path, "%s/%s", dir, s->Name);
+	SDL_Surface *imageIn = IMG_Load(path);
+	if (imageIn == NULL)
+	{
+		fprintf(stderr, "Cannot load %s: %s\n", path, IMG_GetError());
+		return false;
+	}
+	SDL_Surface *image = SDL_ConvertSurfaceFormat(
+		imageIn, SDL_PIXELFORMAT_RGBA8888, 0);
+	SDL_FreeSurface(imageIn);
+	if (image == NULL)
+	{
+		return false;
+	}
+	SDL_LockSurface(image);
+	PicLoad(p, Vec2iNew(s->W, s->H), Vec2iZero(), image);
+	PicTrim(p, true, true);
+	SDL_UnlockSurface(image);
+	SDL_FreeSurface(image);
+	return true;
+}
+
+static void DrawScene(
+	GraphicsDevice *g, const Pic *pics, const int n, const int f,
+	const bool isMasked)
+{
+	const color_t mask = { 128, 192, 255, 255 };
+	for (int i = 0; i < SCENE_SPRITES; i++)
+	{
+		// Spread sprites over the screen, some clipped by the edges
+		const Vec2i pos = Vec2iNew(
+			(i * 37 + f) % (SCREEN_W + 16) - 8,
+			(i * 23 + f) % (SCREEN_H + 16) - 8);
+		const Pic *p = &pics[i % n];
+		if (isMasked)
+		{
+			BlitMasked(g, p, pos, mask, true);
+		}
+		else
+		{
+			Blit(g, p, pos);
+		}
+	}
+}
+
+// Time a frame's worth of blits, in microseconds
+static double Bench(const Pic *pics, const int n, const bool isMasked)
+{
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (int f = 0; f < FRAMES; f++)
+	{
+		DrawScene(&gGraphicsDevice, pics, n, f, isMasked);
+	}
+	const Uint64 end = SDL_GetPerformanceCounter();
+	return (double)(end - start) * 1000000.0 /
+		SDL_GetPerformanceFrequency() / FRAMES;
+}
+
+// The scene split into one horizontal band per render thread
+typedef struct
+{
+	const Pic *Pics;
+	int N;
+	int Frame;
+	bool IsMasked;
+	int NumBands;
+} SceneBands;
+static void DrawSceneBand(void *data, const int index)
+{
+	const SceneBands *s = data;
+	GraphicsDevice g = gGraphicsDevice;
+	g.clipping.top = index * SCREEN_H / s->NumBands;
+	g.clipping.bottom = (index + 1) * SCREEN_H / s->NumBands - 1;
+	DrawScene(&g, s->Pics, s->N, s->Frame, s->IsMasked);
+}
+static double BenchThreads(
+	const Pic *pics, const int n, const bool isMasked, const int threads)
+{
+	RenderJobsInit(threads);
+	SceneBands s;
+	s.Pics = pics;
+	s.N = n;
+	s.IsMasked = isMasked;
+	s.NumBands = RenderJobsNumThreads();
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (s.Frame = 0; s.Frame < FRAMES; s.Frame++)
+	{
+		RenderJobsRun(DrawSceneBand, &s, s.NumBands);
+	}
+	const Uint64 end = SDL_GetPerformanceCounter();
+	RenderJobsTerminate();
+	return (double)(end - start) * 1000000.0 /
+		SDL_GetPerformanceFrequency() / FRAMES;
+}
+
+// Full-screen effects, as a menu background tint and the automap overlay
+// did them point by point, and as spans with lookup tables
+static const HSV sBenchTint = { -1.0, 0.5, 0.5 };
+static const color_t sBenchMask = { 0, 128, 0, 255 };
+static void TintPerPoint(GraphicsDevice *g)
+{
+	for (int i = 0; i < SCREEN_W * SCREEN_H; i++)
+	{
+		g->buf[i] = COLOR2PIXEL(ColorTint(PIXEL2COLOR(g->buf[i]), sBenchTint));
+	}
+}
+static void TintSpans(GraphicsDevice *g)
+{
+	BlitTintRect(g, Vec2iZero(), g->cachedConfig.Res, sBenchTint);
+}
+static void MaskPerPoint(GraphicsDevice *g)
+{
+	for (int i = 0; i < SCREEN_W * SCREEN_H; i++)
+	{
+		g->buf[i] = COLOR2PIXEL(ColorMult(PIXEL2COLOR(g->buf[i]), sBenchMask));
+	}
+}
+static void MaskSpans(GraphicsDevice *g)
+{
+	BlitMaskRect(g, Vec2iZero(), g->cachedConfig.Res, sBenchMask);
+}
+// A screen of fogged tiles, as when the floor layer cache is cold
+#define FOG_TILE_W 16
+#define FOG_TILE_H 12
+static void FogTiles(GraphicsDevice *g, const Pic *tile)
+{
+	for (int y = 0; y < SCREEN_H; y += tile->size.y)
+	{
+		for (int x = 0; x < SCREEN_W; x += tile->size.x)
+		{
+			BlitMasked(g, tile, Vec2iNew(x, y), colorFog, false);
+		}
+	}
+}
+static double BenchEffect(void (*f)(GraphicsDevice *))
+{
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < FRAMES; i++)
+	{
+		f(&gGraphicsDevice);
+	}
+	const Uint64 end = SDL_GetPerformanceCounter();
+	return (double)(end - start) * 1000000.0 /
+		SDL_GetPerformanceFrequency() / FRAMES;
+}
+static double BenchFog(const Pic *tile)
+{
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < FRAMES; i++)
+	{
+		FogTiles(&gGraphicsDevice, tile);
+	}
+	const Uint64 end = SDL_GetPerformanceCounter();
+	return (double)(end - start) * 1000000.0 /
+		SDL_GetPerformanceFrequency() / FRAMES;
+}
+
+// Screen uploads at 1080p divided by each scale factor, for a menu with a
+// moving cursor and for a scrolling game screen
+static void DrawUploadFrame(
+	GraphicsDevice *g, const Uint32 *bkg, const Pic *cursor, const int f,
+	const bool isScrolling)
+{
+	const Vec2i size = g->cachedConfig.Res;
+	const int scroll = isScrolling ? f : 0;
+	for (int y = 0; y < size.y; y++)
+	{
+		memcpy(
+			g->buf + y * size.x, bkg + (y + scroll) % size.y * size.x,
+			size.x * sizeof(Uint32));
+	}
+	Blit(g, cursor, Vec2iNew(f * 3 % size.x, size.y / 2));
+}
+static void BenchUploads(
+	const Pic *cursor, const int scale, const bool isScrolling)
+{
+	const Vec2i size = Vec2iNew(1920 / scale, 1080 / scale);
+	const size_t bytes = size.x * size.y * sizeof(Uint32);
+	const GraphicsDevice old = gGraphicsDevice;
+	gGraphicsDevice.cachedConfig.Res = size;
+	gGraphicsDevice.clipping.right = size.x - 1;
+	gGraphicsDevice.clipping.bottom = size.y - 1;
+	Uint32 *bkg;
+	CMALLOC(bkg, bytes);
+	for (int i = 0; i < size.x * size.y; i++)
+	{
+		bkg[i] = (Uint32)i * 2654435761u | 0xFF000000;
+	}
+	CMALLOC(gGraphicsDevice.buf, bytes);
+	Uint32 *prev;
+	CMALLOC(prev, bytes);
+	DrawUploadFrame(&gGraphicsDevice, bkg, cursor, 0, isScrolling);
+	memcpy(prev, gGraphicsDevice.buf, bytes);
+	CArray rects;
+	CArrayInit(&rects, sizeof(Rect2i));
+	size_t uploaded = 0;
+	Uint64 ticks = 0;
+	for (int f = 1; f <= FRAMES; f++)
+	{
+		DrawUploadFrame(&gGraphicsDevice, bkg, cursor, f, isScrolling);
+		const Uint64 start = SDL_GetPerformanceCounter();
+		BlitDirtyRects(&rects, prev, gGraphicsDevice.buf, size);
+		ticks += SDL_GetPerformanceCounter() - start;
+		CA_FOREACH(const Rect2i, r, rects)
+			uploaded += r->Size.x * r->Size.y * sizeof(Uint32);
+		CA_FOREACH_END()
+	}
+	printf(
+		"%4dx%-4d %-6s %10.1f %10.1f %10.1f\n",
+		size.x, size.y, isScrolling ? "game" : "menu",
+		bytes / 1024.0, uploaded / 1024.0 / FRAMES,
+		(double)ticks * 1000000.0 / SDL_GetPerformanceFrequency() / FRAMES);
+	CArrayTerminate(&rects);
+	CFREE(prev);
+	CFREE(gGraphicsDevice.buf);
+	CFREE(bkg);
+	gGraphicsDevice = old;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *dir = argc > 1 ? argv[1] : "../../graphics";
+	if (IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG)
+	{
+		fprintf(stderr, "IMG_Init failed: %s\n", IMG_GetError());
+		return EXIT_FAILURE;
+	}
+	gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	Pic pics[sizeof sSprites / sizeof sSprites[0]];
+	Pic picsNoSpans[sizeof sSprites / sizeof sSprites[0]];
+	int n = 0;
+	for (int i = 0; sSprites[i].Name != NULL; i++)
+	{
+		if (LoadSprite(&pics[n], dir, &sSprites[i]))
+		{
+			// Same pixels, but drawn without skipping empty runs
+			picsNoSpans[n] = pics[n];
+			picsNoSpans[n].SpanRows = NULL;
+			picsNoSpans[n].Spans = NULL;
+			n++;
+		}
+	}
+	if (n == 0)
+	{
+		fprintf(stderr, "No sprites loaded from %s\n", dir);
+		return EXIT_FAILURE;
+	}
+	CCALLOC(gGraphicsDevice.buf, SCREEN_W * SCREEN_H * sizeof(Uint32));
+	gGraphicsDevice.cachedConfig.Res = Vec2iNew(SCREEN_W, SCREEN_H);
+	gGraphicsDevice.clipping.right = SCREEN_W - 1;
+	gGraphicsDevice.clipping.bottom = SCREEN_H - 1;
+
+	printf(
+		"%d sprites per frame, microseconds per frame\n", SCENE_SPRITES);
+	printf(
+		"%-8s %10s %10s %12s %12s\n",
+		"kernels", "Blit", "Masked", "Blit/rows", "Masked/rows");
+	for (int t = 0; t < BLIT_KERNELS_COUNT; t++)
+	{
+		if (!BlitKernelsSelect((BlitKernelsType)t))
+		{
+			continue;
+		}
+		printf(
+			"%-8s %10.1f %10.1f %12.1f %12.1f\n",
+			BlitKernelsTypeStr((BlitKernelsType)t),
+			Bench(pics, n, false), Bench(pics, n, true),
+			Bench(picsNoSpans, n, false), Bench(picsNoSpans, n, true));
+	}
+
+	// Best kernels, scene drawn in bands by the render jobs
+	BlitKernelsInit();
+	printf(
+		"\n%d CPUs, scene drawn in one band per thread\n", SDL_GetCPUCount());
+	printf("%-8s %10s %10s\n", "threads", "Blit", "Masked");
+	for (int threads = 1; threads <= 8; threads *= 2)
+	{
+		printf(
+			"%-8d %10.1f %10.1f\n",
+			threads,
+			BenchThreads(pics, n, false, threads),
+			BenchThreads(pics, n, true, threads));
+	}
+
+	printf("\nFull-screen effects, microseconds per screen\n");
+	printf("%-8s %10s %10s\n", "effect", "per point", "spans");
+	printf(
+		"%-8s %10.1f %10.1f\n",
+		"tint", BenchEffect(TintPerPoint), BenchEffect(TintSpans));
+	printf(
+		"%-8s %10.1f %10.1f\n",
+		"mask", BenchEffect(MaskPerPoint), BenchEffect(MaskSpans));
+	Pic fogTile;
+	CMALLOC(fogTile.Data, FOG_TILE_W * FOG_TILE_H * sizeof(Uint32));
+	fogTile.size = Vec2iNew(FOG_TILE_W, FOG_TILE_H);
+	fogTile.offset = Vec2iZero();
+	fogTile.SpanRows = NULL;
+	fogTile.Spans = NULL;
+	for (int i = 0; i < FOG_TILE_W * FOG_TILE_H; i++)
+	{
+		fogTile.Data[i] = gGraphicsDevice.buf[i] | 0xFF000000;
+	}
+	printf("%-8s %10s %10.1f\n", "fog", "", BenchFog(&fogTile));
+	PicFree(&fogTile);
+
+	printf("\nScreen uploads per frame, KB and microseconds to diff\n");
+	printf(
+		"%-9s %-6s %10s %10s %10s\n",
+		"res", "screen", "full", "dirty", "diff");
+	for (int scale = 1; scale <= 4; scale++)
+	{
+		BenchUploads(&pics[0], scale, false);
+		BenchUploads(&pics[0], scale, true);
+	}
+
+	CFREE(gGraphicsDevice.buf);
+	for (int i = 0; i < n; i++)
+	{
+		PicFree(&pics[i]);
+	}
+	SDL_FreeFormat(gGraphicsDevice.Format);
+	IMG_Quit();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,711 @@
+#include <cbehave/cbehave.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <blit.h>
+#include <blit_kernels.h>
+#include <draw/actor_pic_cache.h>
+#include <draw/render_jobs.h>
+#include <grafx.h>
+#include <pic.h>
+
+// Stubs
+GraphicsDevice gGraphicsDevice;
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+#define AMASK 0xFF000000
+#define ASHIFT 24
+#define SPAN_MAX 67
+
+static void RandomSpan(Uint32 *p, const int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		// Mostly fully transparent or opaque, like sprites
+		const int r = rand() % 4;
+		const Uint32 a = r == 0 ? 0 : r == 1 ? (Uint32)(rand() % 256) : 0xFF;
+		p[i] = (a << ASHIFT) | ((Uint32)rand() & 0xFFFFFF);
+	}
+}
+
+// Run both kernels on the same input; count pixels that differ
+static int CompareKernels(const BlitKernelsType t, const bool isMult)
+{
+	int mismatches = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		const int n = rand() % SPAN_MAX;
+		const int offset = rand() % 4;
+		Uint32 src[SPAN_MAX + 4], dst[SPAN_MAX + 4];
+		Uint32 expected[SPAN_MAX + 4], actual[SPAN_MAX + 4];
+		RandomSpan(src, SPAN_MAX + 4);
+		RandomSpan(dst, SPAN_MAX + 4);
+		memcpy(expected, dst, sizeof dst);
+		memcpy(actual, dst, sizeof dst);
+		const Uint32 mask = (Uint32)rand() | AMASK;
+		const int minAlpha = rand() % 2 ? 3 : 0;
+		BlitKernelsSelect(BLIT_KERNELS_SCALAR);
+		if (isMult)
+		{
+			gBlitKernels.Mult(
+				expected + offset, src + offset, n, mask, AMASK, ASHIFT,
+				minAlpha);
+		}
+		else
+		{
+			gBlitKernels.CopyKeyed(expected + offset, src + offset, n, AMASK);
+		}
+		BlitKernelsSelect(t);
+		if (isMult)
+		{
+			gBlitKernels.Mult(
+				actual + offset, src + offset, n, mask, AMASK, ASHIFT,
+				minAlpha);
+		}
+		else
+		{
+			gBlitKernels.CopyKeyed(actual + offset, src + offset, n, AMASK);
+		}
+		for (int j = 0; j < SPAN_MAX + 4; j++)
+		{
+			if (expected[j] != actual[j])
+			{
+				mismatches++;
+			}
+		}
+	}
+	BlitKernelsSelect(BLIT_KERNELS_SCALAR);
+	return mismatches;
+}
+
+#define SCREEN_W 64
+#define SCREEN_H 48
+
+// Random sprite with a mix of empty, translucent and opaque runs
+static Pic RandomPic(void)
+{
+	Pic p;
+	p.size = Vec2iNew(1 + rand() % 40, 1 + rand() % 40);
+	p.offset = Vec2iNew(rand() % 9 - 4, rand() % 9 - 4);
+	p.SpanRows = NULL;
+	p.Spans = NULL;
+	p.Data = malloc(p.size.x * p.size.y * sizeof *p.Data);
+	for (int i = 0; i < p.size.x * p.size.y;)
+	{
+		const int n = 1 + rand() % 8;
+		const bool isEmpty = rand() % 2;
+		for (int j = 0; j < n && i < p.size.x * p.size.y; j++, i++)
+		{
+			RandomSpan(&p.Data[i], 1);
+			if (isEmpty)
+			{
+				p.Data[i] = 0;
+			}
+		}
+	}
+	PicUpdateSpans(&p);
+	return p;
+}
+
+static void SetupDevice(Uint32 *buf)
+{
+	gGraphicsDevice.buf = buf;
+	gGraphicsDevice.cachedConfig.Res = Vec2iNew(SCREEN_W, SCREEN_H);
+	gGraphicsDevice.clipping.left = rand() % 8;
+	gGraphicsDevice.clipping.top = rand() % 8;
+	gGraphicsDevice.clipping.right = SCREEN_W - 1 - rand() % 8;
+	gGraphicsDevice.clipping.bottom = SCREEN_H - 1 - rand() % 8;
+}
+
+// Reference: the per-pixel loops with clipping checks
+static void RefBlitMasked(
+	Uint32 *buf, const Pic *pic, const Vec2i pos, const Uint32 mask,
+	const bool isTransparent, const bool isMasked)
+{
+	const GraphicsDevice *g = &gGraphicsDevice;
+	for (int i = 0; i < pic->size.y; i++)
+	{
+		const int y = pos.y + pic->offset.y + i;
+		for (int j = 0; j < pic->size.x; j++)
+		{
+			const int x = pos.x + pic->offset.x + j;
+			const Uint32 p = pic->Data[i * pic->size.x + j];
+			if (y < g->clipping.top || y > g->clipping.bottom ||
+				x < g->clipping.left || x > g->clipping.right)
+			{
+				continue;
+			}
+			if (!isMasked)
+			{
+				if (p & AMASK)
+				{
+					buf[y * SCREEN_W + x] = p;
+				}
+				continue;
+			}
+			if (isTransparent && (p >> ASHIFT) < 3)
+			{
+				continue;
+			}
+			buf[y * SCREEN_W + x] = PixelMult(p, mask) | AMASK;
+		}
+	}
+}
+
+static int CompareBlits(const bool isMasked)
+{
+	int mismatches = 0;
+	gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	for (int i = 0; i < 500; i++)
+	{
+		Uint32 expected[SCREEN_W * SCREEN_H], actual[SCREEN_W * SCREEN_H];
+		RandomSpan(expected, SCREEN_W * SCREEN_H);
+		memcpy(actual, expected, sizeof expected);
+		Pic p = RandomPic();
+		const Vec2i pos = Vec2iNew(
+			rand() % (SCREEN_W + 40) - 40, rand() % (SCREEN_H + 40) - 40);
+		const color_t mask =
+		{
+			(Uint8)rand(), (Uint8)rand(), (Uint8)rand(), 255
+		};
+		const bool isTransparent = rand() % 2;
+		SetupDevice(actual);
+		if (isMasked)
+		{
+			BlitMasked(&gGraphicsDevice, &p, pos, mask, isTransparent);
+		}
+		else
+		{
+			Blit(&gGraphicsDevice, &p, pos);
+		}
+		RefBlitMasked(
+			expected, &p, pos, COLOR2PIXEL(mask), isTransparent, isMasked);
+		for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+		{
+			if (expected[j] != actual[j])
+			{
+				mismatches++;
+			}
+		}
+		PicFree(&p);
+	}
+	SDL_FreeFormat(gGraphicsDevice.Format);
+	return mismatches;
+}
+
+// Reference for BlitTintRect, BlitMaskRect and BlitBlend: per-point colour
+// functions, with clipping checks
+static void RefEffects(
+	Uint32 *screen, const Pic *pic, const Vec2i pos, const HSV tint,
+	const color_t mask)
+{
+	const BlitClipping *clip = &gGraphicsDevice.clipping;
+	for (int y = 0; y < SCREEN_H; y++)
+	{
+		for (int x = 0; x < SCREEN_W; x++)
+		{
+			if (x < clip->left || x > clip->right ||
+				y < clip->top || y > clip->bottom)
+			{
+				continue;
+			}
+			Uint32 *p = &screen[y * SCREEN_W + x];
+			// The region is the pic's size at pos, without its offset
+			if (x >= pos.x && x < pos.x + pic->size.x &&
+				y >= pos.y && y < pos.y + pic->size.y)
+			{
+				*p = COLOR2PIXEL(ColorTint(PIXEL2COLOR(*p), tint));
+				*p = COLOR2PIXEL(ColorMult(PIXEL2COLOR(*p), mask));
+			}
+			const Vec2i v = Vec2iNew(
+				x - pos.x - pic->offset.x, y - pos.y - pic->offset.y);
+			if (v.x < 0 || v.x >= pic->size.x || v.y < 0 ||
+				v.y >= pic->size.y || pic->Data[v.y * pic->size.x + v.x] == 0)
+			{
+				continue;
+			}
+			color_t c = ColorMult(
+				PIXEL2COLOR(pic->Data[v.y * pic->size.x + v.x]), mask);
+			c.a = mask.a;
+			*p = COLOR2PIXEL(ColorAlphaBlend(PIXEL2COLOR(*p), c));
+		}
+	}
+}
+static int CompareEffects(void)
+{
+	int mismatches = 0;
+	gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	for (int i = 0; i < 300; i++)
+	{
+		Uint32 expected[SCREEN_W * SCREEN_H], actual[SCREEN_W * SCREEN_H];
+		RandomSpan(expected, SCREEN_W * SCREEN_H);
+		memcpy(actual, expected, sizeof expected);
+		Pic p = RandomPic();
+		const Vec2i pos = Vec2iNew(
+			rand() % (SCREEN_W + 40) - 40, rand() % (SCREEN_H + 40) - 40);
+		// Hue, grey or saturation tints
+		HSV tint = { rand() % 360, rand() % 3 / 2.0, rand() % 5 / 2.0 };
+		if (rand() % 2)
+		{
+			tint.h = -1.0;
+		}
+		const color_t mask =
+		{
+			(Uint8)rand(), (Uint8)rand(), (Uint8)rand(), (Uint8)rand()
+		};
+		SetupDevice(actual);
+		BlitTintRect(&gGraphicsDevice, pos, p.size, tint);
+		BlitMaskRect(&gGraphicsDevice, pos, p.size, mask);
+		BlitBlend(&gGraphicsDevice, &p, pos, mask);
+		RefEffects(expected, &p, pos, tint, mask);
+		for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+		{
+			if (expected[j] != actual[j])
+			{
+				mismatches++;
+			}
+		}
+		PicFree(&p);
+	}
+	SDL_FreeFormat(gGraphicsDevice.Format);
+	return mismatches;
+}
+
+// A scene of random sprites, drawn in bands by render jobs
+#define SCENE_PICS 40
+typedef struct
+{
+	Pic Pics[SCENE_PICS];
+	Vec2i Pos[SCENE_PICS];
+	color_t Masks[SCENE_PICS];
+	int NumBands;
+} Scene;
+static void DrawScene(GraphicsDevice *g, const Scene *s)
+{
+	for (int i = 0; i < SCENE_PICS; i++)
+	{
+		switch (i % 3)
+		{
+		case 0:
+			Blit(g, &s->Pics[i], s->Pos[i]);
+			break;
+		case 1:
+			BlitMasked(g, &s->Pics[i], s->Pos[i], s->Masks[i], true);
+			break;
+		default:
+			BlitBlend(g, &s->Pics[i], s->Pos[i], s->Masks[i]);
+			break;
+		}
+	}
+}
+static void DrawSceneBand(void *data, const int index)
+{
+	const Scene *s = data;
+	GraphicsDevice g = gGraphicsDevice;
+	g.clipping.top = index * SCREEN_H / s->NumBands;
+	g.clipping.bottom = (index + 1) * SCREEN_H / s->NumBands - 1;
+	DrawScene(&g, s);
+}
+static void CountJob(void *data, const int index)
+{
+	int *counts = data;
+	counts[index]++;
+}
+
+// Random character part, whose alpha picks the colour channel
+static Pic RandomCharPic(void)
+{
+	Pic p = RandomPic();
+	for (int i = 0; i < p.size.x * p.size.y; i++)
+	{
+		if (p.Data[i] != 0)
+		{
+			const Uint32 a = 250 + rand() % 6;
+			p.Data[i] = (p.Data[i] & ~AMASK) | (a << ASHIFT);
+		}
+	}
+	return p;
+}
+static color_t RandomOpaqueColor(void)
+{
+	const color_t c = { (Uint8)rand(), (Uint8)rand(), (Uint8)rand(), 255 };
+	return c;
+}
+static ActorPicKey RandomActorPicKey(Pic *parts)
+{
+	ActorPicKey key;
+	memset(&key, 0, sizeof key);
+	for (int i = 0; i < ACTOR_PIC_PARTS_MAX; i++)
+	{
+		parts[i] = RandomCharPic();
+		// Some actors have no gun
+		if (i < ACTOR_PIC_PARTS_MAX - 1 || rand() % 2)
+		{
+			key.Pics[i] = &parts[i];
+		}
+		key.Offsets[i] = Vec2iNew(rand() % 9 - 4, rand() % 9 - 4);
+	}
+	key.Colors.Skin = RandomOpaqueColor();
+	key.Colors.Arms = RandomOpaqueColor();
+	key.Colors.Body = RandomOpaqueColor();
+	key.Colors.Legs = RandomOpaqueColor();
+	key.Colors.Hair = RandomOpaqueColor();
+	return key;
+}
+
+// Change random parts of a frame and check that uploading only the dirty
+// rects to a copy of the last frame reproduces it; returns the mismatches
+static int CompareDirtyRects(int *uploaded)
+{
+	Uint32 frame[SCREEN_W * SCREEN_H];
+	Uint32 prev[SCREEN_W * SCREEN_H];
+	Uint32 texture[SCREEN_W * SCREEN_H];
+	RandomSpan(frame, SCREEN_W * SCREEN_H);
+	memcpy(prev, frame, sizeof frame);
+	memcpy(texture, frame, sizeof frame);
+	CArray rects;
+	CArrayInit(&rects, sizeof(Rect2i));
+	int mismatches = 0;
+	*uploaded = 0;
+	for (int i = 0; i < 100; i++)
+	{
+		const int changes = rand() % 4;
+		for (int j = 0; j < changes; j++)
+		{
+			const Vec2i pos = Vec2iNew(rand() % SCREEN_W, rand() % SCREEN_H);
+			const Vec2i size = Vec2iNew(
+				rand() % (SCREEN_W - pos.x) + 1,
+				rand() % (SCREEN_H - pos.y) + 1);
+			for (int y = pos.y; y < pos.y + size.y; y++)
+			{
+				RandomSpan(frame + y * SCREEN_W + pos.x, size.x);
+			}
+		}
+		BlitDirtyRects(&rects, prev, frame, Vec2iNew(SCREEN_W, SCREEN_H));
+		CA_FOREACH(const Rect2i, r, rects)
+			for (int y = r->Pos.y; y < r->Pos.y + r->Size.y; y++)
+			{
+				const int k = y * SCREEN_W + r->Pos.x;
+				memcpy(texture + k, frame + k, r->Size.x * sizeof *frame);
+			}
+			*uploaded += r->Size.x * r->Size.y;
+		CA_FOREACH_END()
+		for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+		{
+			if (texture[j] != frame[j] || prev[j] != frame[j])
+			{
+				mismatches++;
+			}
+		}
+	}
+	CArrayTerminate(&rects);
+	return mismatches;
+}
+
+FEATURE(render_jobs, "Render jobs")
+	SCENARIO("Every job runs once")
+		GIVEN("a pool of render threads")
+			RenderJobsInit(4);
+		WHEN("I run more jobs than threads")
+			int counts[37];
+			memset(counts, 0, sizeof counts);
+			RenderJobsRun(CountJob, counts, 37);
+			RenderJobsRun(CountJob, counts, 37);
+			int wrong = 0;
+			for (int i = 0; i < 37; i++)
+			{
+				if (counts[i] != 2) wrong++;
+			}
+			RenderJobsTerminate();
+		THEN("each job should have run once per run")
+			SHOULD_INT_EQUAL(wrong, 0);
+	SCENARIO_END
+
+	SCENARIO("Drawing in bands matches drawing in one pass")
+		GIVEN("a scene of random sprites")
+			srand(5);
+			gGraphicsDevice.Format =
+				SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+			Scene s;
+			for (int i = 0; i < SCENE_PICS; i++)
+			{
+				s.Pics[i] = RandomPic();
+				s.Pos[i] = Vec2iNew(
+					rand() % (SCREEN_W + 40) - 20,
+					rand() % (SCREEN_H + 40) - 20);
+				s.Masks[i] = (color_t){
+					(Uint8)rand(), (Uint8)rand(), (Uint8)rand(),
+					(Uint8)rand()
+				};
+			}
+			Uint32 expected[SCREEN_W * SCREEN_H];
+			Uint32 actual[SCREEN_W * SCREEN_H];
+			RandomSpan(expected, SCREEN_W * SCREEN_H);
+			memcpy(actual, expected, sizeof expected);
+		WHEN("I draw it in one pass, and in bands on several threads")
+			gGraphicsDevice.buf = expected;
+			gGraphicsDevice.cachedConfig.Res = Vec2iNew(SCREEN_W, SCREEN_H);
+			gGraphicsDevice.clipping.left = 0;
+			gGraphicsDevice.clipping.top = 0;
+			gGraphicsDevice.clipping.right = SCREEN_W - 1;
+			gGraphicsDevice.clipping.bottom = SCREEN_H - 1;
+			DrawScene(&gGraphicsDevice, &s);
+			gGraphicsDevice.buf = actual;
+			RenderJobsInit(3);
+			s.NumBands = 7;
+			RenderJobsRun(DrawSceneBand, &s, s.NumBands);
+			RenderJobsTerminate();
+			int mismatches = 0;
+			for (int i = 0; i < SCREEN_W * SCREEN_H; i++)
+			{
+				if (expected[i] != actual[i]) mismatches++;
+			}
+			for (int i = 0; i < SCENE_PICS; i++)
+			{
+				PicFree(&s.Pics[i]);
+			}
+			SDL_FreeFormat(gGraphicsDevice.Format);
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(pic_spans, "Pic spans")
+	SCENARIO("Spans cover exactly the non-empty pixels")
+		GIVEN("random sprites")
+			srand(3);
+		WHEN("I build their spans")
+			int mismatches = 0;
+			for (int i = 0; i < 200; i++)
+			{
+				Pic p = RandomPic();
+				for (int y = 0; y < p.size.y; y++)
+				{
+					int x = 0;
+					for (int s = p.SpanRows[y]; s < p.SpanRows[y + 1]; s++)
+					{
+						const PicSpan *span = &p.Spans[s];
+						for (; x < span->Start; x++)
+						{
+							if (p.Data[y * p.size.x + x] != 0) mismatches++;
+						}
+						for (; x < span->Start + span->Len; x++)
+						{
+							if (p.Data[y * p.size.x + x] == 0) mismatches++;
+						}
+					}
+					for (; x < p.size.x; x++)
+					{
+						if (p.Data[y * p.size.x + x] != 0) mismatches++;
+					}
+				}
+				PicFree(&p);
+			}
+		THEN("every pixel should be classified correctly")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("Blitting by spans matches per-pixel blitting")
+		GIVEN("random sprites, positions and clipping")
+			srand(4);
+		WHEN("I blit them normally and masked")
+			const int mismatches = CompareBlits(false) + CompareBlits(true);
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("Tinting, masking and blending match the colour functions")
+		GIVEN("random sprites, regions, colours and clipping")
+			srand(8);
+		WHEN("I tint and mask their regions and blend them")
+			const int mismatches = CompareEffects();
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(blit_kernels, "Blit kernels")
+	SCENARIO("Keyed copy matches the scalar kernel")
+		GIVEN("random sprite spans")
+			srand(1);
+		WHEN("I copy them with every supported kernel type")
+			int mismatches = 0;
+			for (int t = 0; t < BLIT_KERNELS_COUNT; t++)
+			{
+				if (BlitKernelsIsSupported((BlitKernelsType)t))
+				{
+					mismatches += CompareKernels((BlitKernelsType)t, false);
+				}
+			}
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("Masked multiply matches the scalar kernel")
+		GIVEN("random sprite spans and masks")
+			srand(2);
+		WHEN("I multiply them with every supported kernel type")
+			int mismatches = 0;
+			for (int t = 0; t < BLIT_KERNELS_COUNT; t++)
+			{
+				if (BlitKernelsIsSupported((BlitKernelsType)t))
+				{
+					mismatches += CompareKernels((BlitKernelsType)t, true);
+				}
+			}
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(actor_pic_cache, "Actor pic cache")
+	SCENARIO("Composited actors draw like their parts")
+		GIVEN("random actors, positions and clipping")
+			srand(6);
+			gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+			ActorPicCache c;
+			ActorPicCacheInit(&c, ACTOR_PIC_CACHE_MAX_BYTES);
+		WHEN("I draw them by parts and composited")
+			int mismatches = 0;
+			for (int i = 0; i < 200; i++)
+			{
+				Uint32 expected[SCREEN_W * SCREEN_H];
+				Uint32 actual[SCREEN_W * SCREEN_H];
+				RandomSpan(expected, SCREEN_W * SCREEN_H);
+				memcpy(actual, expected, sizeof expected);
+				Pic parts[ACTOR_PIC_PARTS_MAX];
+				const ActorPicKey key = RandomActorPicKey(parts);
+				const Vec2i pos = Vec2iNew(
+					rand() % (SCREEN_W + 40) - 40,
+					rand() % (SCREEN_H + 40) - 40);
+				SetupDevice(expected);
+				for (int j = 0; j < ACTOR_PIC_PARTS_MAX; j++)
+				{
+					if (key.Pics[j] != NULL)
+					{
+						BlitCharMultichannel(
+							&gGraphicsDevice, key.Pics[j],
+							Vec2iAdd(pos, key.Offsets[j]), &key.Colors);
+					}
+				}
+				ActorPicCacheNewFrame(&c, 0);
+				ActorPicCacheAdd(&c, &key);
+				gGraphicsDevice.buf = actual;
+				BlitBackground(
+					&gGraphicsDevice, ActorPicCacheFind(&c, &key), pos,
+					NULL, true);
+				for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+				{
+					if (expected[j] != actual[j])
+					{
+						mismatches++;
+					}
+				}
+				for (int j = 0; j < ACTOR_PIC_PARTS_MAX; j++)
+				{
+					PicFree(&parts[j]);
+				}
+			}
+			ActorPicCacheTerminate(&c);
+			SDL_FreeFormat(gGraphicsDevice.Format);
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("The least recently used frames are evicted")
+		GIVEN("a cache with room for about two frames")
+			srand(7);
+			gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+			Pic parts[3][ACTOR_PIC_PARTS_MAX];
+			ActorPicKey keys[3];
+			size_t maxBytes = 0;
+			for (int i = 0; i < 3; i++)
+			{
+				keys[i] = RandomActorPicKey(parts[i]);
+				// Place the parts together so each frame is 40x40
+				for (int j = 0; j < ACTOR_PIC_PARTS_MAX; j++)
+				{
+					parts[i][j].offset = Vec2iZero();
+					keys[i].Offsets[j] = Vec2iZero();
+				}
+				parts[i][0].size = Vec2iNew(40, 40);
+				parts[i][0].Data = realloc(
+					parts[i][0].Data, 40 * 40 * sizeof(Uint32));
+				memset(parts[i][0].Data, 0xFF, 40 * 40 * sizeof(Uint32));
+				PicUpdateSpans(&parts[i][0]);
+				maxBytes += 40 * 40 * sizeof(Uint32);
+			}
+			ActorPicCache c;
+			ActorPicCacheInit(&c, maxBytes - 1);
+		WHEN("I use two frames, then add a third in a new frame")
+			ActorPicCacheNewFrame(&c, 0);
+			ActorPicCacheAdd(&c, &keys[0]);
+			ActorPicCacheAdd(&c, &keys[1]);
+			ActorPicCacheNewFrame(&c, 0);
+			ActorPicCacheAdd(&c, &keys[1]);
+			const bool thirdAdded = ActorPicCacheAdd(&c, &keys[2]) != NULL;
+		THEN("the least recently used one should be evicted for it")
+			SHOULD_BE_TRUE(thirdAdded);
+			SHOULD_BE_TRUE(ActorPicCacheFind(&c, &keys[0]) == NULL);
+			SHOULD_BE_TRUE(ActorPicCacheFind(&c, &keys[1]) != NULL);
+			SHOULD_BE_TRUE(ActorPicCacheFind(&c, &keys[2]) != NULL);
+		AND("frames used in the current frame should not be evicted")
+			const bool firstAdded = ActorPicCacheAdd(&c, &keys[0]) != NULL;
+			SHOULD_BE_FALSE(firstAdded);
+			SHOULD_BE_TRUE(ActorPicCacheFind(&c, &keys[1]) != NULL);
+			SHOULD_BE_TRUE(ActorPicCacheFind(&c, &keys[2]) != NULL);
+			ActorPicCacheTerminate(&c);
+			for (int i = 0; i < 3; i++)
+			{
+				for (int j = 0; j < ACTOR_PIC_PARTS_MAX; j++)
+				{
+					PicFree(&parts[i][j]);
+				}
+			}
+			SDL_FreeFormat(gGraphicsDevice.Format);
+	SCENARIO_END
+FEATURE_END
+
+FEATURE(dirty_rects, "Dirty rects")
+	SCENARIO("Uploading the dirty rects reproduces the frame")
+		GIVEN("frames with random regions changed")
+			srand(9);
+		WHEN("I upload only the dirty rects of each frame")
+			int uploaded;
+			const int mismatches = CompareDirtyRects(&uploaded);
+		THEN("the uploaded frames should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+		AND("less than the whole screen should be uploaded")
+			SHOULD_INT_LT(uploaded, 100 * SCREEN_W * SCREEN_H);
+	SCENARIO_END
+
+	SCENARIO("An unchanged frame has no dirty rects")
+		GIVEN("a frame that has already been presented")
+			srand(10);
+			Uint32 frame[SCREEN_W * SCREEN_H];
+			Uint32 prev[SCREEN_W * SCREEN_H];
+			RandomSpan(frame, SCREEN_W * SCREEN_H);
+			memcpy(prev, frame, sizeof frame);
+			CArray rects;
+			CArrayInit(&rects, sizeof(Rect2i));
+		WHEN("I find its dirty rects")
+			BlitDirtyRects(
+				&rects, prev, frame, Vec2iNew(SCREEN_W, SCREEN_H));
+		THEN("there should be none")
+			SHOULD_INT_EQUAL((int)rects.size, 0);
+			CArrayTerminate(&rects);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN(
+	"Blit features are:",
+	TEST_FEATURE(actor_pic_cache),
+	TEST_FEATURE(blit_kernels),
+	TEST_FEATURE(dirty_rects),
+	TEST_FEATURE(pic_spans),
+	TEST_FEATURE(render_jobs))
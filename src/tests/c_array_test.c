@@ -1,5 +1,6 @@
 #include <cbehave/cbehave.h>
 
+#include <arena.h>
 #include <c_array.h>
 
 #include <SDL_joystick.h>
@@ -113,9 +114,45 @@ FEATURE(CArrayRemoveIf, "Array remove if")
 	SCENARIO_END
 FEATURE_END
 
+FEATURE(CArrayArena, "Arena-backed array")
+	SCENARIO("Grow arrays in an arena")
+		GIVEN("two arrays backed by the same small arena")
+			Arena arena;
+			ArenaInit(&arena, 256);
+			CArray a;
+			CArrayInitArena(&a, sizeof(int), &arena);
+			CArray b;
+			CArrayInitArena(&b, sizeof(int), &arena);
+
+		WHEN("I push elements into them alternately")
+			for (int i = 0; i < 100; i++)
+			{
+				CArrayPushBack(&a, &i);
+				const int j = -i;
+				CArrayPushBack(&b, &j);
+			}
+
+		THEN("both arrays should contain their elements in order")
+			SHOULD_INT_EQUAL((int)a.size, 100);
+			SHOULD_INT_EQUAL((int)b.size, 100);
+			for (int i = 0; i < 100; i++)
+			{
+				SHOULD_INT_EQUAL(*(int *)CArrayGet(&a, i), i);
+				SHOULD_INT_EQUAL(*(int *)CArrayGet(&b, i), -i);
+			}
+		AND("the arena should own all the storage")
+			SHOULD_INT_GE((int)arena.capacity, (int)(200 * sizeof(int)));
+			CArrayTerminate(&a);
+			CArrayTerminate(&b);
+			ArenaTerminate(&arena);
+			SHOULD_INT_EQUAL((int)arena.capacity, 0);
+	SCENARIO_END
+FEATURE_END
+
 CBEHAVE_RUN(
 	"CArray features are:",
 	TEST_FEATURE(CArrayInsert),
 	TEST_FEATURE(CArrayDelete),
-	TEST_FEATURE(CArrayRemoveIf)
+	TEST_FEATURE(CArrayRemoveIf),
+	TEST_FEATURE(CArrayArena)
 )
@@ -0,0 +1,47 @@
+// Microbenchmark for c_hashmap lookups, with keys like the names of pics
+// and sounds; prints lookups/sec for comparing implementations
+#include <stdio.h>
+#include <time.h>
+
+#include <c_hashmap/hashmap.h>
+
+#define NUM_KEYS 5000
+#define LOOKUPS 2000000
+
+static char sKeys[NUM_KEYS][32];
+static int sValues[NUM_KEYS];
+
+int main(void)
+{
+	map_t map = hashmap_new();
+	for (int i = 0; i < NUM_KEYS; i++)
+	{
+		sprintf(sKeys[i], "chars/bodies/body%d/upper", i);
+		sValues[i] = i;
+		hashmap_put(map, sKeys[i], &sValues[i]);
+	}
+
+	int found = 0;
+	int *valueOut;
+	const clock_t start = clock();
+	for (int i = 0; i < LOOKUPS; i++)
+	{
+		found += hashmap_get(
+			map, sKeys[(i * 7) % NUM_KEYS], (void **)&valueOut) == MAP_OK;
+	}
+	const clock_t mid = clock();
+	for (int i = 0; i < LOOKUPS / 4; i++)
+	{
+		found -= hashmap_get(map, "notkey", (void **)&valueOut) == MAP_OK;
+	}
+	const clock_t end = clock();
+	hashmap_free(map);
+
+	const double hitSecs = (double)(mid - start) / CLOCKS_PER_SEC;
+	const double missSecs = (double)(end - mid) / CLOCKS_PER_SEC;
+	printf("%.1f million lookups/sec, %.1f million misses/sec\n",
+		LOOKUPS / 1e6 / (hitSecs > 0 ? hitSecs : 1e-9),
+		LOOKUPS / 4 / 1e6 / (missSecs > 0 ? missSecs : 1e-9));
+	// Keep the lookups from being optimised away
+	return found == LOOKUPS ? 0 : 1;
+}
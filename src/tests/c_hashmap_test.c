@@ -1,5 +1,7 @@
 #include <cbehave/cbehave.h>
 
+#include <stdio.h>
+
 #include <c_hashmap/hashmap.h>
 
 
@@ -21,8 +23,58 @@ FEATURE(hashmap_put, "Hashmap put")
 
 		hashmap_free(map);
 	SCENARIO_END
+
+	SCENARIO("Put a value with an existing key")
+		GIVEN("a hashmap with a value")
+			map_t map = hashmap_new();
+			int value = 42;
+			hashmap_put(map, "somekey", &value);
+
+		WHEN("I put another value with the same key")
+			int value2 = 43;
+			hashmap_put(map, "somekey", &value2);
+
+		THEN("the value should be replaced")
+			int *valueOut;
+			hashmap_get(map, "somekey", (void **)&valueOut);
+			SHOULD_INT_EQUAL(*valueOut, 43);
+		AND("the length should be unchanged")
+			SHOULD_INT_EQUAL(hashmap_length(map), 1);
+
+		hashmap_free(map);
+	SCENARIO_END
 FEATURE_END
 
+// Keys like the names of pics and sounds
+#define NUM_KEYS 5000
+static char sKeys[NUM_KEYS][32];
+static int sValues[NUM_KEYS];
+static map_t NewMapOfKeys(void)
+{
+	map_t map = hashmap_new();
+	for (int i = 0; i < NUM_KEYS; i++)
+	{
+		sprintf(sKeys[i], "chars/bodies/body%d/upper", i);
+		sValues[i] = i;
+		hashmap_put(map, sKeys[i], &sValues[i]);
+	}
+	return map;
+}
+static int CountFound(const map_t map, const int start, const int step)
+{
+	int found = 0;
+	for (int i = start; i < NUM_KEYS; i += step)
+	{
+		int *valueOut;
+		if (hashmap_get(map, sKeys[i], (void **)&valueOut) == MAP_OK &&
+			*valueOut == i)
+		{
+			found++;
+		}
+	}
+	return found;
+}
+
 FEATURE(hashmap_get, "Hashmap get")
 	SCENARIO("Get an existing value")
 		GIVEN("a hashmap with a value")
@@ -57,6 +109,27 @@ FEATURE(hashmap_get, "Hashmap get")
 
 		hashmap_free(map);
 	SCENARIO_END
+
+	SCENARIO("Get many values")
+		GIVEN("a hashmap with many values")
+			map_t map = NewMapOfKeys();
+
+		WHEN("I get them via their keys")
+			const int found = CountFound(map, 0, 1);
+
+		THEN("they should all be found")
+			SHOULD_INT_EQUAL(found, NUM_KEYS);
+			SHOULD_INT_EQUAL(hashmap_length(map), NUM_KEYS);
+		AND("they should be found with their pre-computed hashes too")
+			int *valueOut;
+			const unsigned int hash = hashmap_hash_key(sKeys[123]);
+			SHOULD_INT_EQUAL(
+				hashmap_get_hashed(map, sKeys[123], hash, (void **)&valueOut),
+				(int)MAP_OK);
+			SHOULD_INT_EQUAL(*valueOut, 123);
+
+		hashmap_free(map);
+	SCENARIO_END
 FEATURE_END
 
 FEATURE(hashmap_remove, "Hashmap remove")
@@ -74,11 +147,72 @@ FEATURE(hashmap_remove, "Hashmap remove")
 
 		hashmap_free(map);
 	SCENARIO_END
+
+	SCENARIO("Remove many values")
+		GIVEN("a hashmap with many values")
+			map_t map = NewMapOfKeys();
+
+		WHEN("I remove every third value")
+			for (int i = 0; i < NUM_KEYS; i += 3)
+			{
+				hashmap_remove(map, sKeys[i]);
+			}
+
+		THEN("they should be missing")
+			SHOULD_INT_EQUAL(CountFound(map, 0, 3), 0);
+		AND("the others should still be found")
+			SHOULD_INT_EQUAL(
+				CountFound(map, 1, 3) + CountFound(map, 2, 3),
+				NUM_KEYS - (NUM_KEYS + 2) / 3);
+			SHOULD_INT_EQUAL(hashmap_length(map), NUM_KEYS - (NUM_KEYS + 2) / 3);
+		AND("they should be found after adding them back")
+			for (int i = 0; i < NUM_KEYS; i += 3)
+			{
+				hashmap_put(map, sKeys[i], &sValues[i]);
+			}
+			SHOULD_INT_EQUAL(CountFound(map, 0, 1), NUM_KEYS);
+
+		hashmap_free(map);
+	SCENARIO_END
+FEATURE_END
+
+static int CheckOrder(any_t data, any_t item)
+{
+	int *next = data;
+	const int *value = item;
+	if (*value != *next)
+	{
+		return MAP_MISSING;
+	}
+	*next += 2;
+	return MAP_OK;
+}
+
+FEATURE(hashmap_iterate, "Hashmap iterate")
+	SCENARIO("Iterate in insertion order")
+		GIVEN("a hashmap with many values, some removed")
+			map_t map = NewMapOfKeys();
+			for (int i = 1; i < NUM_KEYS; i += 2)
+			{
+				hashmap_remove(map, sKeys[i]);
+			}
+
+		WHEN("I iterate over it")
+			int next = 0;
+			const int error = hashmap_iterate(map, CheckOrder, &next);
+
+		THEN("the values should be in the order they were added")
+			SHOULD_INT_EQUAL(error, (int)MAP_OK);
+			SHOULD_INT_EQUAL(next, NUM_KEYS);
+
+		hashmap_free(map);
+	SCENARIO_END
 FEATURE_END
 
 CBEHAVE_RUN(
 	"c_hashmap features are:",
 	TEST_FEATURE(hashmap_put),
 	TEST_FEATURE(hashmap_get),
-	TEST_FEATURE(hashmap_remove)
+	TEST_FEATURE(hashmap_remove),
+	TEST_FEATURE(hashmap_iterate)
 )
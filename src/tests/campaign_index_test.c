@@ -0,0 +1,154 @@
+#define SDL_MAIN_HANDLED
+#include <cbehave/cbehave.h>
+
+#include <campaign_index.h>
+#include <json_utils.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <config.h>
+
+
+// Stubs
+// Campaigns are files containing their title; the number of missions is
+// the length of the title, and files starting with "x" aren't campaigns
+static int sScans = 0;
+int MapNewScan(const char *filename, char **title, int *numMissions)
+{
+	sScans++;
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+	{
+		return -1;
+	}
+	char buf[256];
+	const bool ok = fgets(buf, sizeof buf, f) != NULL && buf[0] != 'x';
+	fclose(f);
+	if (!ok)
+	{
+		return -1;
+	}
+	CSTRDUP(*title, buf);
+	*numMissions = (int)strlen(buf);
+	return 0;
+}
+Mix_Chunk *StrSound(const char *s)
+{
+	UNUSED(s);
+	return NULL;
+}
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+bool ConfigGetBool(Config *c, const char *name)
+{
+	UNUSED(c);
+	UNUSED(name);
+	return false;
+}
+int PicManagerGetPic(void) { return 0; }
+int StrGunDescription(void) { return 0; }
+Config gConfig;
+int gPicManager;
+
+#define INDEX_FILE "campaign_index_test.json"
+
+static void WriteFile(const char *filename, const char *contents)
+{
+	FILE *f = fopen(filename, "w");
+	fputs(contents, f);
+	fclose(f);
+}
+// Scan the campaigns using the saved index, as on each startup; return
+// the number of files that had to be scanned
+static int ScanAll(
+	const char **paths, const int n, char titles[][256], int *numMissions)
+{
+	const int scans = sScans;
+	CampaignIndex ci;
+	CampaignIndexLoad(&ci, INDEX_FILE);
+	for (int i = 0; i < n; i++)
+	{
+		char *title;
+		strcpy(titles[i], "");
+		numMissions[i] = -1;
+		if (CampaignIndexScan(&ci, paths[i], &title, &numMissions[i]))
+		{
+			strcpy(titles[i], title);
+			CFREE(title);
+		}
+	}
+	CampaignIndexSave(&ci, INDEX_FILE);
+	CampaignIndexTerminate(&ci);
+	return sScans - scans;
+}
+
+
+FEATURE(campaign_index, "Campaign index")
+	SCENARIO("Unchanged campaigns aren't scanned again")
+		GIVEN("some campaigns and a file that isn't one")
+			remove(INDEX_FILE);
+			const char *paths[] =
+			{
+				"campaign_index_test_a", "campaign_index_test_b",
+				"campaign_index_test_x"
+			};
+			WriteFile(paths[0], "Alpha");
+			WriteFile(paths[1], "Bravo campaign");
+			WriteFile(paths[2], "x not a campaign");
+		AND("they have been scanned before")
+			char titles[3][256];
+			int numMissions[3];
+			SHOULD_INT_EQUAL(ScanAll(paths, 3, titles, numMissions), 3);
+
+		WHEN("I scan them again")
+			char titles2[3][256];
+			int numMissions2[3];
+			const int scans = ScanAll(paths, 3, titles2, numMissions2);
+
+		THEN("none of them should be scanned")
+			SHOULD_INT_EQUAL(scans, 0);
+		AND("the titles and missions should be the same as before")
+			for (int i = 0; i < 3; i++)
+			{
+				SHOULD_STR_EQUAL(titles2[i], titles[i]);
+				SHOULD_INT_EQUAL(numMissions2[i], numMissions[i]);
+			}
+			SHOULD_STR_EQUAL(titles2[1], "Bravo campaign");
+			SHOULD_INT_EQUAL(numMissions2[2], -1);
+	SCENARIO_END
+
+	SCENARIO("Changed campaigns are scanned again")
+		GIVEN("some campaigns that have been scanned before")
+			remove(INDEX_FILE);
+			const char *paths[] =
+			{
+				"campaign_index_test_a", "campaign_index_test_b"
+			};
+			WriteFile(paths[0], "Alpha");
+			WriteFile(paths[1], "Bravo");
+			char titles[2][256];
+			int numMissions[2];
+			ScanAll(paths, 2, titles, numMissions);
+		AND("one of them is changed")
+			WriteFile(paths[1], "Bravo campaign");
+
+		WHEN("I scan them again")
+			const int scans = ScanAll(paths, 2, titles, numMissions);
+
+		THEN("only the changed one should be scanned")
+			SHOULD_INT_EQUAL(scans, 1);
+		AND("it should have the new title and missions")
+			SHOULD_STR_EQUAL(titles[1], "Bravo campaign");
+			SHOULD_INT_EQUAL(numMissions[1], 14);
+			remove(paths[0]);
+			remove(paths[1]);
+			remove("campaign_index_test_x");
+			remove(INDEX_FILE);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Campaign index features are:", TEST_FEATURE(campaign_index))
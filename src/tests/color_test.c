@@ -1,8 +1,17 @@
 #include <cbehave/cbehave.h>
 
 #include <color.h>
+#include <utils.h>
 
 #include <float.h>
+#include <string.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
 
 
 FEATURE(ColorMult, "Multiply")
@@ -195,6 +204,40 @@ FEATURE(ColorTint, "Tint")
 		THEN("the result should be the same as the original color")
 			SHOULD_MEM_EQUAL(&result, &c, sizeof result);
 	SCENARIO_END
+
+	SCENARIO("Tint with lookup tables")
+		GIVEN("hue, grey and saturation tints")
+			const HSV tints[] =
+			{
+				{ 0.0, 1.0, 1.0 }, { 200.0, 0.5, 0.5 }, { 0.0, 0.0, 1.2 },
+				{ -1.0, 1.0, 1.0 }, { -1.0, 0.33, 2.0 }, { -1.0, 0.7, 0.75 }
+			};
+
+		WHEN("I tint every grey and many other colours with their tables")
+			int mismatches = 0;
+			for (int i = 0; i < (int)(sizeof tints / sizeof tints[0]); i++)
+			{
+				ColorTintLUT lut;
+				ColorTintLUTInit(&lut, tints[i]);
+				for (int j = 0; j < 256 * 256; j++)
+				{
+					const color_t c =
+					{
+						(uint8_t)j, (uint8_t)(j >> 8), (uint8_t)(j * 7), 255
+					};
+					const color_t expected = ColorTint(c, tints[i]);
+					const color_t result = ColorTintLUTApply(&lut, c);
+					if (memcmp(&expected, &result, sizeof result) != 0)
+					{
+						mismatches++;
+					}
+				}
+				ColorTintLUTTerminate(&lut);
+			}
+
+		THEN("the results should be the same as tinting each colour")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
 FEATURE_END
 
 FEATURE(StrColor, "String conversion")
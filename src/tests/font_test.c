@@ -0,0 +1,172 @@
+#include <cbehave/cbehave.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <blit.h>
+#include <font.h>
+#include <grafx.h>
+#include <pic.h>
+
+// Stubs
+GraphicsDevice gGraphicsDevice;
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+#define SCREEN_W 160
+#define SCREEN_H 120
+
+// Random glyphs like a proportional font's: varying widths, with empty,
+// faint and opaque pixels, and overlapping by the font's gap
+static void RandomFont(void)
+{
+	memset(&gFont, 0, sizeof gFont);
+	gFont.Size = Vec2iNew(8, 8);
+	gFont.Gap = Vec2iNew(-1, 1);
+	CArrayInit(&gFont.Chars, sizeof(Pic));
+	for (int i = 0; i < 256; i++)
+	{
+		Pic p;
+		memset(&p, 0, sizeof p);
+		p.size = Vec2iNew(1 + rand() % 8, gFont.Size.y);
+		p.Data = malloc(p.size.x * p.size.y * sizeof *p.Data);
+		for (int j = 0; j < p.size.x * p.size.y; j++)
+		{
+			const int r = rand() % 4;
+			const Uint32 a = r == 0 ? 0 : r == 1 ? (Uint32)(rand() % 4) : 0xFF;
+			p.Data[j] = (a << 24) | ((Uint32)rand() & 0xFFFFFF);
+		}
+		PicUpdateSpans(&p);
+		CArrayPushBack(&gFont.Chars, &p);
+	}
+}
+static void RandomStr(char *s, const int len)
+{
+	static const char chars[] = "abcdefgHIJKLM0123456789:!  \n";
+	for (int i = 0; i < len; i++)
+	{
+		s[i] = chars[rand() % (sizeof chars - 1)];
+	}
+	s[len] = '\0';
+}
+
+// Reference: each glyph masked in turn
+static Vec2i RefStrMask(const char *s, Vec2i pos, const color_t mask)
+{
+	const int left = pos.x;
+	for (; *s; s++)
+	{
+		if (*s == '\n')
+		{
+			pos = Vec2iNew(left, pos.y + FontH());
+			continue;
+		}
+		const Pic *pic = CArrayGet(&gFont.Chars, (Uint8)*s);
+		BlitMasked(&gGraphicsDevice, pic, pos, mask, true);
+		pos.x += pic->size.x + gFont.Gap.x;
+	}
+	return pos;
+}
+
+// Draw random strings, each a few times so that they get cached, both
+// ways; count pixels and cursor positions that differ
+static int CompareStrs(const bool isChanging, const int wrapWidth)
+{
+	Uint32 expected[SCREEN_W * SCREEN_H];
+	Uint32 actual[SCREEN_W * SCREEN_H];
+	int mismatches = 0;
+	char s[40];
+	RandomStr(s, 1 + rand() % 39);
+	for (int i = 0; i < 300; i++)
+	{
+		if (isChanging || i % 3 == 0)
+		{
+			RandomStr(s, 1 + rand() % 39);
+		}
+		for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+		{
+			expected[j] = actual[j] = (Uint32)rand();
+		}
+		gGraphicsDevice.clipping.left = rand() % 8;
+		gGraphicsDevice.clipping.top = rand() % 8;
+		gGraphicsDevice.clipping.right = SCREEN_W - 1 - rand() % 8;
+		gGraphicsDevice.clipping.bottom = SCREEN_H - 1 - rand() % 8;
+		const Vec2i pos = Vec2iNew(
+			rand() % SCREEN_W - 40, rand() % SCREEN_H - 20);
+		const color_t mask = {
+			(Uint8)rand(), (Uint8)rand(), (Uint8)rand(), 255
+		};
+
+		gGraphicsDevice.buf = expected;
+		Vec2i expectedEnd;
+		if (wrapWidth > 0)
+		{
+			char wrapped[100];
+			FontSplitLines(s, wrapped, wrapWidth);
+			expectedEnd = RefStrMask(wrapped, pos, mask);
+		}
+		else
+		{
+			expectedEnd = RefStrMask(s, pos, mask);
+		}
+		gGraphicsDevice.buf = actual;
+		const Vec2i actualEnd = wrapWidth > 0 ?
+			FontStrMaskWrap(s, pos, mask, wrapWidth) :
+			FontStrMask(s, pos, mask);
+
+		if (!Vec2iEqual(expectedEnd, actualEnd))
+		{
+			mismatches++;
+		}
+		for (int j = 0; j < SCREEN_W * SCREEN_H; j++)
+		{
+			if (expected[j] != actual[j])
+			{
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+static void SetupDevice(void)
+{
+	gGraphicsDevice.Format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+	gGraphicsDevice.cachedConfig.Res = Vec2iNew(SCREEN_W, SCREEN_H);
+}
+
+
+FEATURE(font_runs, "Cached text runs")
+	SCENARIO("Cached runs draw like their glyphs")
+		GIVEN("a font and strings drawn repeatedly")
+			srand(1);
+			SetupDevice();
+			RandomFont();
+		WHEN("I draw them glyph by glyph, and with the font")
+			const int mismatches = CompareStrs(false, 0);
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+		AND("wrapped strings should be identical too")
+			SHOULD_INT_EQUAL(CompareStrs(false, 60), 0);
+			FontTerminate(&gFont);
+			SDL_FreeFormat(gGraphicsDevice.Format);
+	SCENARIO_END
+
+	SCENARIO("Text that changes is redrawn")
+		GIVEN("a font and strings that change every frame")
+			srand(2);
+			SetupDevice();
+			RandomFont();
+		WHEN("I draw them glyph by glyph, and with the font")
+			const int mismatches = CompareStrs(true, 0);
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+			FontTerminate(&gFont);
+			SDL_FreeFormat(gGraphicsDevice.Format);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Font features are:", TEST_FEATURE(font_runs))
@@ -1,6 +1,8 @@
 #define SDL_MAIN_HANDLED
 #include <cbehave/cbehave.h>
 
+#include <limits.h>
+
 #include <json_utils.h>
 
 #include <config.h>
@@ -54,4 +56,127 @@ FEATURE(json_format_string, "String format")
 	SCENARIO_END
 FEATURE_END
 
-CBEHAVE_RUN("JSON features are:", TEST_FEATURE(json_format_string))
+// Parse with the incremental parser, which builds the tree node by node
+static json_t *ParseFragment(const char *text)
+{
+	struct json_parsing_info jpi;
+	json_jpi_init(&jpi);
+	const enum json_error e = json_parse_fragment(&jpi, text);
+	return e == JSON_OK || e == JSON_WAITING_FOR_EOF ? jpi.cursor : NULL;
+}
+
+FEATURE(json_parse_document, "Document parsing")
+	SCENARIO("Same tree as the incremental parser")
+		GIVEN("a JSON document with all kinds of values")
+			const char *doc =
+				"{\n"
+				"\t\"Name\": \"Quote \\\" and \\u00e9\",\n"
+				"\t\"Ints\": [0, -7, 42],\n"
+				"\t\"Double\": -1.5e2,\n"
+				"\t\"Nested\": {\"A\": [[], {}], \"B\": [true, false, null]}\n"
+				"}\n";
+
+		WHEN("I parse it")
+			json_t *root = NULL;
+			const enum json_error e = json_parse_document(&root, doc);
+
+		THEN("it should be parsed")
+			SHOULD_INT_EQUAL((int)e, (int)JSON_OK);
+		AND("be the same as parsed incrementally")
+			json_t *expected = ParseFragment(doc);
+			char *text;
+			char *expectedText;
+			json_tree_to_string(root, &text);
+			json_tree_to_string(expected, &expectedText);
+			SHOULD_STR_EQUAL(text, expectedText);
+		AND("have its numbers converted")
+			double d = 0;
+			LoadDouble(&d, root, "Double");
+			SHOULD_BE_TRUE(d == -150.0);
+			json_t *ints = json_find_first_label(root, "Ints")->child;
+			SHOULD_BE_TRUE(ints->child->next->number == -7.0);
+			CFREE(text);
+			CFREE(expectedText);
+			json_free_value(&root);
+			json_free_value(&expected);
+	SCENARIO_END
+
+	SCENARIO("Looking up members of wide objects")
+		GIVEN("an object with many members, and a repeated label")
+			char doc[1024] = "{\"Dup\": 1";
+			for (int i = 0; i < 20; i++)
+			{
+				sprintf(doc + strlen(doc), ", \"Member%d\": %d", i, i);
+			}
+			strcat(doc, ", \"Dup\": 2}");
+			json_t *root = NULL;
+			json_parse_document(&root, doc);
+
+		WHEN("I look up its members")
+			int value = -1;
+			LoadInt(&value, root, "Member13");
+			int dup = -1;
+			LoadInt(&dup, root, "Dup");
+
+		THEN("they should be found")
+			SHOULD_INT_EQUAL(value, 13);
+		AND("the first of the repeated labels should be found")
+			SHOULD_INT_EQUAL(dup, 1);
+		AND("missing labels should not be found")
+			SHOULD_BE_TRUE(json_find_first_label(root, "Member20") == NULL);
+		AND("members added later should be found too")
+			AddIntPair(root, "Added", 99);
+			LoadInt(&value, root, "Added");
+			SHOULD_INT_EQUAL(value, 99);
+			json_free_value(&root);
+	SCENARIO_END
+
+	SCENARIO("Loading integers")
+		GIVEN("numbers that are out of range or not plain integers")
+			json_t *root = NULL;
+			json_parse_document(&root,
+				"{\"Big\": 99999999999, \"Small\": -99999999999,"
+				" \"Exp\": 1e3, \"Frac\": 2.75}");
+
+		WHEN("I load them as integers")
+			int big = 0, small = 0, withExp = 0, frac = 0;
+			LoadInt(&big, root, "Big");
+			LoadInt(&small, root, "Small");
+			LoadInt(&withExp, root, "Exp");
+			LoadInt(&frac, root, "Frac");
+
+		THEN("out of range numbers should be clamped")
+			SHOULD_INT_EQUAL(big, INT_MAX);
+			SHOULD_INT_EQUAL(small, INT_MIN);
+		AND("other numbers should be read as before")
+			SHOULD_INT_EQUAL(withExp, 1);
+			SHOULD_INT_EQUAL(frac, 2);
+			json_free_value(&root);
+	SCENARIO_END
+
+	SCENARIO("Malformed documents")
+		GIVEN("documents with syntax errors")
+			const char *docs[] =
+			{
+				"{\"A\": [1, 2,]}", "{\"A\": 01}", "{\"A\" 1}",
+				"{\"A\": \"\\x\"}", "{\"A\": 1} 2", "{\"A\": [1, 2"
+			};
+
+		WHEN("I parse them")
+			int parsed = 0;
+			for (int i = 0; i < 6; i++)
+			{
+				json_t *root = NULL;
+				if (json_parse_document(&root, docs[i]) == JSON_OK || root)
+				{
+					parsed++;
+				}
+			}
+
+		THEN("none of them should be parsed")
+			SHOULD_INT_EQUAL(parsed, 0);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("JSON features are:",
+	TEST_FEATURE(json_format_string), TEST_FEATURE(json_parse_document))
@@ -0,0 +1,155 @@
+#include <cbehave/cbehave.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map_pack.h>
+#include <sys_config.h>
+#include <sys_specifics.h>
+
+#include <SDL_endian.h>
+#include <SDL_joystick.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+#define DIR_NAME "map_pack_test.cdogscpn"
+#define PACK_NAME "map_pack_test.cdogspak"
+
+static void WriteFile(const char *name, const void *data, const size_t size)
+{
+	char path[CDOGS_PATH_MAX];
+	sprintf(path, "%s/%s", DIR_NAME, name);
+	FILE *f = fopen(path, "wb");
+	fwrite(data, 1, size, f);
+	fclose(f);
+}
+// A small campaign: JSON at the top, pics and sounds in subdirectories
+static void MakeCampaign(void)
+{
+	mkdir(DIR_NAME, MKDIR_MODE);
+	mkdir(DIR_NAME "/graphics", MKDIR_MODE);
+	mkdir(DIR_NAME "/sounds", MKDIR_MODE);
+	WriteFile("campaign.json", "{\"Version\": 14}", 15);
+	WriteFile("missions.json", "{}", 2);
+	WriteFile(".hidden", "x", 1);
+	Uint8 data[1000];
+	for (int i = 0; i < (int)sizeof data; i++)
+	{
+		data[i] = (Uint8)(i * 7);
+	}
+	WriteFile("graphics/pic.png", data, sizeof data);
+	WriteFile("sounds/0.wav", data, 10);
+}
+static void RemoveCampaign(void)
+{
+	remove(DIR_NAME "/campaign.json");
+	remove(DIR_NAME "/missions.json");
+	remove(DIR_NAME "/.hidden");
+	remove(DIR_NAME "/graphics/pic.png");
+	remove(DIR_NAME "/sounds/0.wav");
+	remove(DIR_NAME "/graphics");
+	remove(DIR_NAME "/sounds");
+	remove(DIR_NAME);
+	remove(PACK_NAME);
+}
+// Flip a byte in the pack, at the same offset as in the data
+static void CorruptPack(const Uint8 *packData, const Uint8 *member)
+{
+	FILE *f = fopen(PACK_NAME, "r+b");
+	fseek(f, (long)(member - packData), SEEK_SET);
+	const Uint8 c = (Uint8)(*member ^ 0xFF);
+	fwrite(&c, 1, 1, f);
+	fclose(f);
+}
+// A pack with one empty member, with a name of the given length
+static void WriteLongNamePack(const Uint32 nameLen)
+{
+	FILE *f = fopen(PACK_NAME, "wb");
+	fwrite("CDOGSPAK", 8, 1, f);
+	const Uint32 header[] = { SDL_SwapLE32(1), SDL_SwapLE32(1) };
+	fwrite(header, sizeof header, 1, f);
+	const Uint64 offsetAndSize[] = { 0, 0 };
+	fwrite(offsetAndSize, sizeof offsetAndSize, 1, f);
+	const Uint32 checksumAndLen[] = { 0, SDL_SwapLE32(nameLen) };
+	fwrite(checksumAndLen, sizeof checksumAndLen, 1, f);
+	for (Uint32 i = 0; i + 1 < nameLen; i++)
+	{
+		fputc('a', f);
+	}
+	fputc('\0', f);
+	fclose(f);
+}
+
+
+FEATURE(map_pack, "Packed campaigns")
+	SCENARIO("Pack and read a campaign")
+		GIVEN("a campaign directory")
+			MakeCampaign();
+		WHEN("I pack it and open the pack")
+			SHOULD_BE_TRUE(MapPackCreate(PACK_NAME, DIR_NAME));
+			SHOULD_BE_TRUE(MapPackIsPack(PACK_NAME));
+			MapPack *p = MapPackOpen(PACK_NAME);
+		THEN("it should have the campaign's files, except hidden ones")
+			SHOULD_BE_TRUE(p != NULL);
+			SHOULD_INT_EQUAL((int)p->Members.size, 4);
+			SHOULD_BE_FALSE(MapPackHas(p, ".hidden"));
+		AND("their data should be the same")
+			size_t size;
+			const char *json = MapPackGet(p, "campaign.json", &size);
+			SHOULD_INT_EQUAL((int)size, 15);
+			SHOULD_BE_TRUE(memcmp(json, "{\"Version\": 14}", 15) == 0);
+			const Uint8 *pic = MapPackGet(p, "graphics/pic.png", &size);
+			SHOULD_INT_EQUAL((int)size, 1000);
+			SHOULD_INT_EQUAL(pic[999], (Uint8)(999 * 7));
+			SHOULD_BE_TRUE(MapPackHas(p, "sounds/0.wav"));
+		AND("missing files should not be found")
+			SHOULD_BE_TRUE(MapPackGet(p, "graphics", &size) == NULL);
+			SHOULD_BE_TRUE(MapPackGet(p, "guns.json", &size) == NULL);
+			MapPackUnref(p);
+			RemoveCampaign();
+	SCENARIO_END
+
+	SCENARIO("Corrupt members are rejected")
+		GIVEN("a pack with a corrupted member")
+			MakeCampaign();
+			MapPackCreate(PACK_NAME, DIR_NAME);
+			MapPack *p = MapPackOpen(PACK_NAME);
+			size_t size;
+			const Uint8 *pic = MapPackGet(p, "graphics/pic.png", &size);
+			CorruptPack(p->File.Data, pic + 500);
+			MapPackUnref(p);
+		WHEN("I open the pack again")
+			p = MapPackOpen(PACK_NAME);
+		THEN("the corrupted member should not be returned")
+			SHOULD_BE_TRUE(p != NULL);
+			SHOULD_BE_TRUE(MapPackGet(p, "graphics/pic.png", &size) == NULL);
+		AND("the other members should still be returned")
+			SHOULD_BE_TRUE(MapPackGet(p, "campaign.json", &size) != NULL);
+			MapPackUnref(p);
+			RemoveCampaign();
+	SCENARIO_END
+
+	SCENARIO("Overlong member names are rejected")
+		GIVEN("a pack with a member name longer than a path")
+			WriteLongNamePack(CDOGS_PATH_MAX + 1);
+		WHEN("I open the pack")
+			MapPack *p = MapPackOpen(PACK_NAME);
+		THEN("it should not be opened")
+			SHOULD_BE_TRUE(p == NULL);
+		AND("names that fit should be accepted")
+			WriteLongNamePack(CDOGS_PATH_MAX);
+			p = MapPackOpen(PACK_NAME);
+			SHOULD_BE_TRUE(p != NULL);
+			MapPackUnref(p);
+			remove(PACK_NAME);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Map pack features are:", TEST_FEATURE(map_pack))
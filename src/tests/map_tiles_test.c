@@ -0,0 +1,87 @@
+#include <cbehave/cbehave.h>
+
+#include <stdlib.h>
+
+#include <map_tiles.h>
+
+#include <SDL_joystick.h>
+
+#include <utils.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+// Tiles like a static map's: long runs of floor and wall, with some
+// single tiles of all values
+static void RandomTiles(CArray *tiles, const int count)
+{
+	CArrayInit(tiles, sizeof(unsigned short));
+	while ((int)tiles->size < count)
+	{
+		const unsigned short tile = rand() % 4 == 0 ?
+			(unsigned short)rand() : (unsigned short)(rand() % 4);
+		const int run = rand() % 2 == 0 ? 1 : rand() % 300;
+		for (int i = 0; i < run && (int)tiles->size < count; i++)
+		{
+			CArrayPushBack(tiles, &tile);
+		}
+	}
+}
+
+
+FEATURE(map_tiles, "Map tiles encoding")
+	SCENARIO("Encoding and decoding")
+		GIVEN("some map tiles")
+			srand(1);
+			CArray tiles;
+			RandomTiles(&tiles, 64 * 48);
+
+		WHEN("I encode and decode them")
+			char *s = MapTilesEncode(&tiles);
+			CArray decoded;
+			CArrayInit(&decoded, sizeof(unsigned short));
+			const bool ok = MapTilesDecode(&decoded, s, 64 * 48);
+
+		THEN("they should be decoded")
+			SHOULD_BE_TRUE(ok);
+		AND("be the same tiles")
+			SHOULD_INT_EQUAL((int)decoded.size, (int)tiles.size);
+			SHOULD_MEM_EQUAL(
+				decoded.data, tiles.data, tiles.size * tiles.elemSize);
+			CFREE(s);
+			CArrayTerminate(&tiles);
+			CArrayTerminate(&decoded);
+	SCENARIO_END
+
+	SCENARIO("Invalid tiles")
+		GIVEN("encoded tiles")
+			srand(2);
+			CArray tiles;
+			RandomTiles(&tiles, 100);
+			char *s = MapTilesEncode(&tiles);
+
+		WHEN("I decode them as the wrong number of tiles")
+			CArray decoded;
+			CArrayInit(&decoded, sizeof(unsigned short));
+			const bool tooFew = MapTilesDecode(&decoded, s, 99);
+			const bool tooMany = MapTilesDecode(&decoded, s, 101);
+
+		THEN("they should not be decoded")
+			SHOULD_BE_FALSE(tooFew);
+			SHOULD_BE_FALSE(tooMany);
+		AND("corrupt text should not be decoded either")
+			s[1] = '*';
+			SHOULD_BE_FALSE(MapTilesDecode(&decoded, s, 100));
+			SHOULD_BE_FALSE(MapTilesDecode(&decoded, "AQ", 1));
+			SHOULD_INT_EQUAL((int)decoded.size, 0);
+			CFREE(s);
+			CArrayTerminate(&tiles);
+			CArrayTerminate(&decoded);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Map tiles features are:", TEST_FEATURE(map_tiles))
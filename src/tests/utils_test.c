@@ -47,4 +47,72 @@ FEATURE(path_funcs, "Path functions")
 	SCENARIO_END
 FEATURE_END
 
-CBEHAVE_RUN("Pic features are:", TEST_FEATURE(path_funcs))
+#define REPLACE_FILE "utils_test_replace.txt"
+static bool WriteReplacement(const char *text, const bool ok)
+{
+	FILE *f = FileReplaceOpen(REPLACE_FILE, "w");
+	fputs(text, f);
+	return FileReplaceClose(f, REPLACE_FILE, ok);
+}
+static bool ReadsAs(const char *text)
+{
+	FileData d;
+	if (!FileDataLoad(&d, REPLACE_FILE, false))
+	{
+		return false;
+	}
+	const bool same =
+		d.Size == strlen(text) && memcmp(d.Data, text, d.Size) == 0;
+	FileDataTerminate(&d);
+	return same;
+}
+
+FEATURE(file_funcs, "File functions")
+	SCENARIO("Replace a file")
+		GIVEN("a file")
+			SHOULD_BE_TRUE(WriteReplacement("old", true));
+
+		WHEN("I replace it")
+			const bool replaced = WriteReplacement("new text", true);
+
+		THEN("it should have the new contents")
+			SHOULD_BE_TRUE(replaced);
+			SHOULD_BE_TRUE(ReadsAs("new text"));
+		AND("the temporary file should be gone")
+			SHOULD_BE_TRUE(fopen(REPLACE_FILE ".tmp", "r") == NULL);
+	SCENARIO_END
+
+	SCENARIO("Failed writes leave the file alone")
+		GIVEN("a file")
+			WriteReplacement("old", true);
+
+		WHEN("I fail to write its replacement")
+			const bool replaced = WriteReplacement("partial", false);
+
+		THEN("it should keep the old contents")
+			SHOULD_BE_FALSE(replaced);
+			SHOULD_BE_TRUE(ReadsAs("old"));
+		AND("the temporary file should be gone")
+			SHOULD_BE_TRUE(fopen(REPLACE_FILE ".tmp", "r") == NULL);
+			remove(REPLACE_FILE);
+	SCENARIO_END
+
+	SCENARIO("Read past the end")
+		GIVEN("a reader over some data")
+			uint8_t data[6] = { 1, 2, 3, 4, 5, 6 };
+			DataReader r = { data, sizeof data, 0 };
+
+		WHEN("I read more than is left")
+			uint8_t out[4];
+			const bool first = DataReaderRead(&r, out, sizeof out);
+			const bool second = DataReaderRead(&r, out, sizeof out);
+
+		THEN("only the reads that fit should succeed")
+			SHOULD_BE_TRUE(first);
+			SHOULD_BE_FALSE(second);
+			SHOULD_INT_EQUAL((int)r.Pos, 4);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Pic features are:",
+	TEST_FEATURE(path_funcs), TEST_FEATURE(file_funcs))
@@ -0,0 +1,242 @@
+#include <cbehave/cbehave.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <tile.h>
+#include <utils.h>
+#include <wall_collision.h>
+
+// Stubs
+const char *JoyName(const int deviceIndex)
+{
+	UNUSED(deviceIndex);
+	return NULL;
+}
+
+// Reference implementations: the original per-pixel checks
+static bool RefHitWall(const WallPlane *w, const int x, const int y)
+{
+	const Vec2i t = Vec2iNew(x / TILE_WIDTH, y / TILE_HEIGHT);
+	return (w->Bits[t.y * w->Stride + t.x / 32] >> (t.x % 32)) & 1;
+}
+static bool RefCollideBox(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize)
+{
+	Vec2i size = Vec2iScaleDiv(fullSize, 2);
+	if (pos.x - size.x < 0 ||
+		pos.y - size.y < 0 ||
+		pos.x + size.x >= w->Size.x * TILE_WIDTH ||
+		pos.y + size.y >= w->Size.y * TILE_HEIGHT)
+	{
+		return true;
+	}
+	return
+		RefHitWall(w, pos.x - size.x, pos.y - size.y) ||
+		RefHitWall(w, pos.x - size.x, pos.y) ||
+		RefHitWall(w, pos.x - size.x, pos.y + size.y) ||
+		RefHitWall(w, pos.x, pos.y + size.y) ||
+		RefHitWall(w, pos.x + size.x, pos.y + size.y) ||
+		RefHitWall(w, pos.x + size.x, pos.y) ||
+		RefHitWall(w, pos.x + size.x, pos.y - size.y) ||
+		RefHitWall(w, pos.x, pos.y - size.y);
+}
+static bool RefCollideDiamond(
+	const WallPlane *w, const Vec2i pos, const Vec2i fullSize)
+{
+	const Vec2i size = Vec2iScaleDiv(fullSize, 2);
+	if (pos.x - size.x < 0 || pos.x + size.x >= w->Size.x * TILE_WIDTH ||
+		pos.y - size.y < 0 || pos.y + size.y >= w->Size.y * TILE_HEIGHT)
+	{
+		return true;
+	}
+	const double gradient = (double)size.y / size.x;
+	for (int i = 0; i < size.x; i++)
+	{
+		const int y = (int)Round((-size.x + i)* gradient);
+		if (RefHitWall(w, pos.x + i, pos.y + y)) return true;
+	}
+	for (int i = 0; i < size.x; i++)
+	{
+		const int y = (int)Round(i * gradient);
+		if (RefHitWall(w, pos.x + size.x - i, pos.y + y)) return true;
+	}
+	for (int i = 0; i < size.x; i++)
+	{
+		const int y = (int)Round((size.x - i) * gradient);
+		if (RefHitWall(w, pos.x - i, pos.y + y)) return true;
+	}
+	for (int i = 0; i < size.x; i++)
+	{
+		const int y = (int)Round(-i * gradient);
+		if (RefHitWall(w, pos.x - size.x + i, pos.y + y)) return true;
+	}
+	return false;
+}
+
+static uint32_t *RandomPlane(WallPlane *w, const Vec2i size, const int wallPct)
+{
+	w->Size = size;
+	w->Stride = (size.x + 31) / 32;
+	uint32_t *bits = calloc(w->Stride * size.y, sizeof *bits);
+	for (int y = 0; y < size.y; y++)
+	{
+		for (int x = 0; x < size.x; x++)
+		{
+			if (rand() % 100 < wallPct)
+			{
+				bits[y * w->Stride + x / 32] |= 1u << (x % 32);
+			}
+		}
+	}
+	w->Bits = bits;
+	return bits;
+}
+static Vec2i RandomPos(const WallPlane *w)
+{
+	// Include positions slightly outside the map
+	return Vec2iNew(
+		rand() % (w->Size.x * TILE_WIDTH + 40) - 20,
+		rand() % (w->Size.y * TILE_HEIGHT + 40) - 20);
+}
+
+// Reference: find every tile boundary crossing on the segment, and test
+// the tile in the middle of each interval between crossings
+static int CompareDouble(const void *a, const void *b)
+{
+	const double da = *(const double *)a, db = *(const double *)b;
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+static bool RefRaycast(
+	const WallPlane *w, const Vec2i from, const Vec2i to, Vec2i *hitTile)
+{
+	const Vec2i start = Vec2iNew(from.x / TILE_WIDTH, from.y / TILE_HEIGHT);
+	const double fx = from.x + 0.5, fy = from.y + 0.5;
+	const int dx = to.x - from.x, dy = to.y - from.y;
+	double ts[64];
+	int n = 0;
+	ts[n++] = 0;
+	ts[n++] = 1;
+	for (int x = -TILE_WIDTH * 8; x < w->Size.x * TILE_WIDTH * 2; x += TILE_WIDTH)
+	{
+		const double t = dx != 0 ? (x - fx) / dx : -1;
+		if (t > 0 && t < 1) ts[n++] = t;
+	}
+	for (int y = -TILE_HEIGHT * 8; y < w->Size.y * TILE_HEIGHT * 2; y += TILE_HEIGHT)
+	{
+		const double t = dy != 0 ? (y - fy) / dy : -1;
+		if (t > 0 && t < 1) ts[n++] = t;
+	}
+	qsort(ts, n, sizeof ts[0], CompareDouble);
+	for (int i = 0; i + 1 < n; i++)
+	{
+		// Skip intervals that only touch a corner
+		if (ts[i + 1] - ts[i] < 1e-9) continue;
+		const double t = (ts[i] + ts[i + 1]) / 2;
+		const Vec2i tile = Vec2iNew(
+			(int)floor((fx + t * dx) / TILE_WIDTH),
+			(int)floor((fy + t * dy) / TILE_HEIGHT));
+		if (tile.x < 0 || tile.x >= w->Size.x ||
+			tile.y < 0 || tile.y >= w->Size.y)
+		{
+			return false;
+		}
+		if (Vec2iEqual(tile, start)) continue;
+		if ((w->Bits[tile.y * w->Stride + tile.x / 32] >> (tile.x % 32)) & 1)
+		{
+			*hitTile = tile;
+			return true;
+		}
+	}
+	return false;
+}
+
+FEATURE(wall_collision, "Wall collision")
+	SCENARIO("Box collision matches per-point checks")
+		GIVEN("random wall planes")
+			srand(1);
+		WHEN("I check random boxes against them")
+			int mismatches = 0;
+			for (int m = 0; m < 20; m++)
+			{
+				WallPlane w;
+				uint32_t *bits = RandomPlane(
+					&w, Vec2iNew(1 + rand() % 70, 1 + rand() % 40), m * 5);
+				for (int i = 0; i < 5000; i++)
+				{
+					const Vec2i pos = RandomPos(&w);
+					const Vec2i size = Vec2iNew(rand() % 48, rand() % 48);
+					if (WallPlaneCollideBox(&w, pos, size) !=
+						RefCollideBox(&w, pos, size))
+					{
+						mismatches++;
+					}
+				}
+				free(bits);
+			}
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("Diamond collision matches per-pixel checks")
+		GIVEN("random wall planes")
+			srand(2);
+		WHEN("I check random diamonds against them")
+			int mismatches = 0;
+			for (int m = 0; m < 20; m++)
+			{
+				WallPlane w;
+				uint32_t *bits = RandomPlane(
+					&w, Vec2iNew(1 + rand() % 70, 1 + rand() % 40), m * 5);
+				for (int i = 0; i < 5000; i++)
+				{
+					const Vec2i pos = RandomPos(&w);
+					const int sx = rand() % 64;
+					const Vec2i size = Vec2iNew(sx, rand() % (sx + 1));
+					if (WallPlaneCollideDiamond(&w, pos, size) !=
+						RefCollideDiamond(&w, pos, size))
+					{
+						mismatches++;
+					}
+				}
+				free(bits);
+			}
+		THEN("the results should be identical")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+
+	SCENARIO("Raycast finds the first blocking tile on a segment")
+		GIVEN("random wall planes")
+			srand(3);
+		WHEN("I cast random segments through them")
+			int mismatches = 0;
+			for (int m = 0; m < 20; m++)
+			{
+				WallPlane w;
+				uint32_t *bits = RandomPlane(
+					&w, Vec2iNew(1 + rand() % 70, 1 + rand() % 40), m * 2);
+				for (int i = 0; i < 2000; i++)
+				{
+					const Vec2i from = Vec2iNew(
+						rand() % (w.Size.x * TILE_WIDTH),
+						rand() % (w.Size.y * TILE_HEIGHT));
+					const Vec2i to = Vec2iAdd(
+						from, Vec2iNew(rand() % 161 - 80, rand() % 161 - 80));
+					Vec2i hit, refTile;
+					const bool isHit = WallPlaneRaycast(&w, from, to, &hit);
+					const bool isRefHit = RefRaycast(&w, from, to, &refTile);
+					if (isHit != isRefHit ||
+						(isHit && !Vec2iEqual(refTile, Vec2iNew(
+							hit.x / TILE_WIDTH, hit.y / TILE_HEIGHT))))
+					{
+						mismatches++;
+					}
+				}
+				free(bits);
+			}
+		THEN("the hit should match the exact tile crossings")
+			SHOULD_INT_EQUAL(mismatches, 0);
+	SCENARIO_END
+FEATURE_END
+
+CBEHAVE_RUN("Wall collision features are:", TEST_FEATURE(wall_collision))